@@ -0,0 +1,13 @@
+/*****************************************************************************
+* | File        :   hardware/sync.h (host)
+* | Function    :   Interrupt masking is a no-op on the host
+******************************************************************************/
+#ifndef _HOST_HARDWARE_SYNC_H_
+#define _HOST_HARDWARE_SYNC_H_
+
+#include <stdint.h>
+
+static inline uint32_t save_and_disable_interrupts(void) { return 0; }
+static inline void restore_interrupts(uint32_t status) { (void)status; }
+
+#endif
@@ -0,0 +1,52 @@
+/*****************************************************************************
+* | File        :   pico/stdlib.h (host)
+* | Function    :   Pico SDK subset for building the transports on Linux
+* | Info        :
+*----------------
+* | Time comes from CLOCK_MONOTONIC, and stdio from the pseudo terminal
+* | opened by host_pty_open: putchar is redirected to it and
+* | getchar_timeout_us reads from it. Include after <stdio.h>, like the
+* | transports do, so the putchar macro wins.
+******************************************************************************/
+#ifndef _HOST_PICO_STDLIB_H_
+#define _HOST_PICO_STDLIB_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+#define PICO_ERROR_TIMEOUT (-1)
+
+#ifndef MIN
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+uint64_t time_us_64(void);
+static inline uint32_t time_us_32(void) { return (uint32_t)time_us_64(); }
+static inline absolute_time_t make_timeout_time_us(uint64_t us) { return time_us_64() + us; }
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) { return time_us_64() + ms * 1000ull; }
+static inline bool time_reached(absolute_time_t t) { return time_us_64() >= t; }
+static inline void tight_loop_contents(void) {}
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+bool best_effort_wfe_or_timeout(absolute_time_t timeout);
+
+bool stdio_init_all(void);
+int getchar_timeout_us(uint32_t timeout_us);
+int host_putchar(int c);
+#undef putchar
+#define putchar(c) host_putchar(c)
+
+// Pseudo terminal standing in for the USB CDC port
+int host_pty_open(char *peer_name, size_t len);
+int host_pty_fd(void);
+
+#endif
@@ -0,0 +1,12 @@
+/*****************************************************************************
+* | File        :   pico/time.h (host)
+* | Function    :   LV_TICK_CUSTOM_INCLUDE of lv_conf.h for the host LVGL
+******************************************************************************/
+#ifndef _HOST_PICO_TIME_H_
+#define _HOST_PICO_TIME_H_
+
+#include <stdint.h>
+
+uint64_t time_us_64(void);
+
+#endif
@@ -0,0 +1,25 @@
+/*****************************************************************************
+* | File        :   tusb.h (host)
+* | Function    :   TinyUSB CDC device calls on the host pseudo terminal
+* | Info        :
+*----------------
+* | Enough of the tud_cdc API for usb_cdc_transport.c. The write FIFO is
+* | modelled as HOST_CDC_FIFO bytes of room whenever the terminal accepts
+* | data, like the 256 byte FIFO of pico_stdio_usb.
+******************************************************************************/
+#ifndef _HOST_TUSB_H_
+#define _HOST_TUSB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HOST_CDC_FIFO 256
+
+bool tud_cdc_connected(void);
+uint32_t tud_cdc_available(void);
+uint32_t tud_cdc_read(void *buffer, uint32_t bufsize);
+uint32_t tud_cdc_write_available(void);
+uint32_t tud_cdc_write(const void *buffer, uint32_t bufsize);
+uint32_t tud_cdc_write_flush(void);
+
+#endif
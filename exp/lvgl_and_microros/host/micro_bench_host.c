@@ -0,0 +1,124 @@
+/*
+ * Host build of the firmware micro-benchmarks (src/bench.h), built by
+ * host/CMakeLists.txt as micro_bench_host.
+ *
+ * Runs the shared cases of bench_cases.c, with the LVGL ones when LVGL was
+ * found (BENCH_LVGL: a display without a panel is registered), and the CDC
+ * transport against the pseudo terminal of pico_host.c: a sink thread
+ * drains the writes, and the reads find their bytes already sent by the
+ * untimed set up. Results are BENCH JSON lines on stdout:
+ *
+ *   build-host/micro_bench_host | tools/micro_bench.py --baseline base.json
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+
+#include "bench.h"
+#include "bench_cases.h"
+#if BENCH_LVGL
+#include "lvgl.h"
+#endif
+
+#define LVGL_HOR_RES	240
+#define LVGL_VER_RES	280
+
+static int peer_fd = -1;
+static volatile bool sink_stop;
+static uint8_t payload[BENCH_IO_BYTES];
+static uint8_t peer_buf[BENCH_IO_BYTES * 1024];
+
+#if BENCH_LVGL
+static lv_disp_drv_t disp_drv;
+static lv_disp_draw_buf_t disp_buf;
+static lv_color_t buf0[LVGL_HOR_RES * LVGL_VER_RES / 2];
+
+static void flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p){
+	lv_disp_flush_ready(drv);
+}
+
+static void lvgl_init(void){
+	lv_init();
+	lv_disp_draw_buf_init(&disp_buf, buf0, NULL, LVGL_HOR_RES * LVGL_VER_RES / 2);
+	lv_disp_drv_init(&disp_drv);
+	disp_drv.flush_cb = flush_cb;
+	disp_drv.draw_buf = &disp_buf;
+	disp_drv.hor_res = LVGL_HOR_RES;
+	disp_drv.ver_res = LVGL_VER_RES;
+	lv_disp_drv_register(&disp_drv);
+}
+#endif
+
+static void *sink_thread(void *arg){
+	while (!sink_stop){
+		struct pollfd p = { peer_fd, POLLIN, 0 };
+		if (poll(&p, 1, 10) > 0){
+			read(peer_fd, peer_buf, sizeof(peer_buf));
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Untimed: send what the next sample reads
+ */
+static void peer_send(void *arg, uint32_t iterations){
+	size_t len = (size_t)iterations * BENCH_IO_BYTES;
+	size_t sent = 0;
+	while (sent < len){
+		ssize_t n = write(peer_fd, peer_buf, MIN(len - sent, sizeof(peer_buf)));
+		if (n > 0){
+			sent += n;
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	char peer_name[64];
+	if (host_pty_open(peer_name, sizeof(peer_name)) < 0){
+		perror("pseudo terminal");
+		return 1;
+	}
+	peer_fd = open(peer_name, O_RDWR | O_NOCTTY);
+	if (peer_fd < 0){
+		perror(peer_name);
+		return 1;
+	}
+	struct termios tio;
+	tcgetattr(peer_fd, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(peer_fd, TCSANOW, &tio);
+	memset(payload, 'x', sizeof(payload));
+
+#if BENCH_LVGL
+	lvgl_init();
+#endif
+	bench_init();
+	bench_cases_run();
+
+	static const bench_case_t write_cases[] = {
+		{ "cdc_write_64", bench_cdc_write, NULL, payload, 16 },
+	};
+	pthread_t thread;
+	pthread_create(&thread, NULL, sink_thread, NULL);
+	bench_run_all(write_cases, 1);
+	sink_stop = true;
+	pthread_join(thread, NULL);
+
+	// The sink is gone, nothing but the set up writes to the terminal
+	static const bench_case_t read_cases[] = {
+		{ "cdc_read_64", bench_cdc_read, peer_send, NULL, 16 },
+		{ "cdc_read_poll", bench_cdc_read_poll, NULL, NULL, 100 },
+	};
+	bench_run_all(read_cases, 2);
+	bench_done();
+	return 0;
+}
@@ -0,0 +1,138 @@
+/*****************************************************************************
+* | File        :   micro_ros_host.c
+* | Function    :   rcutils and micro_ros_utilities calls used by the message
+* |                 pools, on Linux
+* | Info        :
+*----------------
+* | Backs the headers in shim/. A message type is a size and the offsets of
+* | its strings; static memory is carved from the caller's buffer exactly
+* | as the real micro_ros_utilities does, dynamic memory comes from
+* | conf.allocator or the rcutils default, so allocator counters see it.
+******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include <rcutils/allocator.h>
+#include <micro_ros_utilities/type_utilities.h>
+#include <std_msgs/msg/string.h>
+
+static void *host_allocate(size_t size, void *state)
+{
+    (void)state;
+    return malloc(size);
+}
+
+static void host_deallocate(void *pointer, void *state)
+{
+    (void)state;
+    free(pointer);
+}
+
+static void *host_reallocate(void *pointer, size_t size, void *state)
+{
+    (void)state;
+    return realloc(pointer, size);
+}
+
+static void *host_zero_allocate(size_t count, size_t size, void *state)
+{
+    (void)state;
+    return calloc(count, size);
+}
+
+static rcutils_allocator_t default_allocator = {
+    .allocate = host_allocate,
+    .deallocate = host_deallocate,
+    .reallocate = host_reallocate,
+    .zero_allocate = host_zero_allocate,
+    .state = NULL,
+};
+
+rcutils_allocator_t rcutils_get_default_allocator(void)
+{
+    return default_allocator;
+}
+
+bool rcutils_set_default_allocator(rcutils_allocator_t *allocator)
+{
+    if (allocator == NULL || allocator->allocate == NULL || allocator->deallocate == NULL ||
+        allocator->reallocate == NULL || allocator->zero_allocate == NULL)
+        return false;
+    default_allocator = *allocator;
+    return true;
+}
+
+/* The real default, 20 characters per string */
+const micro_ros_utilities_memory_conf_t micro_ros_utilities_memory_conf_default = {
+    .max_string_capacity = 20,
+    .max_ros2_type_sequence_capacity = 5,
+    .max_basic_type_sequence_capacity = 5,
+};
+
+static const size_t string_offsets[] = { offsetof(std_msgs__msg__String, data) };
+static const rosidl_message_type_support_t string_type = {
+    .size = sizeof(std_msgs__msg__String),
+    .string_offsets = string_offsets,
+    .string_count = 1,
+};
+
+const rosidl_message_type_support_t *rosidl_typesupport_c__get_message_type_support_handle__std_msgs__msg__String(void)
+{
+    return &string_type;
+}
+
+static rosidl_runtime_c__String *string_at(const rosidl_message_type_support_t *type, void *msg, size_t i)
+{
+    return (rosidl_runtime_c__String *)((uint8_t *)msg + type->string_offsets[i]);
+}
+
+size_t micro_ros_utilities_get_static_size(const rosidl_message_type_support_t *type,
+    const micro_ros_utilities_memory_conf_t conf)
+{
+    return type->string_count * conf.max_string_capacity;
+}
+
+bool micro_ros_utilities_create_static_message_memory(const rosidl_message_type_support_t *type,
+    void *msg, const micro_ros_utilities_memory_conf_t conf, uint8_t *buffer, size_t buffer_len)
+{
+    if (micro_ros_utilities_get_static_size(type, conf) > buffer_len)
+        return false;
+    for (size_t i = 0; i < type->string_count; i++)
+    {
+        rosidl_runtime_c__String *s = string_at(type, msg, i);
+        s->data = (char *)buffer + i * conf.max_string_capacity;
+        s->size = 0;
+        s->capacity = conf.max_string_capacity;
+    }
+    return true;
+}
+
+bool micro_ros_utilities_create_message_memory(const rosidl_message_type_support_t *type,
+    void *msg, const micro_ros_utilities_memory_conf_t conf)
+{
+    rcutils_allocator_t allocator = conf.allocator != NULL ? *conf.allocator : rcutils_get_default_allocator();
+    for (size_t i = 0; i < type->string_count; i++)
+    {
+        rosidl_runtime_c__String *s = string_at(type, msg, i);
+        s->data = allocator.allocate(conf.max_string_capacity, allocator.state);
+        if (s->data == NULL)
+            return false;
+        s->size = 0;
+        s->capacity = conf.max_string_capacity;
+    }
+    return true;
+}
+
+bool micro_ros_utilities_destroy_message_memory(const rosidl_message_type_support_t *type,
+    void *msg, const micro_ros_utilities_memory_conf_t conf)
+{
+    rcutils_allocator_t allocator = conf.allocator != NULL ? *conf.allocator : rcutils_get_default_allocator();
+    for (size_t i = 0; i < type->string_count; i++)
+    {
+        rosidl_runtime_c__String *s = string_at(type, msg, i);
+        allocator.deallocate(s->data, allocator.state);
+        s->data = NULL;
+        s->capacity = 0;
+    }
+    return true;
+}
@@ -0,0 +1,121 @@
+/*
+ * Host test of the message pool bookkeeping, built by host/CMakeLists.txt
+ * as msgpool_host_test and run by ctest.
+ *
+ * Sets up like uros_node.c (the pools become the rcutils default, the
+ * message pool is filled, then uros_alloc_seal) and runs take, fill, give
+ * cycles with one message and with the whole pool in flight, checking
+ * the free mask and the stats. There is no micro-ROS library on the host:
+ * micro_ros_host.c stands in for micro_ros_utilities and messages are
+ * copied out instead of published, so this does not cover rcl_publish.
+ * That the real publish
+ * path does not allocate is checked on the target, from the
+ * ros_runtime_allocs telemetry field:
+ *
+ *   tools/telemetry_echo.py --check-allocs 1000
+ *
+ * What it does check of uros_alloc: seal starts the runtime count, and
+ * micro_ros_utilities_create_message_memory after seal is counted.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <std_msgs/msg/string.h>
+
+#include "uros_alloc.h"
+#include "uros_msgpool.h"
+
+#define TEST_CYCLES		10000
+#define TEST_POOL_MSGS	4
+#define TEST_CAPACITY	48
+
+UROS_MSGPOOL_DEFINE(test_msgpool, std_msgs__msg__String, TEST_POOL_MSGS, TEST_POOL_MSGS * TEST_CAPACITY);
+
+static uint8_t stream[TEST_CAPACITY + 4];
+static int failures;
+
+#define CHECK(cond) do { \
+	if (!(cond)){ \
+		fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+		failures++; \
+	} \
+} while (0)
+
+static size_t copy_out(const std_msgs__msg__String *msg){
+	uint32_t len = (uint32_t)msg->data.size;
+	memcpy(stream, &len, sizeof(len));
+	memcpy(stream + sizeof(len), msg->data.data, msg->data.size);
+	return sizeof(len) + msg->data.size;
+}
+
+static uint32_t runtime_allocs(void){
+	uros_alloc_stats_t stats;
+	uros_alloc_get_stats(&stats);
+	return stats.runtime_allocs;
+}
+
+int main(void){
+	CHECK(uros_alloc_set_default());
+
+	micro_ros_utilities_memory_conf_t conf = micro_ros_utilities_memory_conf_default;
+	conf.max_string_capacity = TEST_CAPACITY;
+	CHECK(uros_msgpool_init(&test_msgpool,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String), &conf));
+
+	uros_alloc_seal();
+
+	// One message in flight, like uros_boot and uros_params
+	for (uint32_t i = 0; i < TEST_CYCLES; i++){
+		std_msgs__msg__String *msg = uros_msgpool_take(&test_msgpool);
+		CHECK(msg != NULL);
+		if (msg == NULL){
+			break;
+		}
+		int n = snprintf(msg->data.data, msg->data.capacity, "cycle %lu", (unsigned long)i);
+		msg->data.size = n < (int)msg->data.capacity ? (size_t)n : msg->data.capacity - 1;
+		CHECK(copy_out(msg) == sizeof(uint32_t) + msg->data.size);
+		uros_msgpool_give(&test_msgpool, msg);
+	}
+
+	// The whole pool in flight, like a reliable publisher waiting on acks
+	std_msgs__msg__String *held[TEST_POOL_MSGS];
+	for (uint32_t i = 0; i < TEST_CYCLES / TEST_POOL_MSGS; i++){
+		for (int k = 0; k < TEST_POOL_MSGS; k++){
+			held[k] = uros_msgpool_take(&test_msgpool);
+			CHECK(held[k] != NULL);
+		}
+		CHECK(uros_msgpool_take(&test_msgpool) == NULL);
+		for (int k = 0; k < TEST_POOL_MSGS; k++){
+			if (held[k] != NULL){
+				held[k]->data.size = 0;
+				copy_out(held[k]);
+			}
+			uros_msgpool_give(&test_msgpool, held[k]);
+		}
+	}
+
+	CHECK(runtime_allocs() == 0);
+
+	uros_msgpool_stats_t pool;
+	uros_msgpool_get_stats(&test_msgpool, &pool);
+	CHECK(pool.in_use == 0);
+	CHECK(pool.in_use_peak == TEST_POOL_MSGS);
+	CHECK(pool.takes == pool.gives + pool.exhausted);
+	CHECK(pool.exhausted == TEST_CYCLES / TEST_POOL_MSGS);
+
+	// A message created the dynamic way after seal is counted
+	std_msgs__msg__String dynamic;
+	memset(&dynamic, 0, sizeof(dynamic));
+	CHECK(micro_ros_utilities_create_message_memory(
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String), &dynamic, conf));
+	CHECK(runtime_allocs() == 1);
+	micro_ros_utilities_destroy_message_memory(
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String), &dynamic, conf);
+
+	if (failures != 0){
+		fprintf(stderr, "msgpool_host_test: %d checks failed\n", failures);
+		return 1;
+	}
+	printf("msgpool_host_test: %d pool cycles\n", TEST_CYCLES * 2);
+	return 0;
+}
@@ -0,0 +1,171 @@
+/*****************************************************************************
+* | File        :   pico_host.c
+* | Function    :   Pico SDK and TinyUSB calls used by the transports, on Linux
+* | Info        :
+*----------------
+* | The transports see one pseudo terminal: its master side replaces the
+* | USB CDC port, the slave side is handed to the peer (a scripted thread
+* | or micro-ros-agent). putchar costs one write() per byte, which keeps
+* | the per byte overhead of the stdio transport visible.
+* |
+* | pico_uart_transport.c defines clock_gettime and usleep for XRCE, which
+* | replace the libc ones in this process; time here therefore comes from
+* | the raw system call and sleeping from nanosleep.
+******************************************************************************/
+#define _GNU_SOURCE
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "tusb.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int pty_fd = -1;
+static bool write_stalled; // The last CDC write filled the FIFO, wait for room
+
+uint64_t time_us_64(void)
+{
+    struct timespec ts;
+    syscall(SYS_clock_gettime, CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void sleep_us(uint64_t us)
+{
+    struct timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+}
+
+void sleep_ms(uint32_t ms)
+{
+    sleep_us(ms * 1000ull);
+}
+
+/********************************************************************************
+function:	Open the pseudo terminal, raw, and return its peer side name
+parameter:
+return:     Master side descriptor, -1 on error
+********************************************************************************/
+int host_pty_open(char *peer_name, size_t len)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+        return -1;
+    if (ptsname_r(fd, peer_name, len) != 0)
+        return -1;
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    // Writes must not block when the peer falls behind, like the USB FIFO
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    pty_fd = fd;
+    return fd;
+}
+
+int host_pty_fd(void)
+{
+    return pty_fd;
+}
+
+bool stdio_init_all(void)
+{
+    return pty_fd >= 0;
+}
+
+static bool wait_fd(short events, uint32_t timeout_us)
+{
+    struct pollfd p = { pty_fd, events, 0 };
+    struct timespec ts = { (time_t)(timeout_us / 1000000), (long)(timeout_us % 1000000) * 1000 };
+    return ppoll(&p, 1, &ts, NULL) > 0 && (p.revents & events);
+}
+
+int host_putchar(int c)
+{
+    uint8_t b = (uint8_t)c;
+    while (write(pty_fd, &b, 1) != 1)
+    {
+        if (errno != EAGAIN && errno != EINTR)
+            return EOF;
+        wait_fd(POLLOUT, 10000);
+    }
+    return b;
+}
+
+int getchar_timeout_us(uint32_t timeout_us)
+{
+    uint8_t b;
+    if (!wait_fd(POLLIN, timeout_us))
+        return PICO_ERROR_TIMEOUT;
+    if (read(pty_fd, &b, 1) != 1)
+        return PICO_ERROR_TIMEOUT;
+    return b;
+}
+
+/********************************************************************************
+function:	Stand-in for __wfe: sleep until the terminal has data (or room,
+            once the CDC FIFO filled) or at most a millisecond, the same
+            upper bound the stdio_usb task tick gives
+parameter:
+return:     true once the timeout has been reached
+********************************************************************************/
+bool best_effort_wfe_or_timeout(absolute_time_t timeout)
+{
+    uint64_t now = time_us_64();
+    if (now >= timeout)
+        return true;
+    uint64_t wait_us = MIN(timeout - now, 1000u);
+    wait_fd(write_stalled ? POLLIN | POLLOUT : POLLIN, (uint32_t)wait_us);
+    return time_reached(timeout);
+}
+
+bool tud_cdc_connected(void)
+{
+    return pty_fd >= 0;
+}
+
+uint32_t tud_cdc_available(void)
+{
+    int n = 0;
+    if (ioctl(pty_fd, FIONREAD, &n) != 0)
+        return 0;
+    return (uint32_t)n;
+}
+
+uint32_t tud_cdc_read(void *buffer, uint32_t bufsize)
+{
+    ssize_t n = read(pty_fd, buffer, bufsize);
+    return n > 0 ? (uint32_t)n : 0;
+}
+
+uint32_t tud_cdc_write_available(void)
+{
+    write_stalled = !wait_fd(POLLOUT, 0);
+    return write_stalled ? 0 : HOST_CDC_FIFO;
+}
+
+uint32_t tud_cdc_write(const void *buffer, uint32_t bufsize)
+{
+    ssize_t n = write(pty_fd, buffer, bufsize);
+    // A full FIFO drains straight into the terminal, so room is back as
+    // soon as the terminal takes more
+    write_stalled = n < (ssize_t)bufsize || bufsize >= HOST_CDC_FIFO;
+    return n > 0 ? (uint32_t)n : 0;
+}
+
+uint32_t tud_cdc_write_flush(void)
+{
+    return 0;
+}
@@ -0,0 +1,36 @@
+/*
+ * Stand-in for micro_ros_utilities when the host build has no micro-ROS
+ * library, see micro_ros_host.c. Only string capacities are honoured: the
+ * host message types have no sequences.
+ */
+#ifndef _HOST_MICRO_ROS_UTILITIES_TYPE_UTILITIES_H_
+#define _HOST_MICRO_ROS_UTILITIES_TYPE_UTILITIES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <rcutils/allocator.h>
+#include <rosidl_runtime_c/message_type_support_struct.h>
+
+typedef struct micro_ros_utilities_memory_conf_t {
+	size_t max_string_capacity;
+	size_t max_ros2_type_sequence_capacity;
+	size_t max_basic_type_sequence_capacity;
+	const void *rules;
+	size_t n_rules;
+	const rcutils_allocator_t *allocator;
+} micro_ros_utilities_memory_conf_t;
+
+extern const micro_ros_utilities_memory_conf_t micro_ros_utilities_memory_conf_default;
+
+size_t micro_ros_utilities_get_static_size(const rosidl_message_type_support_t *type_support,
+	const micro_ros_utilities_memory_conf_t conf);
+bool micro_ros_utilities_create_static_message_memory(const rosidl_message_type_support_t *type_support,
+	void *ros_msg, const micro_ros_utilities_memory_conf_t conf, uint8_t *buffer, size_t buffer_len);
+bool micro_ros_utilities_create_message_memory(const rosidl_message_type_support_t *type_support,
+	void *ros_msg, const micro_ros_utilities_memory_conf_t conf);
+bool micro_ros_utilities_destroy_message_memory(const rosidl_message_type_support_t *type_support,
+	void *ros_msg, const micro_ros_utilities_memory_conf_t conf);
+
+#endif
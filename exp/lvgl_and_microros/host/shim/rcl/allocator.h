@@ -0,0 +1,11 @@
+/*
+ * Stand-in for rcl/allocator.h, see rcutils/allocator.h
+ */
+#ifndef _HOST_RCL_ALLOCATOR_H_
+#define _HOST_RCL_ALLOCATOR_H_
+
+#include <rcutils/allocator.h>
+
+typedef rcutils_allocator_t rcl_allocator_t;
+
+#endif
@@ -0,0 +1,22 @@
+/*
+ * Stand-in for the rcutils allocator when the host build has no micro-ROS
+ * library, see micro_ros_host.c. Same members as the real struct.
+ */
+#ifndef _HOST_RCUTILS_ALLOCATOR_H_
+#define _HOST_RCUTILS_ALLOCATOR_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct rcutils_allocator_s {
+	void *(*allocate)(size_t size, void *state);
+	void (*deallocate)(void *pointer, void *state);
+	void *(*reallocate)(void *pointer, size_t size, void *state);
+	void *(*zero_allocate)(size_t number_of_elements, size_t size_of_element, void *state);
+	void *state;
+} rcutils_allocator_t;
+
+rcutils_allocator_t rcutils_get_default_allocator(void);
+bool rcutils_set_default_allocator(rcutils_allocator_t *allocator);
+
+#endif
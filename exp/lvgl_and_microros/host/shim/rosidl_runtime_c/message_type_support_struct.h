@@ -0,0 +1,26 @@
+/*
+ * Stand-in for the rosidl type support handle. On the host a message type
+ * is described by its size and the offsets of its string fields, which is
+ * all micro_ros_host.c needs to give a message its memory.
+ */
+#ifndef _HOST_ROSIDL_MESSAGE_TYPE_SUPPORT_STRUCT_H_
+#define _HOST_ROSIDL_MESSAGE_TYPE_SUPPORT_STRUCT_H_
+
+#include <stddef.h>
+
+typedef struct rosidl_message_type_support_t {
+	size_t size;
+	const size_t *string_offsets;
+	size_t string_count;
+} rosidl_message_type_support_t;
+
+typedef struct {
+	char *data;
+	size_t size;
+	size_t capacity;
+} rosidl_runtime_c__String;
+
+#define ROSIDL_GET_MSG_TYPE_SUPPORT(PkgName, MsgSubfolder, MsgName) \
+	rosidl_typesupport_c__get_message_type_support_handle__##PkgName##__##MsgSubfolder##__##MsgName()
+
+#endif
@@ -0,0 +1,15 @@
+/*
+ * Stand-in for std_msgs/msg/String, see micro_ros_host.c
+ */
+#ifndef _HOST_STD_MSGS_MSG_STRING_H_
+#define _HOST_STD_MSGS_MSG_STRING_H_
+
+#include <rosidl_runtime_c/message_type_support_struct.h>
+
+typedef struct std_msgs__msg__String {
+	rosidl_runtime_c__String data;
+} std_msgs__msg__String;
+
+const rosidl_message_type_support_t *rosidl_typesupport_c__get_message_type_support_handle__std_msgs__msg__String(void);
+
+#endif
@@ -0,0 +1,14 @@
+/*
+ * Stand-in for the Micro XRCE-DDS client header when the host build has no
+ * client library (HOST_XRCE off). The transports only pass the pointer on.
+ */
+#ifndef _HOST_UXR_CUSTOM_TRANSPORT_H_
+#define _HOST_UXR_CUSTOM_TRANSPORT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+struct uxrCustomTransport;
+
+#endif
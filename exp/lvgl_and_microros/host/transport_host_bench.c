@@ -0,0 +1,357 @@
+/*
+ * Host benchmark of the micro-ROS transports, built by host/CMakeLists.txt.
+ *
+ * The transports run unchanged against a Linux pseudo terminal (see
+ * pico_host.c). On the other end is either
+ *   --peer echo   a scripted peer thread: echoes for the round trip test
+ *                 and counts bytes for the throughput test, or
+ *   --peer agent  micro-ros-agent on the printed terminal, with a real XRCE
+ *                 session (HOST_XRCE builds only): round trip is a reliable
+ *                 publish until acknowledged, throughput best effort
+ *                 std_msgs/String publishes on rt/transport_bench.
+ *
+ * For every message size it prints round trip p50/p99/max and sustained
+ * publish throughput, for --transport stdio (pico_uart_transport.c) or
+ * cdc (usb_cdc_transport.c).
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+
+#include "pico_uart_transport.h"
+#include "usb_cdc_transport.h"
+
+#if HOST_XRCE
+#include <uxr/client/client.h>
+#include <ucdr/microcdr.h>
+#endif
+
+#define BENCH_MAX_SIZE		4096
+#define BENCH_ROUND_TRIPS	200
+#define BENCH_TIMEOUT_MS	1000
+
+typedef size_t (*bench_write_t)(struct uxrCustomTransport*, const uint8_t*, size_t, uint8_t*);
+typedef size_t (*bench_read_t)(struct uxrCustomTransport*, uint8_t*, size_t, int, uint8_t*);
+
+typedef enum { PEER_IDLE = 0, PEER_ECHO, PEER_SINK, PEER_STOP } peer_mode_t;
+
+static bench_write_t wr;
+static bench_read_t rd;
+static uint8_t payload[BENCH_MAX_SIZE];
+static uint8_t reply[BENCH_MAX_SIZE];
+
+static int peer_fd = -1;
+static volatile peer_mode_t peer_mode;
+static volatile uint64_t peer_bytes;
+
+
+static void *peer_thread(void *arg){
+	static uint8_t buf[8192];
+	while (peer_mode != PEER_STOP){
+		struct pollfd p = { peer_fd, POLLIN, 0 };
+		if (poll(&p, 1, 10) <= 0){
+			continue;
+		}
+		ssize_t n = read(peer_fd, buf, sizeof(buf));
+		if (n <= 0){
+			continue;
+		}
+		// Count before echoing, so the count is settled once the echo arrives
+		__atomic_add_fetch(&peer_bytes, (uint64_t)n, __ATOMIC_RELAXED);
+		if (peer_mode == PEER_ECHO){
+			for (ssize_t sent = 0; sent < n; ){
+				ssize_t m = write(peer_fd, buf + sent, n - sent);
+				if (m > 0){
+					sent += m;
+				}
+			}
+		}
+	}
+	return NULL;
+}
+
+static size_t read_all(uint8_t *buf, size_t len){
+	size_t got = 0;
+	while (got < len){
+		uint8_t err = 0;
+		size_t n = rd(NULL, buf + got, len - got, BENCH_TIMEOUT_MS, &err);
+		got += n;
+		if (n == 0 && err){
+			break;
+		}
+	}
+	return got;
+}
+
+static size_t write_all(const uint8_t *buf, size_t len){
+	size_t sent = 0;
+	while (sent < len){
+		uint8_t err = 0;
+		size_t n = wr(NULL, buf + sent, len - sent, &err);
+		sent += n;
+		if (n == 0 && err){
+			break;
+		}
+	}
+	return sent;
+}
+
+static int cmp_u32(const void *a, const void *b){
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+static void print_row(size_t size, uint32_t *rtt, int n, uint64_t bytes, uint64_t msgs, double seconds){
+	qsort(rtt, n, sizeof(uint32_t), cmp_u32);
+	printf("%6zu %8u us %8u us %8u us %10.1f KB/s %9.0f msg/s\n",
+		size, rtt[n / 2], rtt[(n * 99) / 100 - (n >= 100)], rtt[n - 1],
+		bytes / seconds / 1024, msgs / seconds);
+}
+
+static void bench_echo(size_t size, double seconds){
+	static uint32_t rtt[BENCH_ROUND_TRIPS];
+	int n = 0;
+
+	peer_mode = PEER_ECHO;
+	for (int i = 0; i < BENCH_ROUND_TRIPS; i++){
+		uint64_t start = time_us_64();
+		if (write_all(payload, size) != size || read_all(reply, size) != size){
+			break;
+		}
+		rtt[n++] = (uint32_t)(time_us_64() - start);
+		if (memcmp(payload, reply, size) != 0){
+			fprintf(stderr, "echo mismatch at %zu bytes\n", size);
+			exit(1);
+		}
+	}
+	if (n == 0){
+		fprintf(stderr, "no echo at %zu bytes\n", size);
+		exit(1);
+	}
+
+	// Throughput as seen by the peer, after the last byte has arrived
+	peer_mode = PEER_SINK;
+	__atomic_store_n(&peer_bytes, 0, __ATOMIC_RELAXED);
+	uint64_t start = time_us_64();
+	uint64_t end = start + (uint64_t)(seconds * 1e6);
+	uint64_t sent = 0, msgs = 0;
+	while (time_us_64() < end){
+		sent += write_all(payload, size);
+		msgs++;
+	}
+	while (__atomic_load_n(&peer_bytes, __ATOMIC_RELAXED) < sent &&
+		time_us_64() - end < BENCH_TIMEOUT_MS * 1000ull){
+		sleep_ms(1);
+	}
+	double elapsed = (time_us_64() - start) / 1e6;
+	print_row(size, rtt, n, __atomic_load_n(&peer_bytes, __ATOMIC_RELAXED), msgs, elapsed);
+	peer_mode = PEER_IDLE;
+}
+
+#if HOST_XRCE
+#define XRCE_MTU		512
+#define XRCE_HISTORY	8
+
+static uxrSession session;
+static uxrCustomTransport transport;
+static uxrStreamId reliable_out;
+static uxrStreamId best_effort_out;
+static uxrObjectId datawriter_id;
+static uint8_t reliable_out_buf[XRCE_MTU * XRCE_HISTORY];
+static uint8_t best_effort_out_buf[XRCE_MTU];
+static uint8_t reliable_in_buf[XRCE_MTU * XRCE_HISTORY];
+
+static bool xrce_open(struct uxrCustomTransport *t){
+	return true;
+}
+
+static bool xrce_close(struct uxrCustomTransport *t){
+	return true;
+}
+
+static bool xrce_session(void){
+	uxr_set_custom_transport_callbacks(&transport, true, xrce_open, xrce_close,
+		(write_custom_func)wr, (read_custom_func)rd);
+	if (!uxr_init_custom_transport(&transport, NULL)){
+		return false;
+	}
+	uxr_init_session(&session, &transport.comm, 0x5049434f);
+	if (!uxr_create_session(&session)){
+		return false;
+	}
+	reliable_out = uxr_create_output_reliable_stream(&session, reliable_out_buf, sizeof(reliable_out_buf), XRCE_HISTORY);
+	best_effort_out = uxr_create_output_best_effort_stream(&session, best_effort_out_buf, sizeof(best_effort_out_buf));
+	uxr_create_input_reliable_stream(&session, reliable_in_buf, sizeof(reliable_in_buf), XRCE_HISTORY);
+
+	uxrObjectId participant_id = uxr_object_id(0x01, UXR_PARTICIPANT_ID);
+	uxrObjectId topic_id = uxr_object_id(0x01, UXR_TOPIC_ID);
+	uxrObjectId publisher_id = uxr_object_id(0x01, UXR_PUBLISHER_ID);
+	datawriter_id = uxr_object_id(0x01, UXR_DATAWRITER_ID);
+	const char *participant_xml = "<dds><participant><rtps><name>transport_bench</name></rtps></participant></dds>";
+	const char *topic_xml = "<dds><topic><name>rt/transport_bench</name><dataType>std_msgs::msg::dds_::String_</dataType></topic></dds>";
+	const char *datawriter_xml = "<dds><data_writer><topic><kind>NO_KEY</kind><name>rt/transport_bench</name>"
+		"<dataType>std_msgs::msg::dds_::String_</dataType></topic></data_writer></dds>";
+
+	uint16_t requests[4] = {
+		uxr_buffer_create_participant_xml(&session, reliable_out, participant_id, 0, participant_xml, UXR_REPLACE),
+		uxr_buffer_create_topic_xml(&session, reliable_out, topic_id, participant_id, topic_xml, UXR_REPLACE),
+		uxr_buffer_create_publisher_xml(&session, reliable_out, publisher_id, participant_id, "", UXR_REPLACE),
+		uxr_buffer_create_datawriter_xml(&session, reliable_out, datawriter_id, publisher_id, datawriter_xml, UXR_REPLACE),
+	};
+	uint8_t status[4];
+	return uxr_run_session_until_all_status(&session, BENCH_TIMEOUT_MS, requests, status, 4);
+}
+
+static bool xrce_publish(uxrStreamId stream, size_t size){
+	// std_msgs/String: length, characters, terminating NUL
+	ucdrBuffer ub;
+	payload[size - 1] = '\0';
+	uint32_t topic_size = 4 + (uint32_t)size;
+	if (uxr_prepare_output_stream(&session, stream, datawriter_id, &ub, topic_size) == 0){
+		return false;
+	}
+	ucdr_serialize_string(&ub, (const char *)payload);
+	payload[size - 1] = 'x';
+	return true;
+}
+
+static void bench_agent(size_t size, double seconds){
+	static uint32_t rtt[BENCH_ROUND_TRIPS];
+	int n = 0;
+
+	// Round trip: reliable publish until the agent acknowledges it
+	for (int i = 0; i < BENCH_ROUND_TRIPS; i++){
+		uint64_t start = time_us_64();
+		if (!xrce_publish(reliable_out, size) ||
+			!uxr_run_session_until_confirm_delivery(&session, BENCH_TIMEOUT_MS)){
+			break;
+		}
+		rtt[n++] = (uint32_t)(time_us_64() - start);
+	}
+	if (n == 0){
+		fprintf(stderr, "no acknowledgement at %zu bytes\n", size);
+		exit(1);
+	}
+
+	// Throughput: best effort publishes, flushed one by one like rmw does
+	uint64_t start = time_us_64();
+	uint64_t end = start + (uint64_t)(seconds * 1e6);
+	uint64_t msgs = 0;
+	while (time_us_64() < end){
+		if (xrce_publish(best_effort_out, size)){
+			uxr_flash_output_streams(&session);
+			msgs++;
+		}
+	}
+	double elapsed = (time_us_64() - start) / 1e6;
+	print_row(size, rtt, n, msgs * size, msgs, elapsed);
+}
+#endif
+
+static void usage(const char *name){
+	fprintf(stderr, "usage: %s [--transport stdio|cdc] [--peer echo|agent] "
+		"[--sizes 16,64,256,1024] [--seconds 2]\n", name);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	const char *transport_name = "stdio";
+	const char *peer = "echo";
+	char sizes_arg[128] = "16,64,256,1024";
+	double seconds = 2;
+
+	for (int i = 1; i < argc; i++){
+		if (i + 1 >= argc){
+			usage(argv[0]);
+		}
+		if (strcmp(argv[i], "--transport") == 0){
+			transport_name = argv[++i];
+		} else if (strcmp(argv[i], "--peer") == 0){
+			peer = argv[++i];
+		} else if (strcmp(argv[i], "--sizes") == 0){
+			snprintf(sizes_arg, sizeof(sizes_arg), "%s", argv[++i]);
+		} else if (strcmp(argv[i], "--seconds") == 0){
+			seconds = atof(argv[++i]);
+		} else {
+			usage(argv[0]);
+		}
+	}
+
+	if (strcmp(transport_name, "stdio") == 0){
+		wr = (bench_write_t)pico_serial_transport_write;
+		rd = pico_serial_transport_read;
+	} else if (strcmp(transport_name, "cdc") == 0){
+		wr = usb_cdc_transport_write;
+		rd = usb_cdc_transport_read;
+	} else {
+		usage(argv[0]);
+	}
+
+	char peer_name[64];
+	if (host_pty_open(peer_name, sizeof(peer_name)) < 0){
+		perror("pseudo terminal");
+		return 1;
+	}
+	for (size_t i = 0; i < sizeof(payload); i++){
+		payload[i] = 'a' + i % 26;
+	}
+
+	pthread_t thread;
+	bool agent = strcmp(peer, "agent") == 0;
+	if (agent){
+#if HOST_XRCE
+		printf("start the agent: micro-ros-agent serial --dev %s\n", peer_name);
+		fflush(stdout);
+		while (!xrce_session()){
+			sleep_ms(500);
+		}
+#else
+		fprintf(stderr, "--peer agent needs a HOST_XRCE build\n");
+		return 2;
+#endif
+	} else if (strcmp(peer, "echo") == 0){
+		peer_fd = open(peer_name, O_RDWR | O_NOCTTY);
+		if (peer_fd < 0){
+			perror(peer_name);
+			return 1;
+		}
+		struct termios tio;
+		tcgetattr(peer_fd, &tio);
+		cfmakeraw(&tio);
+		tcsetattr(peer_fd, TCSANOW, &tio);
+		pthread_create(&thread, NULL, peer_thread, NULL);
+	} else {
+		usage(argv[0]);
+	}
+
+	printf("transport %s, peer %s\n", transport_name, peer);
+	printf("%6s %11s %11s %11s %15s %13s\n", "size", "rtt p50", "rtt p99", "rtt max", "throughput", "rate");
+	for (char *tok = strtok(sizes_arg, ","); tok != NULL; tok = strtok(NULL, ",")){
+		size_t size = strtoul(tok, NULL, 0);
+		if (size < 2 || size > BENCH_MAX_SIZE){
+			fprintf(stderr, "size %zu out of range\n", size);
+			continue;
+		}
+#if HOST_XRCE
+		if (agent){
+			bench_agent(size, seconds);
+			continue;
+		}
+#endif
+		bench_echo(size, seconds);
+	}
+
+	if (!agent){
+		peer_mode = PEER_STOP;
+		pthread_join(thread, NULL);
+	}
+	return 0;
+}
@@ -0,0 +1,480 @@
+/*****************************************************************************
+* | File        :   lv_heap.c
+* | Function    :   LVGL heap (LV_MEM_CUSTOM) with slab pools in front of TLSF
+* | Info        :
+*----------------
+* | Slab blocks have no header; the owning class is found from the address.
+* | TLSF blocks carry the physical predecessor and the payload size, with
+* | bit 0 of the size marking a free block. Free blocks are kept in
+* | FL_COUNT x SL_COUNT segregated lists with a bitmap per level, so finding
+* | a fit is two find-first-set operations. Neighbouring free blocks are
+* | always merged and a zero sized used block terminates the region.
+******************************************************************************/
+#include "lv_heap.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+/**********************
+ * Slab pools
+ **********************/
+typedef struct slab_block {
+    struct slab_block *next;
+} slab_block_t;
+
+typedef struct {
+    uint8_t *start;
+    uint8_t *end;
+    slab_block_t *free;
+} slab_t;
+
+static const uint16_t slab_size[LV_HEAP_SLAB_CLASSES] = { 16, 32, 64 };
+static const uint16_t slab_blocks[LV_HEAP_SLAB_CLASSES] = {
+    LV_HEAP_SLAB_16, LV_HEAP_SLAB_32, LV_HEAP_SLAB_64
+};
+
+/**********************
+ * TLSF
+ **********************/
+#define ALIGN_LOG2  3
+#define ALIGN       (1u << ALIGN_LOG2)
+#define SL_LOG2     4
+#define SL_COUNT    (1u << SL_LOG2)
+#define FL_SHIFT    (SL_LOG2 + ALIGN_LOG2)
+#define FL_MAX      16                      // Blocks up to 64 KB
+#define FL_COUNT    (FL_MAX - FL_SHIFT + 1)
+#define SMALL_BLOCK (1u << FL_SHIFT)
+
+#define BLOCK_FREE  1u
+
+typedef struct tlsf_block {
+    struct tlsf_block *prev_phys;
+    uint32_t size;                 // Payload bytes | BLOCK_FREE
+    /* Payload starts here; the free list links only exist in free blocks */
+    struct tlsf_block *next_free;
+    struct tlsf_block *prev_free;
+} tlsf_block_t;
+
+#define BLOCK_HEADER ((uint32_t)offsetof(tlsf_block_t, next_free))
+#define BLOCK_MIN    ((uint32_t)((sizeof(tlsf_block_t) - BLOCK_HEADER + ALIGN - 1) & ~(ALIGN - 1)))
+#define BLOCK_MAX    ((1u << FL_MAX) - 1)
+
+static uint64_t heap_mem[LV_HEAP_SIZE / sizeof(uint64_t)];
+
+static slab_t slabs[LV_HEAP_SLAB_CLASSES];
+static tlsf_block_t *free_lists[FL_COUNT][SL_COUNT];
+static uint32_t fl_bitmap;
+static uint32_t sl_bitmap[FL_COUNT];
+static uint8_t *tlsf_start;
+static uint8_t *tlsf_end;
+
+static lv_heap_stats_t stats;
+static lv_heap_sample_t history[LV_HEAP_HISTORY];
+static uint32_t history_count;
+static bool initialised;
+
+static inline int fls32(uint32_t x)
+{
+    return x ? 31 - __builtin_clz(x) : -1;
+}
+
+static inline int ffs32(uint32_t x)
+{
+    return x ? __builtin_ctz(x) : -1;
+}
+
+static inline uint32_t block_size(const tlsf_block_t *b)
+{
+    return b->size & ~BLOCK_FREE;
+}
+
+static inline bool block_is_free(const tlsf_block_t *b)
+{
+    return (b->size & BLOCK_FREE) != 0;
+}
+
+static inline void *block_payload(tlsf_block_t *b)
+{
+    return (uint8_t *)b + BLOCK_HEADER;
+}
+
+static inline tlsf_block_t *block_from_payload(void *ptr)
+{
+    return (tlsf_block_t *)((uint8_t *)ptr - BLOCK_HEADER);
+}
+
+static inline tlsf_block_t *block_next(tlsf_block_t *b)
+{
+    return (tlsf_block_t *)((uint8_t *)block_payload(b) + block_size(b));
+}
+
+static void mapping_insert(uint32_t size, int *fl, int *sl)
+{
+    if (size < SMALL_BLOCK)
+    {
+        *fl = 0;
+        *sl = size / (SMALL_BLOCK / SL_COUNT);
+    }
+    else
+    {
+        int f = fls32(size);
+        *sl = (size >> (f - SL_LOG2)) ^ SL_COUNT;
+        *fl = f - (FL_SHIFT - 1);
+    }
+}
+
+/* Round up to the next list so any block found there is large enough */
+static void mapping_search(uint32_t size, int *fl, int *sl)
+{
+    if (size >= SMALL_BLOCK)
+        size += (1u << (fls32(size) - SL_LOG2)) - 1;
+    mapping_insert(size, fl, sl);
+}
+
+static void insert_free(tlsf_block_t *b)
+{
+    int fl, sl;
+    mapping_insert(block_size(b), &fl, &sl);
+    tlsf_block_t *head = free_lists[fl][sl];
+    b->size |= BLOCK_FREE;
+    b->prev_free = NULL;
+    b->next_free = head;
+    if (head != NULL)
+        head->prev_free = b;
+    free_lists[fl][sl] = b;
+    fl_bitmap |= 1u << fl;
+    sl_bitmap[fl] |= 1u << sl;
+    stats.tlsf_free += block_size(b);
+}
+
+static void remove_free(tlsf_block_t *b)
+{
+    int fl, sl;
+    mapping_insert(block_size(b), &fl, &sl);
+    if (b->prev_free != NULL)
+        b->prev_free->next_free = b->next_free;
+    else
+        free_lists[fl][sl] = b->next_free;
+    if (b->next_free != NULL)
+        b->next_free->prev_free = b->prev_free;
+    if (free_lists[fl][sl] == NULL)
+    {
+        sl_bitmap[fl] &= ~(1u << sl);
+        if (sl_bitmap[fl] == 0)
+            fl_bitmap &= ~(1u << fl);
+    }
+    b->size &= ~BLOCK_FREE;
+    stats.tlsf_free -= block_size(b);
+}
+
+static tlsf_block_t *find_suitable(uint32_t size)
+{
+    int fl, sl;
+    mapping_search(size, &fl, &sl);
+    if (fl >= (int)FL_COUNT)
+        return NULL;
+
+    uint32_t sl_map = sl_bitmap[fl] & (~0u << sl);
+    if (sl_map == 0)
+    {
+        uint32_t fl_map = fl_bitmap & (~0u << (fl + 1));
+        if (fl_map == 0)
+            return NULL;
+        fl = ffs32(fl_map);
+        sl_map = sl_bitmap[fl];
+    }
+    return free_lists[fl][ffs32(sl_map)];
+}
+
+/* Merge b with its free physical neighbours, b must not be in a list */
+static tlsf_block_t *merge_free(tlsf_block_t *b)
+{
+    tlsf_block_t *prev = b->prev_phys;
+    if (prev != NULL && block_is_free(prev))
+    {
+        remove_free(prev);
+        prev->size += BLOCK_HEADER + block_size(b);
+        b = prev;
+        block_next(b)->prev_phys = b;
+    }
+    tlsf_block_t *next = block_next(b);
+    if (block_is_free(next))
+    {
+        remove_free(next);
+        b->size += BLOCK_HEADER + block_size(next);
+        block_next(b)->prev_phys = b;
+    }
+    return b;
+}
+
+/* Give the tail of a used block beyond size back to the free lists */
+static void split_tail(tlsf_block_t *b, uint32_t size)
+{
+    uint32_t bs = block_size(b);
+    if (bs < size + BLOCK_HEADER + BLOCK_MIN)
+        return;
+    tlsf_block_t *rest = (tlsf_block_t *)((uint8_t *)block_payload(b) + size);
+    rest->prev_phys = b;
+    rest->size = bs - size - BLOCK_HEADER;
+    b->size = size;
+    block_next(rest)->prev_phys = rest;
+    insert_free(merge_free(rest));
+}
+
+static uint32_t adjust_size(size_t size)
+{
+    if (size > BLOCK_MAX)
+        return 0;
+    uint32_t adj = ((uint32_t)size + ALIGN - 1) & ~(ALIGN - 1);
+    return adj < BLOCK_MIN ? BLOCK_MIN : adj;
+}
+
+static void *tlsf_alloc(uint32_t adj)
+{
+    tlsf_block_t *b = find_suitable(adj);
+    if (b == NULL)
+        return NULL;
+    remove_free(b);
+    split_tail(b, adj);
+    return block_payload(b);
+}
+
+static void tlsf_free(void *ptr)
+{
+    tlsf_block_t *b = block_from_payload(ptr);
+    insert_free(merge_free(b));
+}
+
+static void account(int32_t bytes)
+{
+    stats.live_bytes += bytes;
+    if (stats.live_bytes > stats.peak_bytes)
+        stats.peak_bytes = stats.live_bytes;
+}
+
+static int slab_class(const void *ptr)
+{
+    const uint8_t *p = ptr;
+    for (int c = 0; c < LV_HEAP_SLAB_CLASSES; c++)
+    {
+        if (p >= slabs[c].start && p < slabs[c].end)
+            return c;
+    }
+    return -1;
+}
+
+/********************************************************************************
+function:	Carve the slabs and the TLSF region out of the heap. Called on the
+            first allocation, LVGL does not initialise a custom heap.
+parameter:
+********************************************************************************/
+void lv_heap_init(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    memset(free_lists, 0, sizeof(free_lists));
+    memset(sl_bitmap, 0, sizeof(sl_bitmap));
+    fl_bitmap = 0;
+    history_count = 0;
+
+    uint8_t *p = (uint8_t *)heap_mem;
+    for (int c = 0; c < LV_HEAP_SLAB_CLASSES; c++)
+    {
+        slab_t *s = &slabs[c];
+        s->start = p;
+        s->free = NULL;
+        for (int i = slab_blocks[c] - 1; i >= 0; i--)
+        {
+            slab_block_t *b = (slab_block_t *)(p + i * slab_size[c]);
+            b->next = s->free;
+            s->free = b;
+        }
+        p += slab_size[c] * slab_blocks[c];
+        s->end = p;
+        stats.slab[c].size = slab_size[c];
+        stats.slab[c].blocks = slab_blocks[c];
+    }
+
+    tlsf_start = p;
+    tlsf_end = (uint8_t *)heap_mem + sizeof(heap_mem);
+    tlsf_block_t *first = (tlsf_block_t *)tlsf_start;
+    first->prev_phys = NULL;
+    first->size = (tlsf_end - tlsf_start) - 2 * BLOCK_HEADER;
+    tlsf_block_t *sentinel = block_next(first);
+    sentinel->prev_phys = first;
+    sentinel->size = 0;
+    insert_free(first);
+    stats.tlsf_size = stats.tlsf_free;
+
+    initialised = true;
+}
+
+void *lv_heap_alloc(size_t size)
+{
+    if (!initialised)
+        lv_heap_init();
+    if (size == 0)
+        size = 1;
+
+    for (int c = 0; c < LV_HEAP_SLAB_CLASSES; c++)
+    {
+        if (size > slab_size[c])
+            continue;
+        slab_block_t *b = slabs[c].free;
+        if (b == NULL)
+        {
+            stats.slab_spills++;
+            break;
+        }
+        slabs[c].free = b->next;
+        lv_heap_slab_stats_t *s = &stats.slab[c];
+        if (++s->in_use > s->peak)
+            s->peak = s->in_use;
+        stats.allocs++;
+        account(slab_size[c]);
+        return b;
+    }
+
+    uint32_t adj = adjust_size(size);
+    void *p = adj ? tlsf_alloc(adj) : NULL;
+    if (p == NULL)
+    {
+        stats.failures++;
+        return NULL;
+    }
+    stats.allocs++;
+    account(block_size(block_from_payload(p)));
+    return p;
+}
+
+void lv_heap_free(void *ptr)
+{
+    if (ptr == NULL)
+        return;
+    stats.frees++;
+
+    int c = slab_class(ptr);
+    if (c >= 0)
+    {
+        slab_block_t *b = ptr;
+        b->next = slabs[c].free;
+        slabs[c].free = b;
+        stats.slab[c].in_use--;
+        account(-(int32_t)slab_size[c]);
+        return;
+    }
+    account(-(int32_t)block_size(block_from_payload(ptr)));
+    tlsf_free(ptr);
+}
+
+void *lv_heap_realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL)
+        return lv_heap_alloc(size);
+
+    uint32_t capacity;
+    int c = slab_class(ptr);
+    if (c >= 0)
+    {
+        capacity = slab_size[c];
+        if (size <= capacity)
+            return ptr;
+    }
+    else
+    {
+        tlsf_block_t *b = block_from_payload(ptr);
+        uint32_t adj = adjust_size(size);
+        if (adj == 0)
+        {
+            stats.failures++;
+            return NULL;
+        }
+        capacity = block_size(b);
+
+        // Grow into a free neighbour, or shrink, without moving
+        tlsf_block_t *next = block_next(b);
+        if (adj > capacity && block_is_free(next) &&
+            capacity + BLOCK_HEADER + block_size(next) >= adj)
+        {
+            remove_free(next);
+            b->size += BLOCK_HEADER + block_size(next);
+            block_next(b)->prev_phys = b;
+        }
+        if (adj <= block_size(b))
+        {
+            split_tail(b, adj);
+            account((int32_t)block_size(b) - (int32_t)capacity);
+            return ptr;
+        }
+    }
+
+    void *p = lv_heap_alloc(size);
+    if (p != NULL)
+    {
+        memcpy(p, ptr, capacity);
+        lv_heap_free(ptr);
+    }
+    return p;
+}
+
+static uint32_t largest_free(void)
+{
+    if (fl_bitmap == 0)
+        return 0;
+    int fl = fls32(fl_bitmap);
+    int sl = fls32(sl_bitmap[fl]);
+    uint32_t largest = 0;
+    for (tlsf_block_t *b = free_lists[fl][sl]; b != NULL; b = b->next_free)
+    {
+        if (block_size(b) > largest)
+            largest = block_size(b);
+    }
+    return largest;
+}
+
+/********************************************************************************
+function:	Copy the counters and work out the current fragmentation
+parameter:
+********************************************************************************/
+void lv_heap_get_stats(lv_heap_stats_t *out)
+{
+    if (!initialised)
+        lv_heap_init();
+    stats.tlsf_largest_free = largest_free();
+    stats.frag_pct = stats.tlsf_free ?
+        (uint8_t)(100 - (uint64_t)stats.tlsf_largest_free * 100 / stats.tlsf_free) : 0;
+    *out = stats;
+}
+
+/********************************************************************************
+function:	Append a sample to the history ring, call periodically
+parameter:
+    time_ms :   Sample time, e.g. lv_tick_get()
+********************************************************************************/
+void lv_heap_sample(uint32_t time_ms)
+{
+    lv_heap_stats_t s;
+    lv_heap_get_stats(&s);
+    lv_heap_sample_t *h = &history[history_count % LV_HEAP_HISTORY];
+    h->time_ms = time_ms;
+    h->live_bytes = s.live_bytes;
+    h->tlsf_free = s.tlsf_free;
+    h->tlsf_largest_free = s.tlsf_largest_free;
+    h->frag_pct = s.frag_pct;
+    history_count++;
+}
+
+/********************************************************************************
+function:	Copy the sample history, oldest first
+parameter:
+return:     Number of samples copied
+********************************************************************************/
+uint32_t lv_heap_get_history(lv_heap_sample_t *samples, uint32_t max)
+{
+    uint32_t n = history_count < LV_HEAP_HISTORY ? history_count : LV_HEAP_HISTORY;
+    if (n > max)
+        n = max;
+    uint32_t first = history_count - n;
+    for (uint32_t i = 0; i < n; i++)
+        samples[i] = history[(first + i) % LV_HEAP_HISTORY];
+    return n;
+}
@@ -0,0 +1,79 @@
+/*****************************************************************************
+* | File        :   lv_heap.h
+* | Function    :   LVGL heap (LV_MEM_CUSTOM) with slab pools in front of TLSF
+* | Info        :
+*----------------
+* | Small requests (table cell strings, style and event records) are served
+* | from fixed size slab pools, everything else from a two level segregated
+* | fit (TLSF) heap. Both are O(1) for alloc and free. The two regions
+* | together take LV_HEAP_SIZE bytes, the same budget as the built-in
+* | allocator's LV_MEM_SIZE.
+* |
+* | Like lv_mem, this is only called from the LVGL loop and is not locked.
+******************************************************************************/
+#ifndef _LV_HEAP_H_
+#define _LV_HEAP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef LV_HEAP_SIZE
+#define LV_HEAP_SIZE (32U * 1024U)
+#endif
+
+/* Slab blocks per class, carved from the front of LV_HEAP_SIZE */
+#ifndef LV_HEAP_SLAB_16
+#define LV_HEAP_SLAB_16 128
+#endif
+#ifndef LV_HEAP_SLAB_32
+#define LV_HEAP_SLAB_32 96
+#endif
+#ifndef LV_HEAP_SLAB_64
+#define LV_HEAP_SLAB_64 32
+#endif
+
+#define LV_HEAP_SLAB_CLASSES 3
+#define LV_HEAP_SLAB_BYTES (16 * LV_HEAP_SLAB_16 + 32 * LV_HEAP_SLAB_32 + 64 * LV_HEAP_SLAB_64)
+#define LV_HEAP_TLSF_BYTES (LV_HEAP_SIZE - LV_HEAP_SLAB_BYTES)
+
+#define LV_HEAP_HISTORY 32 // Samples kept by lv_heap_sample
+
+typedef struct {
+    uint16_t size;
+    uint16_t blocks;
+    uint16_t in_use;
+    uint16_t peak;
+} lv_heap_slab_stats_t;
+
+typedef struct {
+    lv_heap_slab_stats_t slab[LV_HEAP_SLAB_CLASSES];
+    uint32_t live_bytes;        // Bytes handed out, rounded to block size
+    uint32_t peak_bytes;
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failures;
+    uint32_t slab_spills;       // Small requests that went to TLSF
+    uint32_t tlsf_size;
+    uint32_t tlsf_free;
+    uint32_t tlsf_largest_free;
+    uint8_t frag_pct;           // 100 - largest free / total free
+} lv_heap_stats_t;
+
+typedef struct {
+    uint32_t time_ms;
+    uint32_t live_bytes;
+    uint32_t tlsf_free;
+    uint32_t tlsf_largest_free;
+    uint8_t frag_pct;
+} lv_heap_sample_t;
+
+void lv_heap_init(void);
+void *lv_heap_alloc(size_t size);
+void lv_heap_free(void *ptr);
+void *lv_heap_realloc(void *ptr, size_t size);
+
+void lv_heap_get_stats(lv_heap_stats_t *stats);
+void lv_heap_sample(uint32_t time_ms);
+uint32_t lv_heap_get_history(lv_heap_sample_t *samples, uint32_t max);
+
+#endif
@@ -29,49 +29,141 @@
 ******************************************************************************/
 
 #include "LCD_test.h"
+#include "sched.h"
+#include "stack_guard.h"
+#include "boot.h"
+
+#define PWR_KEY_TASK_PERIOD_MS  100
+#define PWR_KEY_SHUTDOWN_MS     1500
+#define BOOT_TASK_PERIOD_MS     2
+#define BACKLIGHT_PCT           60
   
 int press_time = 0;
+static int boot_task_id = -1;
 
-int LCD_1in69_LVGL_Test(void)
+/********************************************************************************
+function:   Cut the battery power when the power key is held down
+parameter:
+********************************************************************************/
+static void power_key_task(void *arg)
+{
+    if(DEV_Digital_Read(PWR_KEY_PIN) == 0)
+    {
+      press_time++;
+      if(press_time > PWR_KEY_SHUTDOWN_MS / PWR_KEY_TASK_PERIOD_MS)//shutdown  
+      {
+        press_time = 0;
+        DEV_Digital_Write(BAT_PWR_PIN, 0);
+      }
+    }
+    else
+    {
+      press_time = 0;
+    }
+}
+
+/********************************************************************************
+function:   Refresh the stack high water marks and check the canaries
+parameter:
+********************************************************************************/
+static void stack_check_task(void *arg)
+{
+    stack_guard_check();
+}
+
+/********************************************************************************
+function:   Finish the boot behind the first frame: light the panel once the
+            first frame is on it, then, with the sensors set up, fill their
+            tables, enable touch and start the stack checks. Cancels itself.
+parameter:
+********************************************************************************/
+static void boot_task(void *arg)
 {
+    if(!boot_reached(BOOT_FIRST_FRAME))
+        return;
+    DEV_SET_PWM(BACKLIGHT_PCT);
+    if(!boot_reached(BOOT_SENSORS_READY))
+        return;
+    BOOT_STEP("sensor_tables", Sensors_Refresh());
+    LVGL_Enable_Touch();
+    sched_add_periodic("stack", stack_check_task, NULL, STACK_GUARD_CHECK_MS, 0, 3);
+    sched_cancel(boot_task_id);
+}
+
+/********************************************************************************
+function:   Initialise the board, LCD and LVGL and schedule the LVGL, power key
+            and boot tasks on the calling core. The backlight stays off until
+            LVGL's first frame replaces the uninitialised panel RAM, which
+            saves clearing it first.
+parameter:
+********************************************************************************/
+static int Display_Init(void)
+{
+    int step = boot_begin("dev_module");
     if (DEV_Module_Init() != 0)
     {
         return -1;
     } 
+    DEV_SET_PWM(0);
+    boot_end(step);
+    boot_signal(BOOT_BUS_READY);
 
     printf("LCD_1in69_LCGL_test Demo\r\n");
     /*Init LCD*/
-    LCD_1IN69_Init(VERTICAL);
-    LCD_1IN69_Clear(WHITE);
-    DEV_SET_PWM(60);
-    /*Init RTC*/
-    PCF85063A_Init();
-    /*Init touch screen*/ 
-    CST816S_init(CST816S_ALL_Mode);
-    /*Init IMU*/
-    QMI8658_init();
-    /*Init LVGL*/
-    LVGL_Init();
-    Widgets_Init();
+    BOOT_STEP("lcd", LCD_1IN69_Init(VERTICAL));
+    /*Init scheduler and LVGL*/
+    sched_init();
+    BOOT_STEP("lvgl", LVGL_Init());
+    BOOT_STEP("widgets", Widgets_Init());
 
-    while(1)
+    sched_add_periodic("pwr_key", power_key_task, NULL, PWR_KEY_TASK_PERIOD_MS, 0, 1);
+    boot_task_id = sched_add_periodic("boot", boot_task, NULL, BOOT_TASK_PERIOD_MS, 0, 1);
+    return 0;
+}
+
+/********************************************************************************
+function:   Initialise the RTC, touch controller and IMU, which share the I2C
+            bus, then signal BOOT_SENSORS_READY. Needs BOOT_BUS_READY, may run
+            on either core.
+parameter:
+********************************************************************************/
+void Sensors_Init(void)
+{
+    BOOT_STEP("rtc", PCF85063A_Init());
+    BOOT_STEP("touch", CST816S_init(CST816S_ALL_Mode));
+    BOOT_STEP("imu", QMI8658_init());
+    Sensors_Imu_Set_Odr(Sensors_Imu_Period_Us()); // The driver leaves its own ODR
+    boot_signal(BOOT_SENSORS_READY);
+}
+
+/********************************************************************************
+function:   Initialise the board, LCD, sensors and LVGL one after the other and
+            schedule the LVGL and power key tasks on the calling core
+parameter:
+********************************************************************************/
+int LCD_1in69_LVGL_Init(void)
+{
+    if (Display_Init() != 0)
     {
-      lv_task_handler();
-      DEV_Delay_ms(5); 
-      if(DEV_Digital_Read(PWR_KEY_PIN) == 0)
-      {
-        press_time++;
-        if(press_time > 300)//shutdown  
-        {
-          press_time = 0;
-          DEV_Digital_Write(BAT_PWR_PIN, 0);
-        }
-      }
-      else
-      {
-        press_time = 0;
-      }
+        return -1;
+    }
+    Sensors_Init();
+    return 0;
+}
+
+/********************************************************************************
+function:   Run the UI on the calling core while the other core, woken by
+            BOOT_BUS_READY, calls Sensors_Init
+parameter:
+********************************************************************************/
+int LCD_1in69_LVGL_Test(void)
+{
+    if (Display_Init() != 0)
+    {
+        return -1;
     }
+    Sensors_Schedule();
+    sched_run();
     
 
     DEV_Module_Exit();
@@ -44,6 +44,8 @@
 #include "LVGL_example.h"
 #include "PCF85063A.h"
 
+int LCD_1in69_LVGL_Init(void);
+void Sensors_Init(void);
 int LCD_1in69_LVGL_Test(void);
 
 #endif
@@ -28,7 +28,16 @@
 #
 ******************************************************************************/
 
+#include <string.h>
 #include "LVGL_example.h" 
+#include "sched.h"
+#include "ui_queue.h"
+#include "ipc_channel.h"
+#include "ui_mirror.h"
+#include "ui_input.h"
+#include "lv_heap.h"
+#include "trace.h"
+#include "boot.h"
 #include "src/core/lv_obj.h"
 #include "src/misc/lv_area.h"
 
@@ -50,6 +59,19 @@ static lv_obj_t *table_rtc_time;
 static lv_obj_t *sw;
 static lv_obj_t *slider;
 static lv_obj_t *roller;
+static lv_obj_t * volatile active_tile; // Read by the update producers
+
+// Dashboard meters on tile1, driven by ipc_dashboard_mailbox
+static lv_obj_t *meterJog;
+static lv_obj_t *meterState;
+static lv_obj_t *meterX;
+static lv_obj_t *meterZ;
+static lv_meter_indicator_t *indicJog1;
+static lv_meter_indicator_t *indicJog2;
+static lv_meter_indicator_t *indicState1;
+static lv_meter_indicator_t *indicState2;
+static lv_meter_indicator_t *indicX;
+static lv_meter_indicator_t *indicZ;
 
 // Touch
 static uint16_t ts_x;
@@ -57,40 +79,87 @@ static uint16_t ts_y;
 static lv_indev_state_t ts_act;
 static uint8_t gesture = 0;
 static lv_indev_drv_t indev_ts;
+static lv_indev_t *ts_indev;
+static volatile bool touch_pending;
+static volatile uint32_t touch_irq_us;
+static uint32_t touch_last_ms;
+
+// Display
+static lv_disp_t *disp;
+static volatile bool flush_last; // The DMA in flight ends a refresh
+static uint32_t flush_bytes;
+static uint32_t flush_start_us;
+
+// Frame time: from the start of the lv_timer_handler pass that renders a
+// refresh to the end of its last flush
+static uint32_t pass_start_us;
+static uint32_t frame_start_us;
+static bool frame_open;
+static lvgl_frame_stats_t frame_stats;
+
+// Dashboard latency: armed when a shown meter changes, closed by the DMA IRQ
+// at the end of the first refresh that flushes it
+enum { DASH_IDLE = 0, DASH_PENDING, DASH_FLUSHING };
+static volatile uint8_t dash_frame;
+static uint64_t dash_publish_us;
+static uint64_t dash_receive_us;
+
+// Statistics
+static lvgl_stats_t lvgl_stats;
 
 // Extern 
 extern uint beep_slice_num;
 extern uint bl_slice_num;
 
-// Timer 
-static struct repeating_timer lvgl_timer;
-static struct repeating_timer imu_data_update_timer;
-static struct repeating_timer rtc_update_timer;
+// Scheduler tasks
+static int lvgl_task_id = SCHED_INVALID_TASK;
+static int imu_data_update_task_id = SCHED_INVALID_TASK;
+static int rtc_update_task_id = SCHED_INVALID_TASK;
+
+// Periods tunable at run time through the command channel
+static uint32_t lvgl_max_idle_ms = LVGL_MAX_IDLE_MS;
+static volatile uint32_t imu_period_us = IMU_SAMPLE_PERIOD_US;
+static volatile uint32_t rtc_period_ms = RTC_UPDATE_PERIOD_MS;
  
 static void disp_flush_cb(lv_disp_drv_t * disp, const lv_area_t * area, lv_color_t * color_p);
+static void disp_wait_cb(lv_disp_drv_t * disp);
 static void touch_callback(uint gpio, uint32_t events);
 static void ts_read_cb(lv_indev_drv_t * drv, lv_indev_data_t*data);
 static void dma_handler(void);
 static void scroll_begin_event_cb(lv_event_t * eevent);
+static void tile_changed_event_cb(lv_event_t * event);
 static void sw_event_cb(lv_event_t * event);
 static void slider_event_cb(lv_event_t * event);
 static void roller_event_cb(lv_event_t * event);
-static void update_imu_data(void);
+static void update_imu_data(bool show);
 static void update_rtc_data(void);
-static bool repeating_lvgl_timer_callback(struct repeating_timer *t); 
-static bool repeating_imu_data_update_timer_callback(struct repeating_timer *t); 
-static bool repeating_rtc_update_timer_callback(struct repeating_timer *t);
+static void set_cell_if_changed(lv_obj_t *table, uint16_t row, uint16_t col, const char *text);
+static void lvgl_task(void *arg);
+static void lvgl_wake(void);
+static void lvgl_doorbell(uint32_t pending);
+static bool set_meter_if_changed(lv_obj_t *meter, lv_meter_indicator_t *indic, float value);
+static void heap_sample_task(void *arg);
+static void telemetry_task(void *arg);
+static void apply_period(uint16_t id, uint32_t period_ms);
 
 /********************************************************************************
-function:	Initializes LVGL and enbable timers IRQ and DMA IRQ
+function:	Initializes LVGL, enbable DMA IRQ and schedule the LVGL task.
+            sched_init must have been called. The touch IRQ waits for
+            LVGL_Enable_Touch, the touch controller may not be set up yet.
+            The LVGL tick comes from time_us_64 (LV_TICK_CUSTOM).
 parameter:
 ********************************************************************************/
 void LVGL_Init(void)
 {
-    /*1.Init Timer*/ 
-    add_repeating_timer_ms(300,  repeating_rtc_update_timer_callback,      NULL, &rtc_update_timer);
-    add_repeating_timer_ms(500,  repeating_imu_data_update_timer_callback, NULL, &imu_data_update_timer);
-    add_repeating_timer_ms(5,    repeating_lvgl_timer_callback,            NULL, &lvgl_timer);
+    /*1.Init update queue, command doorbell and task*/ 
+    ui_queue_init();
+    ui_queue_set_notify(lvgl_wake);
+    ipc_doorbell_set_callback(lvgl_doorbell);
+    ipc_channel_enable_doorbell(&ipc_command_channel);
+    ipc_mailbox_enable_doorbell(&ipc_dashboard_mailbox);
+    lvgl_task_id = sched_add_periodic("lvgl", lvgl_task, NULL, LVGL_MAX_IDLE_MS, LVGL_DEADLINE_MS, 0);
+    sched_add_periodic("lv_heap", heap_sample_task, NULL, LVGL_HEAP_SAMPLE_MS, 0, 3);
+    sched_add_periodic("telemetry", telemetry_task, NULL, LVGL_TELEMETRY_MS, 0, 3);
     
     /*2.Init LVGL core*/
     lv_init();
@@ -99,22 +168,23 @@ void LVGL_Init(void)
     lv_disp_draw_buf_init(&disp_buf, buf0, buf1, DISP_HOR_RES * DISP_VER_RES / 2); 
     lv_disp_drv_init(&disp_drv);    
     disp_drv.flush_cb = disp_flush_cb;
+    disp_drv.wait_cb = disp_wait_cb;
     disp_drv.draw_buf = &disp_buf;        
     disp_drv.hor_res = DISP_HOR_RES;
     disp_drv.ver_res = DISP_VER_RES;
     disp_drv.sw_rotate = 1;
     disp_drv.rotated = LV_DISP_ROT_90;
 
-    lv_disp_t *disp= lv_disp_drv_register(&disp_drv);   
+    disp= lv_disp_drv_register(&disp_drv);   
+    ui_mirror_init(disp);
 
 #if INPUTDEV_TS
     /*4.Init touch screen as input device*/ 
     lv_indev_drv_init(&indev_ts); 
     indev_ts.type = LV_INDEV_TYPE_POINTER;    
     indev_ts.read_cb = ts_read_cb;            
-    lv_indev_t * ts_indev = lv_indev_drv_register(&indev_ts);
-    //Enable touch IRQ
-    DEV_IRQ_SET(Touch_INT_PIN, GPIO_IRQ_EDGE_RISE, &touch_callback);
+    ts_indev = lv_indev_drv_register(&indev_ts);
+    ui_input_init(ts_indev); // Touch, gestures and keys injected from core0
 #endif
 
     /*5.Init DMA for transmit color data from memory to SPI*/
@@ -124,6 +194,109 @@ void LVGL_Init(void)
 
 }
 
+/********************************************************************************
+function:	Enable the touch IRQ, once CST816S_init is done
+parameter:
+********************************************************************************/
+void LVGL_Enable_Touch(void)
+{
+#if INPUTDEV_TS
+    DEV_IRQ_SET(Touch_INT_PIN, GPIO_IRQ_EDGE_RISE, &touch_callback);
+#endif
+}
+
+
+/********************************************************************************
+function:	Schedule the RTC and IMU tasks on the calling core's scheduler.
+            Builds with an RTOS call Sensors_Imu_Task and Sensors_Rtc_Task
+            from their own task instead.
+parameter:
+********************************************************************************/
+void Sensors_Schedule(void)
+{
+    rtc_update_task_id      = sched_add_periodic("rtc", Sensors_Rtc_Task, NULL, rtc_period_ms, 0, 2);
+    imu_data_update_task_id = sched_add_periodic_us("imu", Sensors_Imu_Task, NULL, imu_period_us, 0, 2);
+}
+
+/********************************************************************************
+function:	Fill the IMU and RTC tables once, Widgets_Init leaves them empty
+            so the first frame does not wait for the sensors
+parameter:
+********************************************************************************/
+void Sensors_Refresh(void)
+{
+    update_imu_data(true);
+    update_rtc_data();
+}
+
+/********************************************************************************
+function:	Current sensor periods, for builds that run the sensor tasks
+            from their own loop
+parameter:
+********************************************************************************/
+uint32_t Sensors_Imu_Period_Us(void)
+{
+    return imu_period_us;
+}
+
+// QMI8658 registers, see the datasheet
+#define QMI8658_REG_CTRL2       0x03    // Accelerometer range and ODR
+#define QMI8658_REG_CTRL3       0x04    // Gyroscope range and ODR
+#define QMI8658_REG_CTRL7       0x08    // Sensor enables
+#define QMI8658_CTRL7_ENABLE    0x03    // aEN | gEN
+#define QMI8658_ODR_MAX_MHZ     7174400u
+
+/********************************************************************************
+function:	Set the QMI8658 accelerometer and gyroscope output data rate to
+            the slowest one that still gives a new sample every period, so
+            polling neither re-reads a sample nor aliases. Run by the core
+            that owns the I2C bus.
+parameter:
+    period_us : IMU sampling period
+********************************************************************************/
+void Sensors_Imu_Set_Odr(uint32_t period_us)
+{
+    // 6DOF mode: ODR code n is 7174.4 Hz / 2^n, n up to 8 (28 Hz)
+    uint8_t odr = 8;
+    while(odr > 0 && (uint64_t)(QMI8658_ODR_MAX_MHZ >> odr) * period_us < 1000000000ull)
+        odr--;
+
+    uint8_t ctrl7, ctrl2, ctrl3;
+    QMI8658_read_reg(QMI8658_REG_CTRL7, &ctrl7, 1);
+    QMI8658_read_reg(QMI8658_REG_CTRL2, &ctrl2, 1);
+    QMI8658_read_reg(QMI8658_REG_CTRL3, &ctrl3, 1);
+    // The sensors are disabled while their ODR changes, range bits kept
+    QMI8658_write_reg(QMI8658_REG_CTRL7, ctrl7 & ~QMI8658_CTRL7_ENABLE);
+    QMI8658_write_reg(QMI8658_REG_CTRL2, (ctrl2 & 0xF0) | odr);
+    QMI8658_write_reg(QMI8658_REG_CTRL3, (ctrl3 & 0xF0) | odr);
+    QMI8658_write_reg(QMI8658_REG_CTRL7, ctrl7);
+}
+
+uint32_t Sensors_Rtc_Period_Ms(void)
+{
+    return rtc_period_ms;
+}
+
+/********************************************************************************
+function:	Copy the LVGL loop statistics
+parameter:
+********************************************************************************/
+void LVGL_Get_Stats(lvgl_stats_t *stats)
+{
+    *stats = lvgl_stats;
+}
+
+/********************************************************************************
+function:	Copy and clear the frame time and flush statistics
+parameter:
+********************************************************************************/
+void LVGL_Take_Frame_Stats(lvgl_frame_stats_t *stats)
+{
+    uint32_t save = save_and_disable_interrupts(); // dma_handler adds to them
+    *stats = frame_stats;
+    memset(&frame_stats, 0, sizeof(frame_stats));
+    restore_interrupts(save);
+}
 
 /********************************************************************************
 function:	Initializes the layout of LVGL widgets
@@ -174,9 +347,11 @@ void Widgets_Init(void)
     /*Create tileview*/
     tv = lv_tileview_create(lv_scr_act());
     lv_obj_set_scrollbar_mode(tv,  LV_SCROLLBAR_MODE_OFF);
+    lv_obj_add_event_cb(tv, tile_changed_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
 
     /*Tile1: Just a pic*/
     tile1 = lv_tileview_add_tile(tv, 0, 0, LV_DIR_BOTTOM);
+    active_tile = tile1;
     
     static lv_coord_t col_dsc[] = {100, 100, LV_GRID_TEMPLATE_LAST};
 	static lv_coord_t row_dsc[] = {100,100, LV_GRID_TEMPLATE_LAST};
@@ -190,7 +365,6 @@ void Widgets_Init(void)
 	lv_obj_set_layout(cont, LV_LAYOUT_GRID);
 
 
-    lv_obj_t * meterJog;
     meterJog = lv_meter_create(cont);
 	//lv_obj_center(meterJog);
 	//lv_obj_set_size(meterJog, 100, 100);
@@ -203,13 +377,12 @@ void Widgets_Init(void)
 	lv_meter_set_scale_range(meterJog, meterJogScale, -10, 10, 270, 90);
 
 	/*Add a three arc indicator*/
-	lv_meter_indicator_t * indicJog1 = lv_meter_add_arc(meterJog, meterJogScale, -10, lv_palette_main(LV_PALETTE_RED), 0);
-	lv_meter_indicator_t * indicJog2 = lv_meter_add_arc(meterJog, meterJogScale, 10, lv_palette_main(LV_PALETTE_GREEN), -10);
+	indicJog1 = lv_meter_add_arc(meterJog, meterJogScale, -10, lv_palette_main(LV_PALETTE_RED), 0);
+	indicJog2 = lv_meter_add_arc(meterJog, meterJogScale, 10, lv_palette_main(LV_PALETTE_GREEN), -10);
 
 	lv_meter_set_indicator_end_value(meterJog, indicJog1, 3);
 	lv_meter_set_indicator_end_value(meterJog, indicJog2, 5);
 
-	lv_obj_t * meterState;
 	meterState = lv_meter_create(cont);
 	//lv_obj_center(meterState);
 	//lv_obj_set_size(meterState, 100, 100);
@@ -222,15 +395,14 @@ void Widgets_Init(void)
 	lv_meter_set_scale_range(meterState, meterStateScale, -10, 10, 270, 90);
 
 	/*Add a three arc indicator*/
-	lv_meter_indicator_t * indicState1 = lv_meter_add_arc(meterState, meterStateScale, -10, lv_palette_main(LV_PALETTE_RED), 0);
-	lv_meter_indicator_t * indicState2 = lv_meter_add_arc(meterState, meterStateScale, 10, lv_palette_main(LV_PALETTE_GREEN), -10);
+	indicState1 = lv_meter_add_arc(meterState, meterStateScale, -10, lv_palette_main(LV_PALETTE_RED), 0);
+	indicState2 = lv_meter_add_arc(meterState, meterStateScale, 10, lv_palette_main(LV_PALETTE_GREEN), -10);
 
 	lv_meter_set_indicator_end_value(meterState, indicState1, 9);
 	lv_meter_set_indicator_end_value(meterState, indicState2, 6);
 
 
 
-	lv_obj_t * meterX;
 	meterX = lv_meter_create(cont);
 	lv_obj_set_grid_cell(meterX,
 			LV_GRID_ALIGN_STRETCH, 0, 1,
@@ -242,8 +414,6 @@ void Widgets_Init(void)
 	lv_meter_set_scale_major_ticks(meterX, scaleX, 1, 2, 30, lv_color_black(), 10);
 	lv_meter_set_scale_range(meterX, scaleX, -10, 10, 270, 90);
 
-	lv_meter_indicator_t * indicX;
-
 	/*Add a blue arc to the start*/
 	indicX = lv_meter_add_arc(meterX, scaleX, 3, lv_palette_main(LV_PALETTE_BLUE), 0);
 	lv_meter_set_indicator_start_value(meterX, indicX, 0);
@@ -251,7 +421,6 @@ void Widgets_Init(void)
 
 	lv_meter_set_indicator_end_value(meterX, indicX, 9);
 
-	lv_obj_t * meterZ;
 	meterZ = lv_meter_create(cont);
 	lv_obj_set_grid_cell(meterZ,
 			LV_GRID_ALIGN_STRETCH, 1, 1,
@@ -263,8 +432,6 @@ void Widgets_Init(void)
 	lv_meter_set_scale_major_ticks(meterZ, scaleZ, 1, 2, 30, lv_color_black(), 10);
 	lv_meter_set_scale_range(meterZ, scaleZ, -10, 10, 270, 90);
 
-	lv_meter_indicator_t * indicZ;
-
 	/*Add a blue arc to the start*/
 	indicZ = lv_meter_add_arc(meterZ, scaleZ, 3, lv_palette_main(LV_PALETTE_RED), 0);
 	lv_meter_set_indicator_start_value(meterZ, indicZ, 0);
@@ -416,11 +583,210 @@ void Widgets_Init(void)
     lv_obj_add_style(roller, &style_roller,0);
     lv_obj_add_event_cb(roller, roller_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
 
-    /*Initialize Display*/
-    update_imu_data(); 
-    update_rtc_data(); 
+#if INPUTDEV_TS
+    /*Controls reachable by injected keys, without pulling tile4 into view*/
+    lv_obj_t *keyed[] = { sw, slider, roller };
+    for(int i = 0; i < 3; i++)
+    {
+        lv_obj_clear_flag(keyed[i], LV_OBJ_FLAG_SCROLL_ON_FOCUS);
+        lv_group_add_obj(ui_input_group(), keyed[i]);
+    }
+#endif
+}
+
+
+/********************************************************************************
+function:	Apply the pending widget updates posted to the update queue.
+            Must be called from the LVGL loop only.
+parameter:
+return:     Number of updates drained
+********************************************************************************/
+uint32_t Widgets_Apply_Updates(void)
+{
+    ui_update_t updates[UI_QUEUE_SIZE];
+    uint32_t n = ui_queue_drain(updates, UI_QUEUE_SIZE);
+
+    // Keep only the latest value of every cell so a burst costs one redraw
+    ui_update_t latest[UI_UPDATE_TYPES][6];
+    bool dirty[UI_UPDATE_TYPES][6] = {0};
+    for(uint32_t i = 0; i < n; i++)
+    {
+        if(updates[i].type < UI_UPDATE_TYPES && updates[i].index < 6)
+        {
+            latest[updates[i].type][updates[i].index] = updates[i];
+            dirty[updates[i].type][updates[i].index] = true;
+        }
+    }
+
+    char table_text[16];
+    for(int i = 0; i < 6; i++)
+    {
+        if(dirty[UI_UPDATE_IMU][i])
+        {
+            sprintf(table_text,"%4.1f",latest[UI_UPDATE_IMU][i].value.f);
+            set_cell_if_changed(table_imu_data, i, 0, table_text);
+        }
+        if(dirty[UI_UPDATE_RTC][i])
+        {
+            sprintf(table_text, i == 0 ? "%d" : "%02d", (int)latest[UI_UPDATE_RTC][i].value.i);
+            if(i < 3)
+                set_cell_if_changed(table_rtc_date, 0, i, table_text);
+            else
+                set_cell_if_changed(table_rtc_time, 0, i - 3, table_text);
+        }
+    }
+    return n;
 }
 
+/********************************************************************************
+function:	Apply the commands sent by core0 over the command channel.
+            Must be called from the LVGL loop only.
+parameter:
+return:     Number of commands applied
+********************************************************************************/
+uint32_t Widgets_Apply_Commands(void)
+{
+    uint32_t n = 0;
+    const ipc_cmd_t *cmd;
+    while((cmd = ipc_channel_peek(&ipc_command_channel)) != NULL)
+    {
+        switch(cmd->id)
+        {
+        case IPC_CMD_BACKLIGHT:
+            if(cmd->value >= 1 && cmd->value <= 10)
+            {
+                lv_roller_set_selected(roller, cmd->value - 1, LV_ANIM_OFF);
+                pwm_set_chan_level(bl_slice_num, PWM_CHAN_B, cmd->value*10);
+            }
+            break;
+        case IPC_CMD_BEEP:
+            if(cmd->value)
+                lv_obj_add_state(sw, LV_STATE_CHECKED);
+            else
+                lv_obj_clear_state(sw, LV_STATE_CHECKED);
+            pwm_set_enabled(beep_slice_num, cmd->value != 0);
+            break;
+        case IPC_CMD_REFR_PERIOD:
+        case IPC_CMD_INDEV_PERIOD:
+        case IPC_CMD_MAX_IDLE:
+        case IPC_CMD_RTC_PERIOD:
+            if(cmd->value >= 1 && cmd->value <= 60000)
+                apply_period(cmd->id, cmd->value);
+            break;
+        case IPC_CMD_IMU_PERIOD:
+            if(cmd->value >= 1000 && cmd->value <= 1000000)
+            {
+                imu_period_us = cmd->value;
+                sched_set_period_us(imu_data_update_task_id, cmd->value);
+                if(boot_reached(BOOT_SENSORS_READY)) // Else Sensors_Init sets it
+                    Sensors_Imu_Set_Odr(cmd->value);
+            }
+            break;
+        case IPC_CMD_SPI_CLOCK:
+            if(cmd->value > 0)
+            {
+                // Let the flush in progress finish at the old clock
+                dma_channel_wait_for_finish_blocking(dma_tx);
+                while(spi_is_busy(LCD_SPI_PORT))
+                    tight_loop_contents();
+                spi_set_baudrate(LCD_SPI_PORT, cmd->value);
+            }
+            break;
+        case IPC_CMD_MIRROR:
+            ui_mirror_enable(cmd->value != 0);
+            break;
+        default:
+            break;
+        }
+        ipc_channel_release(&ipc_command_channel);
+        n++;
+    }
+    return n;
+}
+
+/********************************************************************************
+function:	Change one of the LVGL timer or RTC task periods
+parameter:
+    id        : IPC_CMD_*_PERIOD or IPC_CMD_MAX_IDLE
+    period_ms : New period
+********************************************************************************/
+static void apply_period(uint16_t id, uint32_t period_ms)
+{
+    switch(id)
+    {
+    case IPC_CMD_REFR_PERIOD:
+        lv_timer_set_period(_lv_disp_get_refr_timer(disp), period_ms);
+        break;
+    case IPC_CMD_INDEV_PERIOD:
+        if(ts_indev)
+            lv_timer_set_period(lv_indev_get_read_timer(ts_indev), period_ms);
+        break;
+    case IPC_CMD_MAX_IDLE:
+        // Every pass sets the next release, capped here; the period itself
+        // and with it the deadline stay as they are
+        lvgl_max_idle_ms = period_ms;
+        break;
+    case IPC_CMD_RTC_PERIOD:
+        rtc_period_ms = period_ms;
+        sched_set_period(rtc_update_task_id, period_ms);
+        break;
+    default:
+        break;
+    }
+}
+
+/********************************************************************************
+function:	Show the latest dashboard values from core0 on the tile1 meters.
+            Must be called from the LVGL loop only.
+parameter:
+return:     1 if a meter changed, else 0
+********************************************************************************/
+uint32_t Widgets_Apply_Dashboard(void)
+{
+    const ipc_dashboard_t *d = ipc_mailbox_read(&ipc_dashboard_mailbox);
+    if(d == NULL)
+        return 0;
+
+    bool changed = false;
+    changed |= set_meter_if_changed(meterJog, indicJog1, d->jog[0]);
+    changed |= set_meter_if_changed(meterJog, indicJog2, d->jog[1]);
+    changed |= set_meter_if_changed(meterState, indicState1, d->state[0]);
+    changed |= set_meter_if_changed(meterState, indicState2, d->state[1]);
+    changed |= set_meter_if_changed(meterX, indicX, d->axis[0]);
+    changed |= set_meter_if_changed(meterZ, indicZ, d->axis[1]);
+    if(!changed)
+        return 0;
+
+    if(active_tile == tile1)
+    {
+        dash_frame = DASH_IDLE; // Keep the DMA IRQ off the stamps meanwhile
+        dash_publish_us = d->publish_us;
+        dash_receive_us = d->receive_us;
+        dash_frame = DASH_PENDING;
+    }
+    return 1;
+}
+
+/********************************************************************************
+function:	Scroll the tileview to a page (0-3). Call from the LVGL core only.
+parameter:
+********************************************************************************/
+void Widgets_Show_Tile(uint8_t row)
+{
+    lv_obj_set_tile_id(tv, 0, row, LV_ANIM_ON);
+    active_tile = lv_tileview_get_tile_act(tv);
+    lv_timer_resume(_lv_disp_get_refr_timer(disp));
+    lvgl_wake();
+}
+
+/********************************************************************************
+function:	Record the active tile so producers can skip hidden pages
+parameter:
+********************************************************************************/
+static void tile_changed_event_cb(lv_event_t * event)
+{
+    active_tile = lv_tileview_get_tile_act(tv);
+}
 
 /********************************************************************************
 function:	Disable scroll animations when a tab button is clicked in a tabview
@@ -438,6 +804,17 @@ parameter:
 ********************************************************************************/
 static void disp_flush_cb(lv_disp_drv_t * disp, const lv_area_t * area, lv_color_t * color_p)
 {
+    TRACE_BEGIN(TRACE_DISP_FLUSH);
+    flush_last = lv_disp_flush_is_last(disp);
+    if(!frame_open)
+    {
+        frame_open = true;
+        frame_start_us = pass_start_us;
+    }
+    flush_bytes = ((area->x2 + 1 - area->x1) * (area->y2 + 1 - area->y1)) * 2;
+    flush_start_us = time_us_32();
+    if(flush_last && dash_frame == DASH_PENDING)
+        dash_frame = DASH_FLUSHING; // This refresh carries the meter change
     LCD_1IN69_SetWindows(area->x1, area->y1, area->x2+1 , area->y2+1);  // Set the LVGL interface display position
     DEV_Digital_Write(LCD_DC_PIN, 1);
     DEV_Digital_Write(LCD_CS_PIN, 0);
@@ -445,8 +822,22 @@ static void disp_flush_cb(lv_disp_drv_t * disp, const lv_area_t * area, lv_color
                           &c,
                           &spi_get_hw(LCD_SPI_PORT)->dr, 
                           color_p, // read address
-                          ((area->x2 + 1 - area-> x1)*(area->y2 + 1 - area -> y1))*2,
+                          flush_bytes,
                           true);// Start DMA transfer
+    TRACE_ASYNC_BEGIN(TRACE_FLUSH_DMA, flush_last);
+    ui_mirror_flush(area, color_p, flush_last); // Encodes while the DMA runs
+    TRACE_END(TRACE_DISP_FLUSH, flush_bytes / 2);
+}
+
+/********************************************************************************
+function:	Sleep while LVGL waits for the DMA to release a draw buffer
+parameter:
+********************************************************************************/
+static void disp_wait_cb(lv_disp_drv_t * disp)
+{
+    TRACE_BEGIN(TRACE_DISP_WAIT);
+    __wfe(); // dma_handler sends an event when the flush is done
+    TRACE_END(TRACE_DISP_WAIT, 0);
 }
 
 /********************************************************************************
@@ -457,11 +848,19 @@ static void touch_callback(uint gpio, uint32_t events)
 {
     if (gpio == Touch_INT_PIN)
     {
+        TRACE_BEGIN(TRACE_TOUCH_IRQ);
         CST816S_Get_Point(); // Get coordinate data
         gesture = CST816S_Get_Gesture(); // Get gesture data
         ts_x = Touch_CTS816.x_point;
         ts_y = Touch_CTS816.y_point;
         ts_act = LV_INDEV_STATE_PRESSED;
+        if(!touch_pending)
+        {
+            touch_irq_us = time_us_32();
+            touch_pending = true;
+        }
+        lvgl_wake();
+        TRACE_END(TRACE_TOUCH_IRQ, gesture);
     }
 }
 
@@ -471,9 +870,22 @@ parameter:
 ********************************************************************************/
 static void ts_read_cb(lv_indev_drv_t * drv, lv_indev_data_t*data)
 {
+    if(ui_input_read_pointer(data, &gesture))
+        return; // An injected press owns the pointer
+
     data->point.x = ts_x;
     data->point.y = ts_y; 
     data->state = ts_act;
+    if(ts_act == LV_INDEV_STATE_PRESSED && touch_pending)
+    {
+        uint32_t latency_us = time_us_32() - touch_irq_us; // Touch IRQ to LVGL input
+        touch_pending = false;
+        lvgl_stats.touch_events++;
+        lvgl_stats.touch_latency_us_last = latency_us;
+        lvgl_stats.touch_latency_us_total += latency_us;
+        if(latency_us > lvgl_stats.touch_latency_us_max)
+            lvgl_stats.touch_latency_us_max = latency_us;
+    }
     ts_act = LV_INDEV_STATE_RELEASED;
 }
 
@@ -487,20 +899,50 @@ static void dma_handler(void)
     {
         dma_channel_acknowledge_irq0(dma_tx);
         DEV_Digital_Write(LCD_CS_PIN, 1);
+        TRACE_ASYNC_END(TRACE_FLUSH_DMA, flush_last);
+        uint32_t done_us = time_us_32();
+        frame_stats.flush_bytes += flush_bytes;
+        frame_stats.flush_busy_us += done_us - flush_start_us;
+        if(flush_last && frame_open)
+        {
+            uint32_t frame_us = done_us - frame_start_us;
+            uint32_t bucket = frame_us / LVGL_FRAME_BUCKET_US;
+            frame_open = false;
+            frame_stats.frames++;
+            frame_stats.frame_hist[bucket < LVGL_FRAME_BUCKETS ? bucket : LVGL_FRAME_BUCKETS - 1]++;
+            if(frame_us > frame_stats.frame_us_max)
+                frame_stats.frame_us_max = frame_us;
+            if(!boot_reached(BOOT_FIRST_FRAME))
+                boot_signal(BOOT_FIRST_FRAME);
+        }
+        if(flush_last && dash_frame == DASH_FLUSHING)
+        {
+            // The changed meters are on the panel now
+            uint64_t now_us = time_us_64();
+            uint32_t latency_us = (uint32_t)(now_us - dash_publish_us);
+            dash_frame = DASH_IDLE;
+            lvgl_stats.dashboard_frames++;
+            lvgl_stats.dashboard_latency_us_last = latency_us;
+            lvgl_stats.dashboard_latency_us_total += latency_us;
+            if(latency_us > lvgl_stats.dashboard_latency_us_max)
+                lvgl_stats.dashboard_latency_us_max = latency_us;
+            lvgl_stats.dashboard_local_us_last = (uint32_t)(now_us - dash_receive_us);
+        }
         lv_disp_flush_ready(&disp_drv); // Indicate you are ready with the flushing
+        __sev(); // Wake disp_wait_cb
     }
 }
 
 /********************************************************************************
-function:   Check if the page needs to be updated
+function:   Check if the page needs to be updated. Does not call into LVGL so
+            it is safe outside the LVGL loop.
 parameter:
 ********************************************************************************/
-static bool update_check(lv_obj_t *tv,lv_obj_t *tilex) 
+static bool update_check(lv_obj_t *tilex) 
 {
     uint8_t ret = true; 
 
-    lv_obj_t *active_tile = lv_tileview_get_tile_act(tv); // Get the current active interface
-    if (active_tile != tilex) 
+    if (active_tile != tilex) // Compare with the current active interface
     {
         ret = false;
     }
@@ -515,85 +957,262 @@ static bool update_check(lv_obj_t *tv,lv_obj_t *tilex)
 }
 
 /********************************************************************************
-function:   Update IMU data
+function:   Read IMU data, send the sample to core0 and, if shown, post it to
+            the update queue
 parameter:
+    show : Post the values to the IMU table
 ********************************************************************************/
-static void update_imu_data()
+static void update_imu_data(bool show)
 {
-    float acc[3], gyro[3];
+    float acc_local[3], gyro_local[3];
+    float *acc = acc_local, *gyro = gyro_local;
     unsigned int tim_count = 0;
-    QMI8658_read_xyz(acc, gyro, &tim_count); // Reading IMU data
 
-    char table_text[64];
-    for(int i = 0; i < 3; i++)
+    // Read straight into the channel slot when there is one free
+    ipc_imu_sample_t *sample = ipc_channel_reserve(&ipc_sensor_channel);
+    if(sample != NULL)
+    {
+        acc = sample->acc;
+        gyro = sample->gyro;
+    }
+    TRACE_BEGIN(TRACE_IMU_READ);
+    QMI8658_read_xyz(acc, gyro, &tim_count); // Reading IMU data
+    TRACE_END(TRACE_IMU_READ, 0);
+    if(sample != NULL)
     {
-        sprintf(table_text,"%4.1f",acc[i]);
-        lv_table_set_cell_value(table_imu_data, i, 0, table_text); // Update table data
+        sched_task_stats_t task;
+        sample->timestamp_us = time_us_64();
+        sample->skipped = sched_get_stats(imu_data_update_task_id, &task) ? task.skipped : 0;
+        ipc_channel_commit(&ipc_sensor_channel);
     }
 
+    if(!show)
+        return;
+
     for(int i = 0; i < 3; i++)
     {
-        sprintf(table_text,"%4.1f",gyro[i]);
-        lv_table_set_cell_value(table_imu_data, i+3, 0, table_text);
+        ui_queue_post_float(UI_UPDATE_IMU, i, acc[i]); // Post table data
+        ui_queue_post_float(UI_UPDATE_IMU, i+3, gyro[i]);
     }
 }
 
 /********************************************************************************
-function:   Update RTC data
+function:   Read RTC data and post it to the update queue
 parameter:
 ********************************************************************************/
 static void update_rtc_data()
 {
     datetime_t Now_time;
+    TRACE_BEGIN(TRACE_RTC_READ);
     PCF85063A_Read_now(&Now_time); //Reading RTC dat1a
+    TRACE_END(TRACE_RTC_READ, 0);
+
+    ui_queue_post_int(UI_UPDATE_RTC, 0, Now_time.year); // Post table data
+    ui_queue_post_int(UI_UPDATE_RTC, 1, Now_time.month);
+    ui_queue_post_int(UI_UPDATE_RTC, 2, Now_time.day);
+    ui_queue_post_int(UI_UPDATE_RTC, 3, Now_time.hour);
+    ui_queue_post_int(UI_UPDATE_RTC, 4, Now_time.min);
+    ui_queue_post_int(UI_UPDATE_RTC, 5, Now_time.sec);
+}
 
-    char table_text[64];
-    sprintf(table_text,"%d",Now_time.year);
-    lv_table_set_cell_value(table_rtc_date, 0, 0, table_text); // Update table data
-    sprintf(table_text,"%02d",Now_time.month);
-    lv_table_set_cell_value(table_rtc_date, 0, 1, table_text);
-    sprintf(table_text,"%02d",Now_time.day);
-    lv_table_set_cell_value(table_rtc_date, 0, 2, table_text);
-    sprintf(table_text,"%02d",Now_time.hour);
-    lv_table_set_cell_value(table_rtc_time, 0, 0, table_text);
-    sprintf(table_text,"%02d",Now_time.min);
-    lv_table_set_cell_value(table_rtc_time, 0, 1, table_text);
-    sprintf(table_text,"%02d",Now_time.sec);
-    lv_table_set_cell_value(table_rtc_time, 0, 2, table_text);
+/********************************************************************************
+function:   Only touch the table when the text really changes, every set
+            reallocates the cell string in the LVGL heap
+parameter:
+********************************************************************************/
+static void set_cell_if_changed(lv_obj_t *table, uint16_t row, uint16_t col, const char *text)
+{
+    const char *current = lv_table_get_cell_value(table, row, col);
+    if(current == NULL || strcmp(current, text) != 0)
+        lv_table_set_cell_value(table, row, col, text);
 }
 
 /********************************************************************************
-function:   Report the elapsed time to LVGL each 5ms
+function:   Move a meter indicator, only invalidating it on a new value
 parameter:
+    value : Scale units, rounded and clamped to the -10..10 range
 ********************************************************************************/
-static bool repeating_lvgl_timer_callback(struct repeating_timer *t) 
+static bool set_meter_if_changed(lv_obj_t *meter, lv_meter_indicator_t *indic, float value)
 {
-    lv_tick_inc(5);
+    if(value > 10.0f)
+        value = 10.0f;
+    else if(value < -10.0f)
+        value = -10.0f;
+    int32_t v = (int32_t)(value < 0 ? value - 0.5f : value + 0.5f);
+    if(indic->end_value == v)
+        return false;
+    lv_meter_set_indicator_end_value(meter, indic, v);
     return true;
 }
 
 /********************************************************************************
-function:   Update IMU label data each 500ms
+function:   Run LVGL, then sleep until its next timer is due. The input read
+            timer is paused while the screen is not touched and the refresh
+            timer while nothing is invalid or animating; a touch, a queued
+            update, a command or a dashboard value from core0 wakes the task
+            and resumes them. A dashboard change is drawn in the same pass.
+            Injected input counts as a touch from the time it is due.
 parameter:
 ********************************************************************************/
-static bool repeating_imu_data_update_timer_callback(struct repeating_timer *t) 
+static void lvgl_task(void *arg)
 {
-    if(update_check(tv,tile2) == true) // Need to update the interface
-        update_imu_data(); // Update data
+    uint32_t now_ms = lv_tick_get();
+    lv_timer_t *refr_timer = _lv_disp_get_refr_timer(disp);
+    lv_timer_t *read_timer = ts_indev ? lv_indev_get_read_timer(ts_indev) : NULL;
+
+    uint32_t input_ms;
+    bool injected = ui_input_poll(&input_ms);
+    bool touched = touch_pending || injected;
+    if(touched && read_timer)
+    {
+        touch_last_ms = now_ms;
+        lv_timer_resume(read_timer);
+        lv_timer_ready(read_timer);
+    }
 
-    return true;
+    uint32_t dashboard = Widgets_Apply_Dashboard();
+    uint32_t events = Widgets_Apply_Commands() + Widgets_Apply_Updates() + dashboard;
+    events += ui_mirror_poll();
+    if(touched || events)
+        lv_timer_resume(refr_timer);
+    if(dashboard)
+        lv_timer_ready(refr_timer);
+
+    pass_start_us = time_us_32();
+    TRACE_BEGIN(TRACE_LV_TIMER_HANDLER);
+    uint32_t next_ms = lv_timer_handler();
+    TRACE_END(TRACE_LV_TIMER_HANDLER, next_ms);
+
+    bool input_idle = read_timer == NULL ||
+        (!touch_pending && lv_tick_elaps(touch_last_ms) > LVGL_TOUCH_IDLE_MS);
+    if(input_idle && read_timer)
+        lv_timer_pause(read_timer);
+    if(input_idle && disp->inv_p == 0 && lv_anim_count_running() == 0)
+        lv_timer_pause(refr_timer);
+
+    if(next_ms > input_ms)
+        next_ms = input_ms;
+    if(next_ms > lvgl_max_idle_ms)
+        next_ms = lvgl_max_idle_ms;
+    sched_set_next_release(lvgl_task_id, next_ms);
 }
 
-/**********`**********************************************************************
-function:   Update RTC label data each 300ms
+/********************************************************************************
+function:   Release the LVGL task now, safe from IRQ context and core0
 parameter:
 ********************************************************************************/
-static bool repeating_rtc_update_timer_callback(struct repeating_timer *t)
+static void lvgl_wake(void)
 {
-    if(update_check(tv,tile3) == true) // Need to update the interface
-        update_rtc_data(); // Update data
+    sched_notify(lvgl_task_id);
+}
 
-    return true;
+static void lvgl_doorbell(uint32_t pending)
+{
+    if(pending & ((1u << ipc_command_channel.id) | (1u << ipc_dashboard_mailbox.id) |
+                  (1u << ipc_input_channel.id)))
+        lvgl_wake();
+}
+
+/********************************************************************************
+function:   Record the LVGL heap usage and fragmentation history
+parameter:
+********************************************************************************/
+static void heap_sample_task(void *arg)
+{
+    lv_heap_sample(lv_tick_get());
+}
+
+/********************************************************************************
+function:   Frame time at a percentile, from the upper edge of its bucket
+parameter:
+********************************************************************************/
+static uint32_t frame_percentile(const lvgl_frame_stats_t *stats, uint32_t pct)
+{
+    uint32_t rank = (stats->frames * pct + 99) / 100;
+    uint32_t seen = 0;
+    for(int i = 0; i < LVGL_FRAME_BUCKETS - 1; i++)
+    {
+        seen += stats->frame_hist[i];
+        if(seen >= rank)
+            return MIN((i + 1) * LVGL_FRAME_BUCKET_US, stats->frame_us_max);
+    }
+    return stats->frame_us_max;
+}
+
+/********************************************************************************
+function:   Publish a performance snapshot of this core for the telemetry
+            topic on core0
+parameter:
+********************************************************************************/
+static void telemetry_task(void *arg)
+{
+    static uint64_t last_elapsed_us;
+    static uint64_t last_busy_us;
+
+    sched_summary_t summary;
+    lvgl_frame_stats_t frames;
+    lv_heap_stats_t heap;
+    sched_get_summary(&summary);
+    LVGL_Take_Frame_Stats(&frames);
+    lv_heap_get_stats(&heap);
+
+    uint64_t interval_us = summary.elapsed_us - last_elapsed_us;
+    uint64_t busy_us = summary.busy_us - last_busy_us;
+    last_elapsed_us = summary.elapsed_us;
+    last_busy_us = summary.busy_us;
+    if(interval_us == 0)
+        return;
+
+    ipc_ui_telemetry_t *t = ipc_mailbox_write(&ipc_telemetry_mailbox);
+    t->interval_us = (uint32_t)interval_us;
+    t->cpu_load_pct = (uint8_t)(busy_us * 100 / interval_us);
+    t->flush_busy_pct = (uint8_t)MIN(frames.flush_busy_us * 100 / interval_us, 100);
+    t->frames = frames.frames;
+    t->frame_us_p50 = frame_percentile(&frames, 50);
+    t->frame_us_p90 = frame_percentile(&frames, 90);
+    t->frame_us_p99 = frame_percentile(&frames, 99);
+    t->frame_us_max = frames.frame_us_max;
+    t->flush_bytes_per_s = (uint32_t)(frames.flush_bytes * 1000000 / interval_us);
+    t->heap_live = heap.live_bytes;
+    t->heap_peak = heap.peak_bytes;
+    t->heap_free = heap.tlsf_free;
+    t->heap_largest_free = heap.tlsf_largest_free;
+    t->heap_frag_pct = heap.frag_pct;
+    t->heap_failures = heap.failures;
+    ui_input_stats_t input;
+    ui_input_get_stats(&input);
+    t->input_events = input.events;
+    t->input_late_us_max = ui_input_take_late_max();
+    ipc_mailbox_publish(&ipc_telemetry_mailbox);
+}
+
+/********************************************************************************
+function:   Sample the IMU each imu_period_us and post label data each
+            IMU_UPDATE_PERIOD_MS, runs as a scheduler task
+parameter:
+********************************************************************************/
+void Sensors_Imu_Task(void *arg)
+{
+    if(!boot_reached(BOOT_SENSORS_READY)) // The other core owns the I2C bus
+        return;
+    // Every sample goes to core0, the table only needs IMU_UPDATE_PERIOD_MS
+    static uint32_t samples;
+    bool ui_due = ++samples * imu_period_us >= IMU_UPDATE_PERIOD_MS * 1000;
+    if(ui_due)
+        samples = 0;
+    update_imu_data(ui_due && update_check(tile2)); // Update data, shown if on the interface
+}
+
+/********************************************************************************
+function:   Post RTC label data each rtc_period_ms, runs as a scheduler task
+parameter:
+********************************************************************************/
+void Sensors_Rtc_Task(void *arg)
+{
+    if(!boot_reached(BOOT_SENSORS_READY))
+        return;
+    if(update_check(tile3) == true) // Need to update the interface
+        update_rtc_data(); // Update data
 }
 
 /********************************************************************************
@@ -47,7 +47,53 @@
 
 #define INPUTDEV_TS  1
 
+#define IMU_UPDATE_PERIOD_MS 100
+#define RTC_UPDATE_PERIOD_MS 300  // Defaults: the periods can be changed at run
+                                  // time with commands, see ipc_cmd_id_t
+
+#define LVGL_MAX_IDLE_MS     500  // Longest sleep of the LVGL task
+#define LVGL_DEADLINE_MS     5    // Response deadline after a wakeup
+#define LVGL_TOUCH_IDLE_MS   100  // No touch IRQ for this long pauses input reads
+#define LVGL_HEAP_SAMPLE_MS  1000 // lv_heap history interval
+#define LVGL_TELEMETRY_MS    1000 // Snapshot to ipc_telemetry_mailbox
+#define LVGL_FRAME_BUCKET_US 500  // Frame time histogram resolution
+#define LVGL_FRAME_BUCKETS   64   // The last bucket takes everything longer
+
+typedef struct {
+    uint32_t touch_events;
+    uint32_t touch_latency_us_last;  // Touch IRQ to LVGL input read
+    uint32_t touch_latency_us_max;
+    uint64_t touch_latency_us_total;
+    uint32_t dashboard_frames;           // Meter changes that reached the panel
+    uint32_t dashboard_latency_us_last;  // Agent publish to end of the refresh flush
+    uint32_t dashboard_latency_us_max;
+    uint64_t dashboard_latency_us_total;
+    uint32_t dashboard_local_us_last;    // Executor receive to end of the refresh flush
+} lvgl_stats_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t frame_us_max;
+    uint16_t frame_hist[LVGL_FRAME_BUCKETS];
+    uint64_t flush_bytes;
+    uint64_t flush_busy_us;     // SPI DMA running
+} lvgl_frame_stats_t;
+
 void LVGL_Init(void);
+void LVGL_Enable_Touch(void);
+void LVGL_Get_Stats(lvgl_stats_t *stats);
+void LVGL_Take_Frame_Stats(lvgl_frame_stats_t *stats);
+void Sensors_Schedule(void);
+void Sensors_Refresh(void);
+void Sensors_Imu_Task(void *arg);
+void Sensors_Rtc_Task(void *arg);
+uint32_t Sensors_Imu_Period_Us(void);
+void Sensors_Imu_Set_Odr(uint32_t period_us);
+uint32_t Sensors_Rtc_Period_Ms(void);
 void Widgets_Init(void);
+uint32_t Widgets_Apply_Updates(void);
+uint32_t Widgets_Apply_Commands(void);
+uint32_t Widgets_Apply_Dashboard(void);
+void Widgets_Show_Tile(uint8_t row);
 
 #endif
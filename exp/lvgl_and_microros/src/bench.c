@@ -0,0 +1,182 @@
+/*****************************************************************************
+* | File        :   bench.c
+* | Function    :   Micro-benchmark harness for the firmware hot paths
+* | Info        :
+*----------------
+* | SysTick runs free from the core clock with the full 24 bit reload and
+* | no interrupt. A sample stamps both SysTick and time_us_64, so the short
+* | ones get exact cycles and the long ones, where SysTick may have wrapped,
+* | the microsecond count scaled to cycles.
+******************************************************************************/
+#if BENCH_HOST
+#define _GNU_SOURCE
+#endif
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if BENCH_HOST
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#define BENCH_PLATFORM  "host"
+#else
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#define BENCH_PLATFORM  "rp2040"
+#define SYSTICK_MAX     0x00ffffffu
+#define SYSTICK_ENABLE  0x1u
+#define SYSTICK_CORE    0x4u    // Count core clock cycles
+#endif
+
+#define OVERHEAD_RUNS   64
+
+typedef struct {
+    uint64_t us;
+    uint64_t ticks;
+} stamp_t;
+
+static uint64_t ticks_per_s;    // Core clock, or ns on the host
+static uint64_t overhead;       // Ticks of an empty sample
+static uint64_t samples[BENCH_SAMPLES];
+
+#if BENCH_HOST
+static inline void stamp(stamp_t *s)
+{
+    // The raw call: pico_uart_transport.c replaces clock_gettime for XRCE
+    struct timespec ts;
+    syscall(SYS_clock_gettime, CLOCK_MONOTONIC, &ts);
+    s->ticks = (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+    s->us = s->ticks / 1000;
+}
+
+static uint64_t elapsed(const stamp_t *a, const stamp_t *b)
+{
+    return b->ticks - a->ticks;
+}
+#else
+static inline void stamp(stamp_t *s)
+{
+    s->us = time_us_64();
+    s->ticks = systick_hw->cvr;
+}
+
+static uint64_t elapsed(const stamp_t *a, const stamp_t *b)
+{
+    uint64_t us = b->us - a->us;
+    // SysTick counts down; trust it up to half a wrap
+    if(us * (ticks_per_s / 1000000) < SYSTICK_MAX / 2)
+        return (a->ticks - b->ticks) & SYSTICK_MAX;
+    return us * ticks_per_s / 1000000;
+}
+#endif
+
+/********************************************************************************
+function:	Start the cycle counter and measure the cost of a sample with
+            nothing in it
+parameter:
+********************************************************************************/
+void bench_init(void)
+{
+#if BENCH_HOST
+    ticks_per_s = 1000000000u;
+#else
+    ticks_per_s = clock_get_hz(clk_sys);
+    systick_hw->csr = 0;
+    systick_hw->rvr = SYSTICK_MAX;
+    systick_hw->cvr = 0;
+    systick_hw->csr = SYSTICK_ENABLE | SYSTICK_CORE;
+#endif
+    overhead = UINT64_MAX;
+    for(int i = 0; i < OVERHEAD_RUNS; i++)
+    {
+        stamp_t a, b;
+        stamp(&a);
+        stamp(&b);
+        uint64_t t = elapsed(&a, &b);
+        if(t < overhead)
+            overhead = t;
+    }
+}
+
+/********************************************************************************
+function:	Run one case: warm up, then time BENCH_SAMPLES batches
+parameter:
+    c      : Case, iterations 0 counts as 1
+    result : Per iteration figures
+********************************************************************************/
+void bench_run(const bench_case_t *c, bench_result_t *result)
+{
+    uint32_t n = c->iterations ? c->iterations : 1;
+    for(int i = 0; i < BENCH_WARMUP + BENCH_SAMPLES; i++)
+    {
+        if(c->setup)
+            c->setup(c->arg, n);
+        stamp_t a, b;
+        stamp(&a);
+        c->run(c->arg, n);
+        stamp(&b);
+        uint64_t t = elapsed(&a, &b);
+        if(i >= BENCH_WARMUP)
+            samples[i - BENCH_WARMUP] = t > overhead ? t - overhead : 0;
+    }
+
+    // Insertion sort, a few dozen samples
+    for(int i = 1; i < BENCH_SAMPLES; i++)
+    {
+        uint64_t v = samples[i];
+        int j = i;
+        for(; j > 0 && samples[j - 1] > v; j--)
+            samples[j] = samples[j - 1];
+        samples[j] = v;
+    }
+
+    float to_ns = 1e9f / (float)ticks_per_s / (float)n;
+    result->samples = BENCH_SAMPLES;
+    result->iterations = n;
+    result->ns_min = samples[0] * to_ns;
+    result->ns_median = samples[BENCH_SAMPLES / 2] * to_ns;
+    result->ns_max = samples[BENCH_SAMPLES - 1] * to_ns;
+#if BENCH_HOST
+    result->cycles_min = result->cycles_median = result->cycles_max = 0;
+#else
+    result->cycles_min = (float)samples[0] / n;
+    result->cycles_median = (float)samples[BENCH_SAMPLES / 2] / n;
+    result->cycles_max = (float)samples[BENCH_SAMPLES - 1] / n;
+#endif
+}
+
+/********************************************************************************
+function:	Print a result as one BENCH_PREFIX JSON line
+parameter:
+********************************************************************************/
+void bench_print(const bench_case_t *c, const bench_result_t *r)
+{
+    printf(BENCH_PREFIX "{\"name\":\"%s\",\"platform\":\"" BENCH_PLATFORM "\","
+           "\"clock_hz\":%llu,\"samples\":%lu,\"iterations\":%lu,"
+           "\"ns_min\":%.1f,\"ns_median\":%.1f,\"ns_max\":%.1f,"
+           "\"cycles_min\":%.1f,\"cycles_median\":%.1f,\"cycles_max\":%.1f}\n",
+           c->name, (unsigned long long)ticks_per_s,
+           (unsigned long)r->samples, (unsigned long)r->iterations,
+           r->ns_min, r->ns_median, r->ns_max,
+           r->cycles_min, r->cycles_median, r->cycles_max);
+    fflush(stdout);
+}
+
+void bench_run_all(const bench_case_t *cases, size_t count)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        bench_result_t result;
+        bench_run(&cases[i], &result);
+        bench_print(&cases[i], &result);
+    }
+}
+
+void bench_done(void)
+{
+    printf(BENCH_DONE "\n");
+    fflush(stdout);
+}
@@ -0,0 +1,60 @@
+/*****************************************************************************
+* | File        :   bench.h
+* | Function    :   Micro-benchmark harness for the firmware hot paths
+* | Info        :
+*----------------
+* | A case runs its function on a batch of iterations per sample. After
+* | BENCH_WARMUP untimed samples (caches, heap and lazy set up settle),
+* | BENCH_SAMPLES timed ones are kept and reported per iteration as min,
+* | median and max, the overhead of reading the clock taken off.
+* |
+* | On the RP2040 a sample is timed in core clock cycles with SysTick, and
+* | with time_us_64 when it is too long for the 24 bit counter. The host
+* | build (BENCH_HOST) times with CLOCK_MONOTONIC and reports no cycles.
+* |
+* | Each result is one JSON line on stdout, prefixed with BENCH_PREFIX so
+* | it can be picked out of other output; tools/micro_bench.py collects
+* | the lines and compares them with a baseline.
+******************************************************************************/
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef BENCH_SAMPLES
+#define BENCH_SAMPLES   31
+#endif
+#define BENCH_WARMUP    3
+#define BENCH_PREFIX    "BENCH "
+#define BENCH_DONE      BENCH_PREFIX "done"   // After the last result of a run
+
+typedef void (*bench_fn_t)(void *arg, uint32_t iterations);
+
+typedef struct {
+    const char *name;
+    bench_fn_t run;           // Timed, runs the batch
+    bench_fn_t setup;         // Optional, untimed, before every sample
+    void *arg;
+    uint32_t iterations;      // Per sample
+} bench_case_t;
+
+typedef struct {
+    uint32_t samples;
+    uint32_t iterations;
+    float ns_min;             // Per iteration
+    float ns_median;
+    float ns_max;
+    float cycles_min;         // 0 on the host
+    float cycles_median;
+    float cycles_max;
+} bench_result_t;
+
+void bench_init(void);
+void bench_run(const bench_case_t *c, bench_result_t *result);
+void bench_print(const bench_case_t *c, const bench_result_t *result);
+void bench_run_all(const bench_case_t *cases, size_t count);
+void bench_done(void);
+
+#endif
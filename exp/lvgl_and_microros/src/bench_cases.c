@@ -0,0 +1,173 @@
+/*****************************************************************************
+* | File        :   bench_cases.c
+* | Function    :   Benchmark cases shared by the target and host builds
+* | Info        :
+*----------------
+* | The inputs are volatile or alternate between iterations, so the
+* | compiler cannot hoist the work out of the batch loop and LVGL cannot
+* | skip it as unchanged.
+******************************************************************************/
+#include "bench_cases.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "usb_cdc_transport.h"
+#if BENCH_LVGL
+#include "lvgl.h"
+#endif
+
+#define BLEND_W     240     // One draw buffer row band of the panel
+#define BLEND_H     20
+
+static volatile float imu_values[6] = { 12.5f, -981.2f, 3.0f, -0.4f, 250.7f, -17.9f };
+static char table_text[16];
+static uint8_t io_buf[BENCH_IO_BYTES];
+
+/********************************************************************************
+function:	The table text of one IMU update, as Widgets_Apply_Updates
+            formats it: six "%4.1f" conversions
+parameter:
+********************************************************************************/
+static void bench_sprintf_imu(void *arg, uint32_t iterations)
+{
+    for(uint32_t i = 0; i < iterations; i++)
+    {
+        for(int k = 0; k < 6; k++)
+            sprintf(table_text, "%4.1f", imu_values[k]);
+    }
+}
+
+#if BENCH_LVGL
+static lv_obj_t *table;
+
+typedef struct {
+    lv_opa_t opa;
+    bool copy;                // Blend a source image instead of a color
+} blend_arg_t;
+
+static lv_color_t blend_buf[BLEND_W * BLEND_H];
+static lv_color_t blend_src[BLEND_W * BLEND_H];
+static const blend_arg_t fill = { LV_OPA_COVER, false };
+static const blend_arg_t fill_opa = { LV_OPA_50, false };
+static const blend_arg_t copy = { LV_OPA_COVER, true };
+
+/********************************************************************************
+function:	Set one IMU cell to a new text, the cell string is reallocated
+            every time like on a live table
+parameter:
+********************************************************************************/
+static void bench_table_set(void *arg, uint32_t iterations)
+{
+    for(uint32_t i = 0; i < iterations; i++)
+        lv_table_set_cell_value(table, i % 6, 0, (i & 1) ? "-981.2" : "12.5");
+}
+
+/********************************************************************************
+function:	Blend a BLEND_W x BLEND_H area into the draw buffer
+parameter:
+    arg : blend_arg_t
+********************************************************************************/
+static void bench_blend(void *arg, uint32_t iterations)
+{
+    const blend_arg_t *b = arg;
+    lv_area_t area = { 0, 0, BLEND_W - 1, BLEND_H - 1 };
+
+    lv_draw_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.buf = blend_buf;
+    ctx.buf_area = &area;
+    ctx.clip_area = &area;
+
+    lv_draw_sw_blend_dsc_t dsc;
+    memset(&dsc, 0, sizeof(dsc));
+    dsc.blend_area = &area;
+    dsc.src_buf = b->copy ? blend_src : NULL;
+    dsc.color = lv_color_hex(0x3366cc);
+    dsc.opa = b->opa;
+    dsc.mask_res = LV_DRAW_MASK_RES_FULL_COVER;
+    dsc.blend_mode = LV_BLEND_MODE_NORMAL;
+
+    // The blend looks up the display being refreshed for set_px_cb
+    lv_disp_t *refreshing = _lv_refr_get_disp_refreshing();
+    _lv_refr_set_disp_refreshing(lv_disp_get_default());
+    for(uint32_t i = 0; i < iterations; i++)
+        lv_draw_sw_blend_basic(&ctx, &dsc);
+    _lv_refr_set_disp_refreshing(refreshing);
+}
+#endif
+
+/********************************************************************************
+function:	Write BENCH_IO_BYTES per iteration through the CDC transport
+parameter:
+    arg : The bytes to send
+********************************************************************************/
+void bench_cdc_write(void *arg, uint32_t iterations)
+{
+    uint8_t err = 0;
+    for(uint32_t i = 0; i < iterations; i++)
+        usb_cdc_transport_write(NULL, arg, BENCH_IO_BYTES, &err);
+}
+
+/********************************************************************************
+function:	Read BENCH_IO_BYTES per iteration, the far end has sent them
+parameter:
+********************************************************************************/
+void bench_cdc_read(void *arg, uint32_t iterations)
+{
+    for(uint32_t i = 0; i < iterations; i++)
+    {
+        size_t got = 0;
+        uint8_t err = 0;
+        while(got < BENCH_IO_BYTES && !err)
+            got += usb_cdc_transport_read(NULL, io_buf + got, BENCH_IO_BYTES - got, 10, &err);
+    }
+}
+
+/********************************************************************************
+function:	Read with nothing pending and no timeout, what the executor does
+            on every spin while the agent is quiet
+parameter:
+********************************************************************************/
+void bench_cdc_read_poll(void *arg, uint32_t iterations)
+{
+    for(uint32_t i = 0; i < iterations; i++)
+    {
+        uint8_t err = 0;
+        usb_cdc_transport_read(NULL, io_buf, BENCH_IO_BYTES, 0, &err);
+    }
+}
+
+/********************************************************************************
+function:	Run the cases that need nothing but the CPU and, with BENCH_LVGL,
+            LVGL. Call after bench_init.
+parameter:
+********************************************************************************/
+void bench_cases_run(void)
+{
+    static const bench_case_t cases[] = {
+        { "sprintf_imu_table", bench_sprintf_imu, NULL, NULL, 10 },
+#if BENCH_LVGL
+        { "lv_table_set_cell_value", bench_table_set, NULL, NULL, 60 },
+        { "lv_blend_fill_240x20", bench_blend, NULL, (void *)&fill, 10 },
+        { "lv_blend_fill_opa_240x20", bench_blend, NULL, (void *)&fill_opa, 10 },
+        { "lv_blend_copy_240x20", bench_blend, NULL, (void *)&copy, 10 },
+#endif
+    };
+
+#if BENCH_LVGL
+    // Off screen: only the cell strings are exercised, nothing is drawn
+    table = lv_table_create(lv_scr_act());
+    lv_obj_add_flag(table, LV_OBJ_FLAG_HIDDEN);
+    lv_table_set_col_cnt(table, 1);
+    lv_table_set_row_cnt(table, 6);
+    for(int i = 0; i < BLEND_W * BLEND_H; i++)
+        blend_src[i] = lv_color_hex(i * 0x010203);
+#endif
+
+    bench_run_all(cases, sizeof(cases) / sizeof(cases[0]));
+
+#if BENCH_LVGL
+    lv_obj_del(table);
+#endif
+}
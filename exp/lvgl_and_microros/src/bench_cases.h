@@ -0,0 +1,27 @@
+/*****************************************************************************
+* | File        :   bench_cases.h
+* | Function    :   Benchmark cases shared by the target and host builds
+* | Info        :
+*----------------
+* | bench_cases_run covers the table text formatting of
+* | Widgets_Apply_Updates and, with BENCH_LVGL, lv_table_set_cell_value and
+* | the software blend (fill, fill at 50 % opacity, copy) on a draw buffer
+* | slice. The LVGL cases need lv_init and a registered display.
+* |
+* | The transport cases move BENCH_IO_BYTES per iteration through
+* | usb_cdc_transport.c; the caller provides the far end of the link.
+******************************************************************************/
+#ifndef _BENCH_CASES_H_
+#define _BENCH_CASES_H_
+
+#include <stdint.h>
+#include "bench.h"
+
+#define BENCH_IO_BYTES  64    // A small XRCE frame
+
+void bench_cases_run(void);
+void bench_cdc_write(void *arg, uint32_t iterations);
+void bench_cdc_read(void *arg, uint32_t iterations);
+void bench_cdc_read_poll(void *arg, uint32_t iterations);
+
+#endif
@@ -0,0 +1,141 @@
+/*****************************************************************************
+* | File        :   boot.c
+* | Function    :   Boot sequencing and start up timeline
+* | Info        :
+*----------------
+* | Each core appends only to its own steps, and an event's time is stored
+* | before its flag, so the cores share the timeline without a lock.
+******************************************************************************/
+#include "boot.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#define CORES   2
+
+static boot_step_t steps[CORES][BOOT_MAX_STEPS];
+static volatile uint8_t step_count[CORES];
+static volatile uint32_t event_us[BOOT_EVENTS];
+static volatile bool event_reached[BOOT_EVENTS];
+
+static const char *const event_names[BOOT_EVENTS] = {
+    "bus_ready",
+    "sensors_ready",
+    "first_frame",
+    "ros_ready",
+};
+
+/********************************************************************************
+function:	Start a step of the calling core's timeline
+parameter:
+return:     Step handle for boot_end, -1 when the timeline is full
+********************************************************************************/
+int boot_begin(const char *name)
+{
+    uint core = get_core_num();
+    uint8_t n = step_count[core];
+    if(n >= BOOT_MAX_STEPS)
+        return -1;
+    steps[core][n].name = name;
+    steps[core][n].start_us = time_us_32();
+    steps[core][n].end_us = 0;
+    step_count[core] = n + 1;
+    return n;
+}
+
+void boot_end(int step)
+{
+    if(step >= 0)
+        steps[get_core_num()][step].end_us = time_us_32();
+}
+
+/********************************************************************************
+function:	Mark an event reached, the first time only, and wake waiters
+parameter:
+********************************************************************************/
+void boot_signal(boot_event_t ev)
+{
+    if(event_reached[ev])
+        return;
+    event_us[ev] = time_us_32();
+    __dmb();
+    event_reached[ev] = true;
+    __sev();
+}
+
+bool boot_reached(boot_event_t ev)
+{
+    return event_reached[ev];
+}
+
+void boot_wait(boot_event_t ev)
+{
+    while(!event_reached[ev])
+        __wfe();
+}
+
+/********************************************************************************
+function:	Time of an event
+parameter:
+return:     Microseconds since boot, 0 if not reached yet
+********************************************************************************/
+uint32_t boot_event_us(boot_event_t ev)
+{
+    return event_reached[ev] ? event_us[ev] : 0;
+}
+
+/********************************************************************************
+function:	Print the timeline, steps of both cores and then the events
+parameter:
+    buf  : Lines that do not fit are left out
+return:     Bytes written, without the NUL
+********************************************************************************/
+size_t boot_format(char *buf, size_t size)
+{
+    char line[64];
+    size_t len = 0;
+    if(size == 0)
+        return 0;
+    buf[0] = '\0';
+    for(int core = 0; core < CORES; core++)
+    {
+        for(int i = 0; i < step_count[core]; i++)
+        {
+            const boot_step_t *s = &steps[core][i];
+            int n = snprintf(line, sizeof(line), BOOT_PREFIX "%d %lu %lu %s\n", core,
+                             (unsigned long)s->start_us, (unsigned long)s->end_us, s->name);
+            if(n > 0 && len + n < size)
+            {
+                memcpy(buf + len, line, n + 1);
+                len += n;
+            }
+        }
+    }
+    for(int ev = 0; ev < BOOT_EVENTS; ev++)
+    {
+        if(!event_reached[ev])
+            continue;
+        int n = snprintf(line, sizeof(line), BOOT_PREFIX "event %s %lu\n", event_names[ev],
+                         (unsigned long)event_us[ev]);
+        if(n > 0 && len + n < size)
+        {
+            memcpy(buf + len, line, n + 1);
+            len += n;
+        }
+    }
+    return len;
+}
+
+/********************************************************************************
+function:	Print the timeline on stdio
+parameter:
+********************************************************************************/
+void boot_dump(void)
+{
+    static char buf[(BOOT_MAX_STEPS * 2 + BOOT_EVENTS) * 64];
+    boot_format(buf, sizeof(buf));
+    fputs(buf, stdout);
+    fflush(stdout);
+}
@@ -0,0 +1,58 @@
+/*****************************************************************************
+* | File        :   boot.h
+* | Function    :   Boot sequencing and start up timeline
+* | Info        :
+*----------------
+* | BOOT_STEP times one initialisation on the calling core into that
+* | core's timeline, so the two cores record without a lock. Milestones
+* | are boot_events: a core that needs another core's work done waits for
+* | its event in __wfe, and boot_signal wakes it with __sev; signal may be
+* | called from IRQ context. Times are time_us_32, microseconds since boot.
+* |
+* | The timeline is printed with boot_format, or on stdio with boot_dump, as
+* | text lines:
+* |   BOOT <core> <start_us> <end_us> <step>
+* |   BOOT event <name> <us>                  for each event reached
+******************************************************************************/
+#ifndef _BOOT_H_
+#define _BOOT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define BOOT_MAX_STEPS      16      // Per core, further steps are not recorded
+#define BOOT_PREFIX         "BOOT "
+
+typedef enum {
+    BOOT_BUS_READY = 0,       // DEV_Module_Init: GPIO, SPI, I2C and PWM set up
+    BOOT_SENSORS_READY,       // RTC, touch controller and IMU initialised
+    BOOT_FIRST_FRAME,         // The last flush of the first LVGL frame is done
+    BOOT_ROS_READY,           // pico_node and its entities created
+    BOOT_EVENTS
+} boot_event_t;
+
+typedef struct {
+    const char *name;
+    uint32_t start_us;
+    uint32_t end_us;
+} boot_step_t;
+
+int  boot_begin(const char *name);
+void boot_end(int step);
+void boot_signal(boot_event_t ev);
+bool boot_reached(boot_event_t ev);
+void boot_wait(boot_event_t ev);
+uint32_t boot_event_us(boot_event_t ev);
+size_t boot_format(char *buf, size_t size);
+void boot_dump(void);
+
+// Run a statement as a named step of the timeline
+#define BOOT_STEP(name, stmt)           \
+    do {                                \
+        int boot_step_ = boot_begin(name); \
+        stmt;                           \
+        boot_end(boot_step_);           \
+    } while (0)
+
+#endif
@@ -0,0 +1,260 @@
+#include "dma_uart_transport.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/uart.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+#define RX_SIZE (1u << DMA_UART_RX_SIZE_LOG2)
+
+/*
+ * The RX channel writes into a ring aligned to its size (DMA address
+ * wrapping) and counts down from 0xffffffff. When the count runs out it
+ * chains to a control channel that reloads the count and retriggers it,
+ * so RX never stops. The ring position comes from the write address and
+ * the number of new bytes from the change in the transfer count.
+ *
+ * The DMA has no interrupt per byte, so a waiting executor is woken by a
+ * one-shot falling edge interrupt on the RX pin instead: the first start
+ * bit fires it, and it disables itself until armed again.
+ */
+
+static uint8_t rx_ring[RX_SIZE] __attribute__((aligned(RX_SIZE)));
+static uint8_t tx_buf[DMA_UART_TX_SIZE];
+static const uint32_t rx_reload = 0xffffffffu;
+
+static uart_inst_t *uart = DMA_UART_INSTANCE;
+static uint tx_pin = DMA_UART_TX_PIN;
+static uint rx_pin = DMA_UART_RX_PIN;
+static uint32_t baud = DMA_UART_BAUD;
+
+static int rx_dma = -1;
+static int rx_ctrl_dma = -1;
+static int tx_dma = -1;
+static uint32_t rx_last_count;
+static uint32_t rx_tail;
+static uint32_t rx_level;
+static uint32_t idle_us;
+static dma_uart_transport_stats_t stats;
+static void (*volatile rx_callback)(void);
+static bool rx_irq_added;
+
+static void rx_update(void);
+
+void dma_uart_transport_config(uart_inst_t *u, uint tx, uint rx, uint32_t b)
+{
+    uart = u;
+    tx_pin = tx;
+    rx_pin = rx;
+    baud = b;
+}
+
+void dma_uart_transport_get_stats(dma_uart_transport_stats_t *out)
+{
+    *out = stats;
+}
+
+void dma_uart_transport_set_rx_callback(void (*callback)(void))
+{
+    rx_callback = callback;
+}
+
+static void rx_edge_irq(void)
+{
+    if (gpio_get_irq_event_mask(rx_pin) & GPIO_IRQ_EDGE_FALL)
+    {
+        gpio_acknowledge_irq(rx_pin, GPIO_IRQ_EDGE_FALL);
+        gpio_set_irq_enabled(rx_pin, GPIO_IRQ_EDGE_FALL, false);
+        void (*callback)(void) = rx_callback;
+        if (callback != NULL)
+        {
+            callback();
+        }
+    }
+}
+
+void dma_uart_transport_wake_on_rx(bool enable)
+{
+    if (!enable)
+    {
+        gpio_set_irq_enabled(rx_pin, GPIO_IRQ_EDGE_FALL, false);
+        return;
+    }
+    if (!rx_irq_added)
+    {
+        gpio_add_raw_irq_handler(rx_pin, rx_edge_irq);
+        irq_set_enabled(IO_IRQ_BANK0, true);
+        rx_irq_added = true;
+    }
+    // Drop an edge from before, it was a byte the ring already holds
+    gpio_acknowledge_irq(rx_pin, GPIO_IRQ_EDGE_FALL);
+    gpio_set_irq_enabled(rx_pin, GPIO_IRQ_EDGE_FALL, true);
+}
+
+size_t dma_uart_transport_available(void)
+{
+    if (rx_dma < 0)
+    {
+        return 0;
+    }
+    rx_update();
+    return rx_level;
+}
+
+bool dma_uart_transport_open(struct uxrCustomTransport * transport)
+{
+    if (rx_dma >= 0)
+    {
+        return true;
+    }
+
+    stats.baud = uart_init(uart, baud);
+    gpio_set_function(tx_pin, GPIO_FUNC_UART);
+    gpio_set_function(rx_pin, GPIO_FUNC_UART);
+    uart_set_fifo_enabled(uart, true);
+    idle_us = MAX(DMA_UART_IDLE_CHARS * 10 * 1000000u / stats.baud, 20u);
+
+    rx_dma = dma_claim_unused_channel(true);
+    rx_ctrl_dma = dma_claim_unused_channel(true);
+    tx_dma = dma_claim_unused_channel(true);
+
+    dma_channel_config c = dma_channel_get_default_config(rx_ctrl_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    dma_channel_configure(rx_ctrl_dma, &c,
+                          &dma_hw->ch[rx_dma].al1_transfer_count_trig,
+                          &rx_reload, 1, false);
+
+    c = dma_channel_get_default_config(rx_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, DMA_UART_RX_SIZE_LOG2);
+    channel_config_set_dreq(&c, uart_get_dreq(uart, false));
+    channel_config_set_chain_to(&c, rx_ctrl_dma);
+    rx_last_count = rx_reload;
+    rx_tail = 0;
+    rx_level = 0;
+    dma_channel_configure(rx_dma, &c, rx_ring, &uart_get_hw(uart)->dr, rx_reload, true);
+
+    c = dma_channel_get_default_config(tx_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, uart_get_dreq(uart, true));
+    dma_channel_configure(tx_dma, &c, &uart_get_hw(uart)->dr, tx_buf, 0, false);
+    return true;
+}
+
+bool dma_uart_transport_close(struct uxrCustomTransport * transport)
+{
+    if (rx_dma < 0)
+    {
+        return true;
+    }
+    // Stop the reload first so the abort sticks
+    hw_write_masked(&dma_hw->ch[rx_dma].al1_ctrl,
+                    (uint32_t)rx_dma << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB,
+                    DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS);
+    dma_channel_abort(rx_ctrl_dma);
+    dma_channel_abort(rx_dma);
+    dma_channel_abort(tx_dma);
+    dma_channel_unclaim(rx_dma);
+    dma_channel_unclaim(rx_ctrl_dma);
+    dma_channel_unclaim(tx_dma);
+    rx_dma = rx_ctrl_dma = tx_dma = -1;
+    uart_deinit(uart);
+    return true;
+}
+
+static void rx_update(void)
+{
+    uint32_t count = dma_channel_hw_addr(rx_dma)->transfer_count;
+    uint32_t received = rx_last_count - count;
+    rx_last_count = count;
+    stats.rx_bytes += received;
+    rx_level += received;
+    if (rx_level > RX_SIZE)
+    {
+        // The oldest bytes have been overwritten, keep the newest RX_SIZE
+        stats.rx_overruns += rx_level - RX_SIZE;
+        rx_level = RX_SIZE;
+        rx_tail = (uint8_t *)dma_channel_hw_addr(rx_dma)->write_addr - rx_ring;
+    }
+    if (rx_level > stats.rx_level_max)
+    {
+        stats.rx_level_max = rx_level;
+    }
+}
+
+size_t dma_uart_transport_write(struct uxrCustomTransport * transport, const uint8_t *buf, size_t len, uint8_t *errcode)
+{
+    // A full staging buffer takes this long to go out, plus margin
+    uint32_t chunk_us = DMA_UART_TX_SIZE * 10 * 1000000ull / stats.baud + 1000;
+    size_t sent = 0;
+    while (sent < len)
+    {
+        absolute_time_t deadline = make_timeout_time_us(chunk_us);
+        while (dma_channel_is_busy(tx_dma))
+        {
+            if (time_reached(deadline))
+            {
+                *errcode = 1;
+                return sent;
+            }
+            tight_loop_contents();
+        }
+        size_t n = MIN(len - sent, DMA_UART_TX_SIZE);
+        memcpy(tx_buf, buf + sent, n);
+        dma_channel_transfer_from_buffer_now(tx_dma, tx_buf, n);
+        sent += n;
+    }
+    stats.tx_bytes += sent;
+    return sent;
+}
+
+size_t dma_uart_transport_read(struct uxrCustomTransport * transport, uint8_t *buf, size_t len, int timeout, uint8_t *errcode)
+{
+    absolute_time_t deadline = make_timeout_time_ms(timeout);
+    uint32_t last_level = rx_level;
+    uint64_t last_change_us = time_us_64();
+    for (;;)
+    {
+        rx_update();
+        if (rx_level >= len)
+        {
+            break;
+        }
+        uint64_t now = time_us_64();
+        if (rx_level != last_level)
+        {
+            last_level = rx_level;
+            last_change_us = now;
+        }
+        else if (rx_level > 0 && now - last_change_us >= idle_us)
+        {
+            break; // Line idle, hand over what arrived
+        }
+        if (time_reached(deadline))
+        {
+            if (rx_level == 0)
+            {
+                *errcode = 1;
+                return 0;
+            }
+            break;
+        }
+        sleep_us(idle_us / 2);
+    }
+
+    size_t n = MIN(len, rx_level);
+    size_t first = MIN(n, RX_SIZE - rx_tail);
+    memcpy(buf, rx_ring + rx_tail, first);
+    memcpy(buf + first, rx_ring, n - first);
+    rx_tail = (rx_tail + n) & (RX_SIZE - 1);
+    rx_level -= n;
+    return n;
+}
@@ -0,0 +1,63 @@
+#ifndef _DMA_UART_TRANSPORT_H_
+#define _DMA_UART_TRANSPORT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "hardware/uart.h"
+
+#include <uxr/client/profile/transport/custom/custom_transport.h>
+
+/*
+ * micro-ROS custom transport over a hardware UART, for agents reached
+ * through a UART bridge. RX is written by a DMA channel into a circular
+ * buffer, so no byte is lost while the executor is busy; a read returns
+ * once the requested length has arrived or the line has been idle for
+ * DMA_UART_IDLE_CHARS character times. TX is sent by DMA from a staging
+ * buffer, so write returns while the previous frame is still going out.
+ *
+ * Defaults can be overridden with compile definitions, or at boot with
+ * dma_uart_transport_config before the transport is opened.
+ *
+ * For an event driven executor, dma_uart_transport_wake_on_rx arms a one
+ * shot interrupt on the next start bit that calls the RX callback, and
+ * dma_uart_transport_available tells whether a read would return data.
+ */
+
+#ifndef DMA_UART_INSTANCE
+#define DMA_UART_INSTANCE   uart0
+#endif
+#ifndef DMA_UART_TX_PIN
+#define DMA_UART_TX_PIN     0
+#endif
+#ifndef DMA_UART_RX_PIN
+#define DMA_UART_RX_PIN     1
+#endif
+#ifndef DMA_UART_BAUD
+#define DMA_UART_BAUD       921600
+#endif
+
+#define DMA_UART_RX_SIZE_LOG2 11    // 2 KB ring
+#define DMA_UART_TX_SIZE      512
+#define DMA_UART_IDLE_CHARS   4
+
+typedef struct {
+    uint32_t baud;              // Actual baud after uart_init
+    uint32_t rx_bytes;
+    uint32_t tx_bytes;
+    uint32_t rx_overruns;       // Bytes overwritten before they were read
+    uint32_t rx_level_max;      // Peak ring fill
+} dma_uart_transport_stats_t;
+
+void dma_uart_transport_config(uart_inst_t *uart, uint tx_pin, uint rx_pin, uint32_t baud);
+void dma_uart_transport_get_stats(dma_uart_transport_stats_t *stats);
+void dma_uart_transport_set_rx_callback(void (*callback)(void));
+void dma_uart_transport_wake_on_rx(bool enable);
+size_t dma_uart_transport_available(void);
+
+bool dma_uart_transport_open(struct uxrCustomTransport * transport);
+bool dma_uart_transport_close(struct uxrCustomTransport * transport);
+size_t dma_uart_transport_write(struct uxrCustomTransport* transport, const uint8_t * buf, size_t len, uint8_t * err);
+size_t dma_uart_transport_read(struct uxrCustomTransport* transport, uint8_t* buf, size_t len, int timeout, uint8_t* err);
+
+#endif //_DMA_UART_TRANSPORT_H_
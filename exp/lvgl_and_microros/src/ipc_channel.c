@@ -0,0 +1,307 @@
+/*****************************************************************************
+* | File        :   ipc_channel.c
+* | Function    :   Typed shared memory channels between core0 and core1
+* | Info        :
+*----------------
+* | SRAM is coherent between the two cores, so a single producer / single
+* | consumer ring only needs ordered stores: the slot is written before the
+* | head moves, and read before the tail moves. The hardware spinlock only
+* | protects the statistics, which are updated from both sides. It is one
+* | of the SDK's striped locks: the sections are a few stores long and
+* | take no other lock, so sharing costs nothing and claims none of the
+* | 8 free locks (see IPC_CLAIMED_SPIN_LOCKS).
+* |
+* | Mailboxes swap slot indexes instead, which takes a read-modify-write on
+* | both cores; the M0+ has no exclusive access, so the swap is done under
+* | the mailbox spinlock.
+******************************************************************************/
+#include "ipc_channel.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/irq.h"
+
+#include "trace.h"
+
+IPC_CHANNEL_DEFINE(ipc_sensor_channel,  ipc_imu_sample_t, IPC_SENSOR_SLOTS);
+IPC_CHANNEL_DEFINE(ipc_command_channel, ipc_cmd_t,        IPC_COMMAND_SLOTS);
+IPC_CHANNEL_DEFINE(ipc_mirror_channel,  ipc_mirror_chunk_t, IPC_MIRROR_SLOTS);
+IPC_CHANNEL_DEFINE(ipc_input_channel,   ipc_input_event_t, IPC_INPUT_SLOTS);
+IPC_MAILBOX_DEFINE(ipc_dashboard_mailbox, ipc_dashboard_t);
+IPC_MAILBOX_DEFINE(ipc_telemetry_mailbox, ipc_ui_telemetry_t);
+
+static uint8_t next_id;
+static void (*volatile doorbell_callback[2])(uint32_t pending);
+
+/********************************************************************************
+function:	Initialise the standard channels. Call on core0 before core1 is
+            launched.
+parameter:
+********************************************************************************/
+void ipc_init(void)
+{
+    ipc_channel_init(&ipc_sensor_channel);
+    ipc_channel_init(&ipc_command_channel);
+    ipc_channel_init(&ipc_mirror_channel);
+    ipc_channel_init(&ipc_input_channel);
+    ipc_mailbox_init(&ipc_dashboard_mailbox);
+    ipc_mailbox_init(&ipc_telemetry_mailbox);
+}
+
+void ipc_channel_init(ipc_channel_t *ch)
+{
+    if (ch->lock == NULL)
+    {
+        ch->lock = spin_lock_instance(next_striped_spin_lock_num());
+        ch->id = next_id++;
+    }
+    ch->head = 0;
+    ch->tail = 0;
+    ch->doorbell_core = -1;
+    memset(&ch->stats, 0, sizeof(ipc_channel_stats_t));
+    ch->stats.latency_us_min = UINT32_MAX;
+}
+
+#if !LVGLPROJ_FREERTOS
+static void ipc_doorbell_irq(void)
+{
+    uint core = get_core_num();
+    uint32_t pending = 0;
+    while (multicore_fifo_rvalid())
+    {
+        uint32_t id = multicore_fifo_pop_blocking();
+        if (id < 32)
+            pending |= 1u << id;
+    }
+    multicore_fifo_clear_irq();
+    TRACE_INSTANT(TRACE_DOORBELL_IRQ, pending);
+
+    void (*callback)(uint32_t) = doorbell_callback[core];
+    if (callback != NULL && pending != 0)
+        callback(pending);
+}
+#endif
+
+static void ring_doorbell(int8_t core, uint8_t id)
+{
+#if LVGLPROJ_FREERTOS
+    void (*callback)(uint32_t) = core >= 0 ? doorbell_callback[core] : NULL;
+    if (callback != NULL)
+        callback(1u << id);
+#else
+    // A full FIFO is not pushed: its words are still unread, so the SIO IRQ
+    // is already pending on the consumer core and will see this commit too
+    if (core >= 0 && core != (int8_t)get_core_num() && multicore_fifo_wready())
+    {
+        // Before the push, or the consumer's IRQ instant can come first
+        TRACE_INSTANT(TRACE_DOORBELL_RING, id);
+        multicore_fifo_push_blocking(id);
+    }
+#endif
+}
+
+/********************************************************************************
+function:	Set a function called from the doorbell IRQ of the calling core
+parameter:
+********************************************************************************/
+void ipc_doorbell_set_callback(void (*callback)(uint32_t pending))
+{
+    doorbell_callback[get_core_num()] = callback;
+}
+
+static int8_t doorbell_enable(void)
+{
+    uint core = get_core_num();
+#if !LVGLPROJ_FREERTOS
+    uint irq_num = core ? SIO_IRQ_PROC1 : SIO_IRQ_PROC0;
+    if (!irq_is_enabled(irq_num))
+    {
+        multicore_fifo_drain();
+        multicore_fifo_clear_irq();
+        irq_set_exclusive_handler(irq_num, ipc_doorbell_irq);
+        irq_set_enabled(irq_num, true);
+    }
+#endif
+    return (int8_t)core;
+}
+
+/********************************************************************************
+function:	Ring the calling (consumer) core on every commit to this channel
+parameter:
+********************************************************************************/
+void ipc_channel_enable_doorbell(ipc_channel_t *ch)
+{
+    ch->doorbell_core = doorbell_enable();
+}
+
+/********************************************************************************
+function:	Reserve the next free slot for the producer to fill in place
+parameter:
+return:     Slot pointer, or NULL (and an overflow counted) if the ring is full
+********************************************************************************/
+void *ipc_channel_reserve(ipc_channel_t *ch)
+{
+    uint32_t h = ch->head;
+    if (h - ch->tail >= ch->slots)
+    {
+        uint32_t save = spin_lock_blocking(ch->lock);
+        ch->stats.overflows++;
+        spin_unlock(ch->lock, save);
+        return NULL;
+    }
+    return ch->buffer + (h & (ch->slots - 1)) * ch->elem_size;
+}
+
+/********************************************************************************
+function:	Publish the slot returned by the last reserve
+parameter:
+********************************************************************************/
+void ipc_channel_commit(ipc_channel_t *ch)
+{
+    uint32_t h = ch->head;
+    ch->stamps[h & (ch->slots - 1)] = time_us_32();
+    __dmb();
+    ch->head = h + 1;
+
+    ring_doorbell(ch->doorbell_core, ch->id);
+}
+
+/********************************************************************************
+function:	Copy one element into the channel
+parameter:
+return:     false if the ring was full
+********************************************************************************/
+bool ipc_channel_push(ipc_channel_t *ch, const void *elem)
+{
+    void *slot = ipc_channel_reserve(ch);
+    if (slot == NULL)
+        return false;
+    memcpy(slot, elem, ch->elem_size);
+    ipc_channel_commit(ch);
+    return true;
+}
+
+/********************************************************************************
+function:	Oldest committed element, valid until ipc_channel_release
+parameter:
+return:     Element pointer, or NULL when the channel is empty
+********************************************************************************/
+const void *ipc_channel_peek(ipc_channel_t *ch)
+{
+    uint32_t t = ch->tail;
+    if (t == ch->head)
+        return NULL;
+    __dmb();
+    return ch->buffer + (t & (ch->slots - 1)) * ch->elem_size;
+}
+
+void ipc_channel_release(ipc_channel_t *ch)
+{
+    uint32_t t = ch->tail;
+    uint32_t latency_us = time_us_32() - ch->stamps[t & (ch->slots - 1)];
+    __dmb();
+    ch->tail = t + 1;
+
+    uint32_t save = spin_lock_blocking(ch->lock);
+    ch->stats.messages++;
+    ch->stats.latency_us_total += latency_us;
+    if (latency_us < ch->stats.latency_us_min)
+        ch->stats.latency_us_min = latency_us;
+    if (latency_us > ch->stats.latency_us_max)
+        ch->stats.latency_us_max = latency_us;
+    spin_unlock(ch->lock, save);
+}
+
+uint32_t ipc_channel_count(const ipc_channel_t *ch)
+{
+    return ch->head - ch->tail;
+}
+
+void ipc_channel_get_stats(ipc_channel_t *ch, ipc_channel_stats_t *stats)
+{
+    uint32_t save = spin_lock_blocking(ch->lock);
+    *stats = ch->stats;
+    spin_unlock(ch->lock, save);
+}
+
+void ipc_mailbox_init(ipc_mailbox_t *mb)
+{
+    if (mb->lock == NULL)
+    {
+        mb->lock = spin_lock_instance(next_striped_spin_lock_num());
+        mb->id = next_id++;
+    }
+    mb->back = 0;
+    mb->middle = 1;
+    mb->front = 2;
+    mb->doorbell_core = -1;
+    memset(&mb->stats, 0, sizeof(ipc_mailbox_stats_t));
+}
+
+/********************************************************************************
+function:	Ring the calling (consumer) core on every publish to this mailbox
+parameter:
+********************************************************************************/
+void ipc_mailbox_enable_doorbell(ipc_mailbox_t *mb)
+{
+    mb->doorbell_core = doorbell_enable();
+}
+
+/********************************************************************************
+function:	Slot for the producer to fill in place. It holds whatever was
+            published two values ago, so fill every field.
+parameter:
+return:     Slot pointer, owned by the producer until ipc_mailbox_publish
+********************************************************************************/
+void *ipc_mailbox_write(ipc_mailbox_t *mb)
+{
+    return mb->buffer + mb->back * mb->elem_size;
+}
+
+/********************************************************************************
+function:	Make the slot returned by ipc_mailbox_write the latest value
+parameter:
+********************************************************************************/
+void ipc_mailbox_publish(ipc_mailbox_t *mb)
+{
+    __dmb();
+    uint32_t save = spin_lock_blocking(mb->lock);
+    uint8_t old = mb->middle;
+    mb->middle = mb->back | IPC_MAILBOX_FRESH;
+    mb->back = old & ~IPC_MAILBOX_FRESH;
+    mb->stats.writes++;
+    if (old & IPC_MAILBOX_FRESH)
+        mb->stats.overwritten++;
+    spin_unlock(mb->lock, save);
+
+    ring_doorbell(mb->doorbell_core, mb->id);
+}
+
+/********************************************************************************
+function:	Latest published value, read in place. Valid until the next call.
+parameter:
+return:     Value pointer, or NULL when nothing was published since last read
+********************************************************************************/
+const void *ipc_mailbox_read(ipc_mailbox_t *mb)
+{
+    if (!(mb->middle & IPC_MAILBOX_FRESH))
+        return NULL;
+
+    uint32_t save = spin_lock_blocking(mb->lock);
+    uint8_t old = mb->middle;
+    mb->middle = mb->front;
+    mb->front = old & ~IPC_MAILBOX_FRESH;
+    mb->stats.reads++;
+    spin_unlock(mb->lock, save);
+
+    __dmb();
+    return mb->buffer + mb->front * mb->elem_size;
+}
+
+void ipc_mailbox_get_stats(ipc_mailbox_t *mb, ipc_mailbox_stats_t *stats)
+{
+    uint32_t save = spin_lock_blocking(mb->lock);
+    *stats = mb->stats;
+    spin_unlock(mb->lock, save);
+}
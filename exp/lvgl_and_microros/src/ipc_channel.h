@@ -0,0 +1,226 @@
+/*****************************************************************************
+* | File        :   ipc_channel.h
+* | Function    :   Typed shared memory channels between core0 and core1
+* | Info        :
+*----------------
+* | Each channel is a single producer, single consumer ring of fixed size
+* | slots. The producer reserves a slot, fills it in place and commits it;
+* | the consumer peeks the slot in place and releases it, so nothing is
+* | copied. A full ring counts an overflow instead of blocking.
+* |
+* | The consumer core may enable a doorbell: every commit then pushes the
+* | channel id through the multicore FIFO, raising the SIO IRQ (and waking a
+* | __wfe) on the consumer core. Latency is measured from commit to release.
+* | The FreeRTOS SMP port owns the FIFO, so with LVGLPROJ_FREERTOS the
+* | doorbell callback is called directly by the producer instead.
+* |
+* | A mailbox holds only the latest value. It is triple buffered: the
+* | producer fills its own slot and swaps it with the shared one, the consumer
+* | swaps the shared slot for its own when it is newer and reads it in place.
+* | Neither side ever waits for the other or copies a value across.
+******************************************************************************/
+#ifndef _IPC_CHANNEL_H_
+#define _IPC_CHANNEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/sync.h"
+
+/*
+ * Hardware spinlocks claimed with spin_lock_claim_unused, which panics once
+ * the 8 free ones are gone: sched, ui_queue and uros_time. Channels and
+ * mailboxes use striped locks. Count any new claim here.
+ */
+#define IPC_CLAIMED_SPIN_LOCKS 3
+#if IPC_CLAIMED_SPIN_LOCKS > PICO_SPINLOCK_ID_CLAIM_FREE_LAST - PICO_SPINLOCK_ID_CLAIM_FREE_FIRST + 1
+#error "More spin_lock_claim_unused calls than free hardware spinlocks"
+#endif
+
+typedef struct {
+    uint32_t messages;
+    uint32_t overflows;
+    uint32_t latency_us_min;
+    uint32_t latency_us_max;
+    uint64_t latency_us_total;
+} ipc_channel_stats_t;
+
+typedef struct {
+    const char *name;
+    uint8_t *buffer;
+    uint32_t *stamps;             // time_us_32 at commit, per slot
+    uint16_t elem_size;
+    uint16_t slots;               // Must be a power of two
+    uint8_t id;
+    volatile int8_t doorbell_core; // -1 when no doorbell
+    volatile uint32_t head;       // Written by the producer only
+    volatile uint32_t tail;       // Written by the consumer only
+    spin_lock_t *lock;            // Guards stats
+    ipc_channel_stats_t stats;
+} ipc_channel_t;
+
+#define IPC_CHANNEL_DEFINE(var, type, nslots)                   \
+    static type var##_buffer[nslots];                           \
+    static uint32_t var##_stamps[nslots];                       \
+    ipc_channel_t var = {                                       \
+        .name = #var,                                           \
+        .buffer = (uint8_t *)var##_buffer,                      \
+        .stamps = var##_stamps,                                 \
+        .elem_size = sizeof(type),                              \
+        .slots = nslots,                                        \
+    }
+
+typedef struct {
+    uint32_t writes;
+    uint32_t reads;
+    uint32_t overwritten;         // Values replaced before the consumer read them
+} ipc_mailbox_stats_t;
+
+typedef struct {
+    const char *name;
+    uint8_t *buffer;              // Three slots of elem_size
+    uint16_t elem_size;
+    uint8_t id;                   // Shares the doorbell id space with channels
+    volatile int8_t doorbell_core; // -1 when no doorbell
+    uint8_t back;                 // Slot owned by the producer
+    uint8_t front;                // Slot owned by the consumer
+    volatile uint8_t middle;      // Latest published slot, IPC_MAILBOX_FRESH if unread
+    spin_lock_t *lock;            // Guards middle and stats
+    ipc_mailbox_stats_t stats;
+} ipc_mailbox_t;
+
+#define IPC_MAILBOX_FRESH 0x80
+
+#define IPC_MAILBOX_DEFINE(var, type)                           \
+    static type var##_buffer[3];                                \
+    ipc_mailbox_t var = {                                       \
+        .name = #var,                                           \
+        .buffer = (uint8_t *)var##_buffer,                      \
+        .elem_size = sizeof(type),                              \
+    }
+
+/* Sensor samples, core1 (UI) to core0 (micro-ROS) */
+#ifndef IMU_SAMPLE_RATE_HZ
+#define IMU_SAMPLE_RATE_HZ 100    // 100-400
+#endif
+#define IMU_SAMPLE_PERIOD_US ((1000000 + IMU_SAMPLE_RATE_HZ / 2) / IMU_SAMPLE_RATE_HZ)
+
+typedef struct {
+    uint64_t timestamp_us;        // time_us_64 when the sample was read
+    float acc[3];                 // mg
+    float gyro[3];                // dps
+    uint32_t skipped;             // Sampling releases missed since boot
+} ipc_imu_sample_t;
+
+/* Commands, core0 (micro-ROS) to core1 (UI) */
+typedef enum {
+    IPC_CMD_BACKLIGHT = 0,        // value 1-10
+    IPC_CMD_BEEP,                 // value 0 off, 1 on
+    IPC_CMD_REFR_PERIOD,          // value ms, LVGL display refresh timer
+    IPC_CMD_INDEV_PERIOD,         // value ms, touch read timer
+    IPC_CMD_MAX_IDLE,             // value ms, longest sleep of the LVGL task
+    IPC_CMD_RTC_PERIOD,           // value ms, RTC table update
+    IPC_CMD_IMU_PERIOD,           // value us, IMU sampling
+    IPC_CMD_SPI_CLOCK,            // value Hz, LCD SPI clock
+    IPC_CMD_MIRROR,               // value 0 off, 1 on (and send a full frame)
+    IPC_CMD_TYPES
+} ipc_cmd_id_t;
+
+typedef struct {
+    uint16_t id;                  // ipc_cmd_id_t
+    uint16_t reserved;
+    int32_t value;
+} ipc_cmd_t;
+
+/* Dashboard meters on tile1, core0 (micro-ROS) to core1 (UI), latest only */
+typedef struct {
+    uint64_t publish_us;          // Agent publish time on the time_us_64 clock
+    uint64_t receive_us;          // time_us_64 when the executor took the message
+    float jog[2];                 // meterJog arcs: red from -10, green from +10
+    float state[2];               // meterState arcs, same layout
+    float axis[2];                // meterX, meterZ
+} ipc_dashboard_t;
+
+/* UI core performance snapshot, core1 (UI) to core0 (micro-ROS), latest only */
+typedef struct {
+    uint32_t interval_us;         // Covered by the rates and percentiles
+    uint8_t cpu_load_pct;         // Scheduler busy share of core1
+    uint8_t flush_busy_pct;       // Share of the interval the SPI DMA ran
+    uint8_t heap_frag_pct;
+    uint32_t frames;              // Refreshes flushed in the interval
+    uint32_t frame_us_p50;        // Render start to last flush done
+    uint32_t frame_us_p90;
+    uint32_t frame_us_p99;
+    uint32_t frame_us_max;
+    uint32_t flush_bytes_per_s;
+    uint32_t heap_live;
+    uint32_t heap_peak;
+    uint32_t heap_free;
+    uint32_t heap_largest_free;
+    uint32_t heap_failures;
+    uint32_t input_events;        // Injected input events applied, total
+    uint32_t input_late_us_max;   // Latest injected event behind its time
+} ipc_ui_telemetry_t;
+
+/* Screen mirror chunks, core1 (UI) to core0 (micro-ROS), see ui_mirror.h */
+#define IPC_MIRROR_CHUNK  400       // Header and RLE data, one best effort message
+typedef struct {
+    uint64_t flush_us;            // time_us_64 when the area was flushed
+    uint16_t len;                 // Bytes used in data
+    uint8_t data[IPC_MIRROR_CHUNK];
+} ipc_mirror_chunk_t;
+
+/* Injected input, core0 (micro-ROS) to core1 (UI), see ui_input.h */
+typedef enum {
+    IPC_INPUT_PRESS = 0,          // Pointer pressed, or moved while pressed, at x, y
+    IPC_INPUT_RELEASE,            // Pointer released
+    IPC_INPUT_KEY,                // Key x (LV_KEY_* or a character) pressed and released
+    IPC_INPUT_GESTURE,            // Touch controller gesture x (CST816S_Gesture_*)
+    IPC_INPUT_TYPES
+} ipc_input_type_t;
+
+typedef struct {
+    uint64_t at_us;               // time_us_64 when the event is due
+    uint8_t type;                 // ipc_input_type_t
+    uint8_t reserved;
+    int16_t x;                    // Panel coordinates, like the touch controller,
+    int16_t y;                    // or the key / gesture code in x
+    uint16_t reserved2;
+} ipc_input_event_t;
+
+#define IPC_SENSOR_SLOTS  64        // 640 ms of samples at 100 Hz, 160 ms at 400 Hz
+#define IPC_COMMAND_SLOTS 16
+#define IPC_MIRROR_SLOTS  16
+#define IPC_INPUT_SLOTS   64        // One full ui_input message
+
+extern ipc_channel_t ipc_sensor_channel;
+extern ipc_channel_t ipc_command_channel;
+extern ipc_channel_t ipc_mirror_channel;
+extern ipc_channel_t ipc_input_channel;
+extern ipc_mailbox_t ipc_dashboard_mailbox;
+extern ipc_mailbox_t ipc_telemetry_mailbox;
+
+void ipc_init(void);
+
+void ipc_channel_init(ipc_channel_t *ch);
+void ipc_channel_enable_doorbell(ipc_channel_t *ch);
+
+void *ipc_channel_reserve(ipc_channel_t *ch);
+void ipc_channel_commit(ipc_channel_t *ch);
+bool ipc_channel_push(ipc_channel_t *ch, const void *elem);
+
+const void *ipc_channel_peek(ipc_channel_t *ch);
+void ipc_channel_release(ipc_channel_t *ch);
+uint32_t ipc_channel_count(const ipc_channel_t *ch);
+
+void ipc_channel_get_stats(ipc_channel_t *ch, ipc_channel_stats_t *stats);
+
+void ipc_mailbox_init(ipc_mailbox_t *mb);
+void ipc_mailbox_enable_doorbell(ipc_mailbox_t *mb);
+void *ipc_mailbox_write(ipc_mailbox_t *mb);
+void ipc_mailbox_publish(ipc_mailbox_t *mb);
+const void *ipc_mailbox_read(ipc_mailbox_t *mb);
+void ipc_mailbox_get_stats(ipc_mailbox_t *mb, ipc_mailbox_stats_t *stats);
+
+void ipc_doorbell_set_callback(void (*callback)(uint32_t pending));
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * LVGL heap soak benchmark, built as LVGLProj_Soak.
+ *
+ * Runs the UI alone on core0 with the real sensor tasks, and adds a soak
+ * task that floods the IMU and RTC tables with changing values and cycles
+ * through the tiles with animation. Every SOAK_REPORT_MS one CSV line of
+ * heap statistics is printed on USB stdio:
+ *
+ * elapsed_s,live,peak,tlsf_free,largest_free,frag_pct,failures,slab_spills,cpu_pct
+ *
+ * Built with the profiler (LVGLPROJ_PROFILER), core0 is sampled from boot
+ * and sending 'p' prints the profile so far as PROF lines and starts a new
+ * one (tools/profile_report.py). Built with the event trace
+ * (LVGLPROJ_TRACE), sending 't' prints the trace as TRACE lines and starts
+ * a new one (tools/trace_export.py). Sending 'b' prints the start up
+ * timeline as BOOT lines (boot.h).
+ */
+#include "LCD_test.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+
+#include "sched.h"
+#include "ui_queue.h"
+#include "ipc_channel.h"
+#include "lv_heap.h"
+#include "stack_guard.h"
+#include "profiler.h"
+#include "trace.h"
+#include "boot.h"
+
+#define SOAK_UPDATE_MS	20
+#define SOAK_TILE_MS	1500
+#define SOAK_REPORT_MS	10000
+#define SOAK_TILES		4
+
+static uint32_t seed = 1;
+static uint32_t ticks;
+static uint8_t tile;
+
+
+static uint32_t soak_rand(void){
+	seed = seed * 1664525u + 1013904223u;
+	return seed >> 8;
+}
+
+static void soak_task(void *arg){
+	for (int i = 0; i < 6; i++){
+		ui_queue_post_float(UI_UPDATE_IMU, i, (float)((int32_t)(soak_rand() % 40000) - 20000) / 10.0f);
+	}
+	ui_queue_post_int(UI_UPDATE_RTC, 0, 2000 + soak_rand() % 100);
+	for (int i = 1; i < 6; i++){
+		ui_queue_post_int(UI_UPDATE_RTC, i, soak_rand() % 60);
+	}
+
+	int c = getchar_timeout_us(0);
+	if (c == 'p' && profiler_running()){
+		profiler_stop();
+		profiler_dump();
+		profiler_start(PROFILER_DEFAULT_HZ);
+	}
+	if (c == 't' && trace_running()){
+		trace_dump();
+		trace_start();
+	}
+	if (c == 'b'){
+		boot_dump();
+	}
+
+	ticks++;
+	if (ticks % (SOAK_TILE_MS / SOAK_UPDATE_MS) == 0){
+		tile = (tile + 1) % SOAK_TILES;
+		Widgets_Show_Tile(tile);
+	}
+	if (ticks % (SOAK_REPORT_MS / SOAK_UPDATE_MS) == 0){
+		lv_heap_stats_t heap;
+		sched_summary_t summary;
+		lv_heap_get_stats(&heap);
+		sched_get_summary(&summary);
+		printf("%lu,%lu,%lu,%lu,%lu,%u,%lu,%lu,%lu\n",
+			(unsigned long)(time_us_64() / 1000000),
+			(unsigned long)heap.live_bytes,
+			(unsigned long)heap.peak_bytes,
+			(unsigned long)heap.tlsf_free,
+			(unsigned long)heap.tlsf_largest_free,
+			heap.frag_pct,
+			(unsigned long)heap.failures,
+			(unsigned long)heap.slab_spills,
+			(unsigned long)summary.utilisation_pct);
+	}
+}
+
+
+
+int main(void)
+{
+	stack_guard_init();
+	stdio_init_all();
+	ipc_init();
+	profiler_init_core();
+	profiler_start(PROFILER_DEFAULT_HZ);
+
+	if (LCD_1in69_LVGL_Init() != 0){
+		return -1;
+	}
+	Sensors_Schedule();
+	sched_add_periodic("soak", soak_task, NULL, SOAK_UPDATE_MS, 0, 2);
+
+	printf("elapsed_s,live,peak,tlsf_free,largest_free,frag_pct,failures,slab_spills,cpu_pct\n");
+	sched_run();
+	return 0;
+}
@@ -3,84 +3,37 @@
 #include "pico/stdlib.h"
 #include "pico/multicore.h"
 
-
 #include <rcl/rcl.h>
-#include <rcl/error_handling.h>
-#include <rclc/rclc.h>
-#include <rclc/executor.h>
-#include <std_msgs/msg/int32.h>
 #include <rmw_microros/rmw_microros.h>
 
-#include "pico_uart_transport.h"
+#include "uros_transport.h"
+#include "ipc_channel.h"
+#include "uros_node.h"
+#include "stack_guard.h"
+#include "profiler.h"
+#include "boot.h"
 
 
 
 void core1_entry() {
+	profiler_init_core();
 	LCD_1in69_LVGL_Test();
 }
 
-rcl_publisher_t publisher;
-std_msgs__msg__Int32 msg;
-
-void timer_callback(rcl_timer_t *timer, int64_t last_call_time)
-{
-    rcl_ret_t ret = rcl_publish(&publisher, &msg, NULL);
-    msg.data++;
-}
-
 
 void uRos(){
-	rmw_uros_set_custom_transport(
-		true,
-		NULL,
-		pico_serial_transport_open,
-		pico_serial_transport_close,
-		pico_serial_transport_write,
-		pico_serial_transport_read
-	);
-
-	rcl_timer_t timer;
-	rcl_node_t node;
-	rcl_allocator_t allocator;
-	rclc_support_t support;
-	rclc_executor_t executor;
-
-	allocator = rcl_get_default_allocator();
-
-	// Wait for agent successful ping for 2 minutes.
-	const int timeout_ms = 1000;
-	const uint8_t attempts = 120;
-
-	rcl_ret_t ret = rmw_uros_ping_agent(timeout_ms, attempts);
-
-	if (ret != RCL_RET_OK)
-	{
-		// Unreachable agent, exiting program.
-		return ret;
-	}
-
-	rclc_support_init(&support, 0, NULL, &allocator);
-
-	rclc_node_init_default(&node, "pico_node", "", &support);
-	rclc_publisher_init_default(
-		&publisher,
-		&node,
-		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, Int32),
-		"pico_publisher");
-
-	rclc_timer_init_default(
-		&timer,
-		&support,
-		RCL_MS_TO_NS(1000),
-		timer_callback);
-
-	rclc_executor_init(&executor, &support.context, 1, &allocator);
-	rclc_executor_add_timer(&executor, &timer);
+	uros_transport_select(UROS_TRANSPORT);
 
+	// Keep trying, the UI runs meanwhile and the agent may start at any time
+	while (!uros_node_init()){
+	}
 
-	msg.data = 0;
 	for (;;){
-		rclc_executor_spin_some(&executor, RCL_MS_TO_NS(100));
+#if UROS_SPIN_EVENT
+		uros_node_spin_event(RCL_MS_TO_NS(1000));
+#else
+		uros_node_spin_some(RCL_MS_TO_NS(100));
+#endif
 	}
 }
 
@@ -88,10 +41,16 @@ void uRos(){
 
 int main(void)
 {
-
+	stack_guard_init();
+	ipc_init();
+	profiler_init_core();
 
 	multicore_launch_core1(core1_entry);
 
+	// The I2C sensors while core1 brings up the LCD and the first frame
+	boot_wait(BOOT_BUS_READY);
+	Sensors_Init();
+
 	uRos();
 
 	for (;;){
@@ -0,0 +1,248 @@
+/*
+ * FreeRTOS SMP variant of main.c, built as LVGLProj_FreeRTOS when the
+ * project is configured with -DLVGLPROJ_FREERTOS=ON.
+ *
+ * core1: lvgl (UI scheduler loop), sensors (IMU and RTC acquisition)
+ * core0: transport (USB CDC receive pump), uros (rclc executor)
+ * any:   report (CPU and latency snapshot, see rtos_report.h)
+ */
+#include "LCD_test.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "tusb.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stream_buffer.h"
+
+#include <rcl/rcl.h>
+#include <rmw_microros/rmw_microros.h>
+#include <uxr/client/profile/transport/custom/custom_transport.h>
+
+#include "pico_uart_transport.h"
+#include "sched.h"
+#include "ipc_channel.h"
+#include "uros_node.h"
+#include "rtos_report.h"
+#include "stack_guard.h"
+#include "profiler.h"
+
+#define TRANSPORT_TASK_PRIORITY	(tskIDLE_PRIORITY + 4)
+#define SENSOR_TASK_PRIORITY	(tskIDLE_PRIORITY + 3)
+#define LVGL_TASK_PRIORITY		(tskIDLE_PRIORITY + 2)
+#define UROS_TASK_PRIORITY		(tskIDLE_PRIORITY + 2)
+#define REPORT_TASK_PRIORITY	(tskIDLE_PRIORITY + 1)
+
+#define TRANSPORT_TASK_STACK	256
+#define SENSOR_TASK_STACK		512
+#define LVGL_TASK_STACK			2048
+#define UROS_TASK_STACK			2560
+#define REPORT_TASK_STACK		512
+
+#define TRANSPORT_RX_BUFFER		512
+#define TRANSPORT_CHUNK			64
+#define TRANSPORT_POLL_MS		10
+#define REPORT_PERIOD_MS		5000
+
+static TaskHandle_t lvgl_handle;
+static TaskHandle_t transport_handle;
+static StreamBufferHandle_t rx_stream;
+static volatile uint64_t rx_available_us;
+
+static rtos_latency_t lvgl_latency;
+static rtos_latency_t sensor_latency;
+static rtos_latency_t transport_latency;
+static rtos_latency_t uros_latency;
+
+
+static inline bool in_isr(void){
+	return __get_current_exception() != 0;
+}
+
+/*
+ * Transport: the USB stack signals received characters from its IRQ, the
+ * pump task moves them into a stream buffer and the executor blocks on it.
+ */
+static void transport_chars_available(void *param){
+	BaseType_t woken = pdFALSE;
+	rx_available_us = time_us_64();
+	vTaskNotifyGiveFromISR(transport_handle, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+static void transport_task(void *params){
+	rtos_latency_attach(&transport_latency);
+	stdio_set_chars_available_callback(transport_chars_available, NULL);
+
+	for (;;){
+		if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TRANSPORT_POLL_MS)) != 0){
+			rtos_latency_record(&transport_latency, rx_available_us);
+		}
+
+		// Whole chunks off the CDC FIFO, masked against tud_task like usb_cdc_transport
+		uint8_t chunk[TRANSPORT_CHUNK];
+		for (;;){
+			uint32_t save = save_and_disable_interrupts();
+			uint32_t n = tud_cdc_available() ? tud_cdc_read(chunk, sizeof(chunk)) : 0;
+			restore_interrupts(save);
+			if (n == 0){
+				break;
+			}
+			xStreamBufferSend(rx_stream, chunk, n, portMAX_DELAY);
+		}
+	}
+}
+
+static bool freertos_transport_open(struct uxrCustomTransport * transport){
+	return true;
+}
+
+static size_t freertos_transport_read(struct uxrCustomTransport * transport, uint8_t *buf, size_t len, int timeout, uint8_t *errcode){
+	TickType_t start = xTaskGetTickCount();
+	TickType_t wait = pdMS_TO_TICKS(timeout);
+	size_t got = 0;
+
+	while (got < len){
+		TickType_t elapsed = xTaskGetTickCount() - start;
+		if (elapsed > wait){
+			break;
+		}
+		got += xStreamBufferReceive(rx_stream, buf + got, len - got, wait - elapsed);
+	}
+	if (got < len){
+		*errcode = 1;
+	}
+	return got;
+}
+
+/*
+ * LVGL: the cooperative scheduler from the bare-metal build runs inside one
+ * task. sched_notify (touch IRQ, DMA, widget queue, commands) unblocks it.
+ */
+static void lvgl_wake(void){
+	if (in_isr()){
+		BaseType_t woken = pdFALSE;
+		vTaskNotifyGiveFromISR(lvgl_handle, &woken);
+		portYIELD_FROM_ISR(woken);
+	} else {
+		xTaskNotifyGive(lvgl_handle);
+	}
+}
+
+static void sensor_task(void *params){
+	rtos_latency_attach(&sensor_latency);
+
+	TickType_t last = xTaskGetTickCount();
+	uint64_t expected_us = time_us_64();
+	uint32_t rtc_elapsed_us = 0;
+
+	for (;;){
+		// Periods can change at run time, see IPC_CMD_IMU_PERIOD. Periods
+		// that are not whole ticks alternate between the neighbouring tick
+		// counts, so the rate holds on average
+		uint32_t period_us = Sensors_Imu_Period_Us();
+		uint64_t prev_ms = expected_us / 1000;
+		expected_us += period_us;
+		vTaskDelayUntil(&last, pdMS_TO_TICKS((uint32_t)(expected_us / 1000 - prev_ms)));
+		rtos_latency_record(&sensor_latency, expected_us);
+
+		Sensors_Imu_Task(NULL);
+		rtc_elapsed_us += period_us;
+		if (rtc_elapsed_us >= Sensors_Rtc_Period_Ms() * 1000){
+			rtc_elapsed_us = 0;
+			Sensors_Rtc_Task(NULL);
+		}
+	}
+}
+
+static void lvgl_task(void *params){
+	rtos_latency_attach(&lvgl_latency);
+	profiler_init_core();
+
+	LCD_1in69_LVGL_Init();
+	sched_set_wake_hook(lvgl_wake);
+
+	// Sensors need the devices and widgets set up by the init above
+	TaskHandle_t handle;
+	xTaskCreate(sensor_task, "sensors", SENSOR_TASK_STACK, NULL, SENSOR_TASK_PRIORITY, &handle);
+	vTaskCoreAffinitySet(handle, 1 << 1);
+
+	for (;;){
+		uint64_t wake_us = sched_run_once();
+		int64_t sleep_us = (int64_t)(wake_us - time_us_64());
+		if (sleep_us > 0){
+			TickType_t ticks = pdMS_TO_TICKS((sleep_us + 999) / 1000);
+			if (ulTaskNotifyTake(pdTRUE, ticks) == 0){
+				rtos_latency_record(&lvgl_latency, wake_us);
+			}
+		}
+	}
+}
+
+static void uros_task(void *params){
+	rtos_latency_attach(&uros_latency);
+	profiler_init_core();
+
+	rmw_uros_set_custom_transport(
+		true,
+		NULL,
+		freertos_transport_open,
+		pico_serial_transport_close,
+		pico_serial_transport_write,
+		freertos_transport_read
+	);
+
+	// Keep trying, the UI runs meanwhile and the agent may start at any time
+	while (!uros_node_init()){
+	}
+
+	for (;;){
+		uros_node_spin_some(RCL_MS_TO_NS(100));
+	}
+}
+
+static void report_task(void *params){
+	TickType_t last = xTaskGetTickCount();
+	for (;;){
+		vTaskDelayUntil(&last, pdMS_TO_TICKS(REPORT_PERIOD_MS));
+		rtos_report_update();
+	}
+}
+
+void vApplicationStackOverflowHook(TaskHandle_t task, char *name){
+	panic("stack overflow in task %s", name);
+}
+
+static void create_pinned(TaskFunction_t fn, const char *name, uint32_t stack, UBaseType_t priority, int core, TaskHandle_t *handle){
+	TaskHandle_t h;
+	xTaskCreate(fn, name, stack, NULL, priority, &h);
+	if (core >= 0){
+		vTaskCoreAffinitySet(h, 1 << core);
+	}
+	if (handle != NULL){
+		*handle = h;
+	}
+}
+
+
+
+int main(void)
+{
+	stack_guard_init();
+	stdio_init_all();
+	ipc_init();
+
+	rx_stream = xStreamBufferCreate(TRANSPORT_RX_BUFFER, 1);
+
+	create_pinned(lvgl_task, "lvgl", LVGL_TASK_STACK, LVGL_TASK_PRIORITY, 1, &lvgl_handle);
+	create_pinned(transport_task, "transport", TRANSPORT_TASK_STACK, TRANSPORT_TASK_PRIORITY, 0, &transport_handle);
+	create_pinned(uros_task, "uros", UROS_TASK_STACK, UROS_TASK_PRIORITY, 0, NULL);
+	create_pinned(report_task, "report", REPORT_TASK_STACK, REPORT_TASK_PRIORITY, -1, NULL);
+
+	vTaskStartScheduler();
+
+	for (;;){
+		sleep_ms(3000);
+	}
+}
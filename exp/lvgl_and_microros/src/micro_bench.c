@@ -0,0 +1,90 @@
+/*
+ * Micro-benchmarks of the firmware hot paths, built as LVGLProj_MicroBench
+ * (src/bench.h; host/micro_bench_host.c is the host build).
+ *
+ * Brings the board and UI up like LVGLProj but does not start the
+ * scheduler, waits for the USB serial port to be opened and runs the shared
+ * cases of bench_cases.c, then:
+ *   disp_flush_cb_setup  disp_flush_cb up to the started DMA (window,
+ *                        DC/CS and channel set up), the transfer is
+ *                        awaited outside the sample
+ *   cdc_write_64         the micro-ROS CDC transport, with an empty FIFO;
+ *                        the bytes are '#' lines the host ignores
+ *   cdc_read_poll        a transport read with nothing pending
+ * Results are BENCH JSON lines on USB stdio, ending with "BENCH done".
+ * Sending 'r' runs them again:
+ *
+ *   tools/micro_bench.py --port /dev/ttyACM0 --baseline base.json
+ */
+#include "LCD_test.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+
+#include "bench.h"
+#include "bench_cases.h"
+#include "ipc_channel.h"
+#include "stack_guard.h"
+
+#define FLUSH_ROWS		10
+
+static lv_color_t flush_buf[DISP_HOR_RES * FLUSH_ROWS];
+static uint8_t comment_line[BENCH_IO_BYTES];
+
+
+static void flush_wait(void *arg, uint32_t iterations){
+	dma_channel_wait_for_finish_blocking(dma_tx);
+	while (spi_is_busy(LCD_SPI_PORT)){
+		tight_loop_contents();
+	}
+}
+
+static void flush_setup(void *arg, uint32_t iterations){
+	lv_disp_drv_t *drv = lv_disp_get_default()->driver;
+	lv_area_t area = { 0, 0, DISP_HOR_RES - 1, FLUSH_ROWS - 1 };
+	drv->flush_cb(drv, &area, flush_buf);
+}
+
+static void cdc_drain(void *arg, uint32_t iterations){
+	sleep_ms(2);	// Two USB frames empty the FIFO
+}
+
+static void run(void){
+	static const bench_case_t cases[] = {
+		{ "disp_flush_cb_setup_240x10", flush_setup, flush_wait, NULL, 1 },
+		{ "cdc_write_64", bench_cdc_write, cdc_drain, comment_line, 2 },
+		{ "cdc_read_poll", bench_cdc_read_poll, NULL, NULL, 100 },
+	};
+	bench_cases_run();
+	bench_run_all(cases, sizeof(cases) / sizeof(cases[0]));
+	flush_wait(NULL, 0);
+	bench_done();
+}
+
+int main(void)
+{
+	stack_guard_init();
+	stdio_init_all();
+	ipc_init();
+
+	if (LCD_1in69_LVGL_Init() != 0){
+		return -1;
+	}
+	memset(comment_line, '#', sizeof(comment_line));
+	comment_line[sizeof(comment_line) - 1] = '\n';
+
+	while (!stdio_usb_connected()){
+		sleep_ms(100);
+	}
+	sleep_ms(500);	// Let the host start reading
+	bench_init();
+	run();
+
+	for (;;){
+		if (getchar_timeout_us(1000000) == 'r'){
+			run();
+		}
+	}
+	return 0;
+}
@@ -9,6 +9,8 @@ void usleep(uint64_t us)
     sleep_us(us);
 }
 
+// Board uptime on purpose: XRCE needs a monotonic clock. Agent time for
+// samples comes from the offset model in uros_time.h.
 int clock_gettime(clockid_t unused, struct timespec *tp)
 {
     uint64_t m = time_us_64();
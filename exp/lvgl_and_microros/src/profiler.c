@@ -0,0 +1,281 @@
+/*****************************************************************************
+* | File        :   profiler.c
+* | Function    :   Statistical PC sampling profiler for both cores
+* | Info        :
+*----------------
+* | The alarm vector is a naked entry that hands the stacked exception
+* | frame to profiler_sample: MSP, or PSP when EXC_RETURN says the
+* | interrupted code ran on the process stack (FreeRTOS tasks). Both run
+* | from RAM so sampling does not thrash the XIP cache it is measuring.
+* |
+* | The histogram is an open addressed hash of PC / LR pairs with a short
+* | linear probe; a new pair that finds no free slot is counted as dropped.
+* | An alarm only matches the low 32 bits of the timer exactly, so a due
+* | time that was overrun is moved to the next period from now.
+******************************************************************************/
+#include "profiler.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#if PROFILER
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/structs/timer.h"
+
+#define CORES           2
+#define STACKED_LR      5       // Words into the exception frame
+#define STACKED_PC      6
+#define PROBES          8
+#define MIN_LEAD_US     4       // Shortest delay an alarm is armed with
+#define STOP_SETTLE_US  20      // Longer than the handler runs
+
+typedef struct {
+    profiler_entry_t slots[PROFILER_SLOTS];
+    uint32_t samples;
+    uint32_t dropped;
+    uint32_t entries;
+    uint32_t target;          // Due time of the armed alarm, low timer word
+    uint32_t rand;            // xorshift state of the dither
+    uint8_t alarm;
+    bool ready;
+} core_profile_t;
+
+static core_profile_t cores[CORES];
+static volatile uint32_t period_us;   // 0 when stopped
+static uint32_t start_hz;
+
+static inline void record(core_profile_t *c, uint32_t pc, uint32_t lr)
+{
+    uint32_t h = (pc ^ (lr * 0x9e3779b1u)) * 0x85ebca6bu;
+    uint32_t i = h >> 16;
+    for(int n = 0; n < PROBES; n++, i++)
+    {
+        profiler_entry_t *e = &c->slots[i & (PROFILER_SLOTS - 1)];
+        if(e->count == 0)
+        {
+            e->pc = pc;
+            e->lr = lr;
+            e->count = 1;
+            c->entries++;
+            return;
+        }
+        if(e->pc == pc && e->lr == lr)
+        {
+            e->count++;
+            return;
+        }
+    }
+    c->dropped++;
+}
+
+static inline void rearm(core_profile_t *c, uint32_t period)
+{
+    c->rand ^= c->rand << 13;
+    c->rand ^= c->rand >> 17;
+    c->rand ^= c->rand << 5;
+    uint32_t span = period / 2;
+    uint32_t delay = period - period / 4 + (span ? c->rand % span : 0);
+
+    c->target += delay;
+    uint32_t now = timer_hw->timerawl;
+    if((int32_t)(c->target - now) < MIN_LEAD_US)
+        c->target = now + MAX(delay, MIN_LEAD_US);
+    timer_hw->alarm[c->alarm] = c->target;
+}
+
+static void __attribute__((used)) __not_in_flash_func(profiler_sample)(const uint32_t *frame)
+{
+    core_profile_t *c = &cores[get_core_num()];
+    timer_hw->intr = 1u << c->alarm;
+    uint32_t period = period_us;
+    if(period == 0)
+        return;
+    c->samples++;
+    record(c, frame[STACKED_PC], frame[STACKED_LR]);
+    rearm(c, period);
+}
+
+static void __attribute__((naked)) __not_in_flash_func(profiler_irq)(void)
+{
+    __asm volatile(
+        "movs r0, #4            \n"     // EXC_RETURN bit 2: process stack
+        "mov  r1, lr            \n"
+        "tst  r0, r1            \n"
+        "bne  1f                \n"
+        "mrs  r0, msp           \n"
+        "b    2f                \n"
+        "1:                     \n"
+        "mrs  r0, psp           \n"
+        "2:                     \n"
+        "ldr  r1, =profiler_sample \n"  // Returns from the exception with our LR
+        "bx   r1                \n"
+        ".ltorg                 \n"
+    );
+}
+
+static void disarm(void)
+{
+    for(int i = 0; i < CORES; i++)
+    {
+        if(cores[i].ready)
+            timer_hw->armed = 1u << cores[i].alarm;
+    }
+}
+
+/********************************************************************************
+function:	Claim a timer alarm for the calling core and enable its interrupt
+            there; the alarm stays unarmed until profiler_start
+parameter:
+********************************************************************************/
+void profiler_init_core(void)
+{
+    core_profile_t *c = &cores[get_core_num()];
+    c->alarm = (uint8_t)hardware_alarm_claim_unused(true);
+    c->rand = 0x2545f491u + get_core_num();
+
+    uint irq = TIMER_IRQ_0 + c->alarm;
+    irq_set_exclusive_handler(irq, profiler_irq);
+    irq_set_priority(irq, PICO_HIGHEST_IRQ_PRIORITY);
+    hw_set_bits(&timer_hw->inte, 1u << c->alarm);
+    irq_set_enabled(irq, true);
+    c->ready = true;
+}
+
+/********************************************************************************
+function:	Clear the histograms and sample every initialised core
+parameter:
+    hz : Mean sample rate per core, 1 to PROFILER_MAX_HZ
+********************************************************************************/
+bool profiler_start(uint32_t hz)
+{
+    if(hz == 0 || hz > PROFILER_MAX_HZ)
+        return false;
+    profiler_stop();
+
+    for(int i = 0; i < CORES; i++)
+    {
+        core_profile_t *c = &cores[i];
+        memset(c->slots, 0, sizeof(c->slots));
+        c->samples = c->dropped = c->entries = 0;
+    }
+    start_hz = hz;
+    period_us = 1000000 / hz;
+
+    uint32_t now = timer_hw->timerawl;
+    for(int i = 0; i < CORES; i++)
+    {
+        core_profile_t *c = &cores[i];
+        if(!c->ready)
+            continue;
+        c->target = now + period_us + i * period_us / 2;   // Cores out of step
+        timer_hw->alarm[c->alarm] = c->target;
+    }
+    return true;
+}
+
+void profiler_stop(void)
+{
+    if(period_us == 0)
+        return;
+    period_us = 0;
+    disarm();
+    // A handler already past its check on the other core may re-arm once
+    busy_wait_us(STOP_SETTLE_US);
+    disarm();
+}
+
+bool profiler_running(void)
+{
+    return period_us != 0;
+}
+
+/********************************************************************************
+function:	The histogram of a core, PROFILER_SLOTS entries with free ones
+            at count 0; consistent while stopped
+parameter:
+********************************************************************************/
+const profiler_entry_t *profiler_entries(uint8_t core)
+{
+    return core < CORES ? cores[core].slots : NULL;
+}
+
+void profiler_get_stats(uint8_t core, profiler_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->hz = start_hz;
+    stats->running = profiler_running();
+    if(core >= CORES)
+        return;
+    stats->samples = cores[core].samples;
+    stats->dropped = cores[core].dropped;
+    stats->entries = cores[core].entries;
+}
+
+/********************************************************************************
+function:	Print the histograms on stdio, one PROFILER_PREFIX line per pair:
+              PROF hz <hz>
+              PROF core <core> samples <n> dropped <n> entries <n>
+              PROF <core> <pc> <lr> <count>      (pc and lr in hex)
+              PROF done
+parameter:
+********************************************************************************/
+void profiler_dump(void)
+{
+    printf(PROFILER_PREFIX "hz %lu\n", (unsigned long)start_hz);
+    for(int core = 0; core < CORES; core++)
+    {
+        const core_profile_t *c = &cores[core];
+        printf(PROFILER_PREFIX "core %d samples %lu dropped %lu entries %lu\n", core,
+               (unsigned long)c->samples, (unsigned long)c->dropped, (unsigned long)c->entries);
+        for(int i = 0; i < PROFILER_SLOTS; i++)
+        {
+            const profiler_entry_t *e = &c->slots[i];
+            if(e->count)
+                printf(PROFILER_PREFIX "%d %08lx %08lx %lu\n", core,
+                       (unsigned long)e->pc, (unsigned long)e->lr, (unsigned long)e->count);
+        }
+    }
+    printf(PROFILER_DONE "\n");
+    fflush(stdout);
+}
+
+#else
+
+void profiler_init_core(void)
+{
+}
+
+bool profiler_start(uint32_t hz)
+{
+    return false;
+}
+
+void profiler_stop(void)
+{
+}
+
+bool profiler_running(void)
+{
+    return false;
+}
+
+const profiler_entry_t *profiler_entries(uint8_t core)
+{
+    return NULL;
+}
+
+void profiler_get_stats(uint8_t core, profiler_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+void profiler_dump(void)
+{
+    printf(PROFILER_DONE "\n");
+    fflush(stdout);
+}
+
+#endif
@@ -0,0 +1,65 @@
+/*****************************************************************************
+* | File        :   profiler.h
+* | Function    :   Statistical PC sampling profiler for both cores
+* | Info        :
+*----------------
+* | Each core owns a hardware timer alarm whose interrupt is enabled on that
+* | core only, at the highest priority. The handler takes the PC and LR the
+* | exception entry stacked for the interrupted code, which may itself be
+* | an interrupt handler, and counts the pair in the core's RAM histogram.
+* | The sample period is dithered by up to a quarter either way so a loop
+* | running at a multiple of the rate is not sampled at the same point
+* | every time. Code that runs with interrupts masked is seen when it
+* | unmasks them.
+* |
+* | Built with PROFILER=1 (the LVGLPROJ_PROFILER CMake option); otherwise
+* | the calls are kept and do nothing, and no RAM is spent; with it the
+* | histograms take 2 x PROFILER_SLOTS x 12 bytes. Call
+* | profiler_init_core once on each core, then profiler_start and
+* | profiler_stop from either. A histogram is consistent once stopped.
+* |
+* | profiler_dump prints the histograms as text on stdio; uros_profile.c
+* | publishes them on ROS. tools/profile_report.py symbolises either
+* | against the firmware ELF.
+******************************************************************************/
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef PROFILER
+#define PROFILER            0
+#endif
+#ifndef PROFILER_SLOTS
+#define PROFILER_SLOTS      512     // Distinct PC / LR pairs per core, a power of 2
+#endif
+#define PROFILER_DEFAULT_HZ 2000
+#define PROFILER_MAX_HZ     20000
+#define PROFILER_PREFIX     "PROF "
+#define PROFILER_DONE       PROFILER_PREFIX "done"
+
+typedef struct {
+    uint32_t pc;
+    uint32_t lr;              // An EXC_RETURN value when the sample hit a handler entry
+    uint32_t count;           // 0 for a free slot
+} profiler_entry_t;
+
+typedef struct {
+    uint32_t hz;              // Of the last start
+    bool running;
+    uint32_t samples;         // Since the last start
+    uint32_t dropped;         // Samples of new pairs that found the histogram full
+    uint32_t entries;         // Slots in use
+} profiler_stats_t;
+
+void profiler_init_core(void);
+bool profiler_start(uint32_t hz);
+void profiler_stop(void);
+bool profiler_running(void);
+const profiler_entry_t *profiler_entries(uint8_t core);
+void profiler_get_stats(uint8_t core, profiler_stats_t *stats);
+void profiler_dump(void);
+
+#endif
@@ -0,0 +1,120 @@
+/*****************************************************************************
+* | File        :   rtos_report.c
+* | Function    :   Task level CPU and wake latency report (FreeRTOS build)
+* | Info        :
+*----------------
+* | The run time counter is time_us_64 (see FreeRTOSConfig.h), so task run
+* | times are in microseconds and comparable with the interval length.
+******************************************************************************/
+#include "rtos_report.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+
+#define RTOS_LATENCY_TLS_INDEX 0
+
+static rtos_report_t report;
+static TaskStatus_t status[RTOS_REPORT_MAX_TASKS];
+static UBaseType_t prev_number[RTOS_REPORT_MAX_TASKS];
+static uint64_t prev_runtime[RTOS_REPORT_MAX_TASKS];
+static UBaseType_t prev_count;
+static uint64_t prev_total;
+
+/********************************************************************************
+function:	Attach latency statistics to the calling task
+parameter:
+********************************************************************************/
+void rtos_latency_attach(rtos_latency_t *latency)
+{
+    memset((void *)latency, 0, sizeof(rtos_latency_t));
+    vTaskSetThreadLocalStoragePointer(NULL, RTOS_LATENCY_TLS_INDEX, latency);
+}
+
+/********************************************************************************
+function:	Record a wakeup that was expected at expected_us (time_us_64)
+parameter:
+********************************************************************************/
+void rtos_latency_record(rtos_latency_t *latency, uint64_t expected_us)
+{
+    uint64_t now = time_us_64();
+    uint32_t late_us = now > expected_us ? (uint32_t)(now - expected_us) : 0;
+    latency->wakeups++;
+    latency->latency_us_total += late_us;
+    if (late_us > latency->latency_us_max)
+        latency->latency_us_max = late_us;
+}
+
+static uint64_t rtos_prev_runtime(UBaseType_t number)
+{
+    for (UBaseType_t i = 0; i < prev_count; i++)
+    {
+        if (prev_number[i] == number)
+            return prev_runtime[i];
+    }
+    return 0;
+}
+
+/********************************************************************************
+function:	Sample all tasks and rebuild the report, call periodically from a
+            low priority task
+parameter:
+********************************************************************************/
+void rtos_report_update(void)
+{
+    configRUN_TIME_COUNTER_TYPE total;
+    UBaseType_t n = uxTaskGetSystemState(status, RTOS_REPORT_MAX_TASKS, &total);
+    uint64_t interval = total - prev_total;
+    uint64_t idle = 0;
+
+    rtos_report_t next;
+    memset(&next, 0, sizeof(next));
+    next.interval_us = (uint32_t)interval;
+
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        TaskStatus_t *s = &status[i];
+        uint64_t delta = s->ulRunTimeCounter - rtos_prev_runtime(s->xTaskNumber);
+        if (strncmp(s->pcTaskName, "IDLE", 4) == 0)
+            idle += delta;
+
+        rtos_task_report_t *t = &next.task[next.tasks++];
+        t->name = s->pcTaskName;
+        t->affinity = (uint32_t)s->uxCoreAffinityMask;
+        t->priority = (uint8_t)s->uxCurrentPriority;
+        t->cpu_pct = interval ? (uint8_t)((delta * 100) / interval) : 0;
+        t->stack_free_bytes = s->usStackHighWaterMark * sizeof(StackType_t);
+
+        rtos_latency_t *latency = pvTaskGetThreadLocalStoragePointer(s->xHandle, RTOS_LATENCY_TLS_INDEX);
+        if (latency != NULL)
+        {
+            t->wakeups = latency->wakeups;
+            t->latency_us_max = latency->latency_us_max;
+            t->latency_us_avg = latency->wakeups ?
+                (uint32_t)(latency->latency_us_total / latency->wakeups) : 0;
+        }
+    }
+    if (interval)
+    {
+        uint64_t capacity = interval * configNUMBER_OF_CORES;
+        next.cpu_load_pct = idle < capacity ? (uint8_t)(100 - (idle * 100) / capacity) : 0;
+    }
+
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        prev_number[i] = status[i].xTaskNumber;
+        prev_runtime[i] = status[i].ulRunTimeCounter;
+    }
+    prev_count = n;
+    prev_total = total;
+
+    taskENTER_CRITICAL();
+    report = next;
+    taskEXIT_CRITICAL();
+}
+
+void rtos_report_get(rtos_report_t *out)
+{
+    taskENTER_CRITICAL();
+    *out = report;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,50 @@
+/*****************************************************************************
+* | File        :   rtos_report.h
+* | Function    :   Task level CPU and wake latency report (FreeRTOS build)
+* | Info        :
+*----------------
+* | rtos_report_update samples the FreeRTOS run time counters and computes
+* | each task's share of a core over the interval since the last update.
+* | Tasks that attach an rtos_latency_t also report how late they ran
+* | compared with when they asked to wake.
+******************************************************************************/
+#ifndef _RTOS_REPORT_H_
+#define _RTOS_REPORT_H_
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define RTOS_REPORT_MAX_TASKS 12
+
+typedef struct {
+    volatile uint32_t wakeups;
+    volatile uint32_t latency_us_max;
+    volatile uint64_t latency_us_total;
+} rtos_latency_t;
+
+typedef struct {
+    const char *name;
+    uint32_t affinity;          // Core mask, all bits set when not pinned
+    uint8_t priority;
+    uint8_t cpu_pct;            // Share of one core over the interval
+    uint32_t stack_free_bytes;  // Lowest free stack seen
+    uint32_t wakeups;
+    uint32_t latency_us_max;
+    uint32_t latency_us_avg;
+} rtos_task_report_t;
+
+typedef struct {
+    uint32_t interval_us;
+    uint8_t cpu_load_pct;       // Both cores, 100 - idle
+    uint8_t tasks;
+    rtos_task_report_t task[RTOS_REPORT_MAX_TASKS];
+} rtos_report_t;
+
+void rtos_latency_attach(rtos_latency_t *latency);
+void rtos_latency_record(rtos_latency_t *latency, uint64_t expected_us);
+
+void rtos_report_update(void);
+void rtos_report_get(rtos_report_t *report);
+
+#endif
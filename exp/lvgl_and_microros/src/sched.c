@@ -0,0 +1,383 @@
+/*****************************************************************************
+* | File        :   sched.c
+* | Function    :   Deadline aware cooperative task scheduler
+* | Info        :
+*----------------
+* | Tasks never preempt each other. The core sleeps until the earliest
+* | release of the pending tasks, or until an event wakes it. At a wakeup
+* | the released tasks run in priority order, and so do tasks released
+* | within SCHED_COALESCE_US, but never later than the earliest "latest
+* | start" (release + deadline - worst observed runtime) of the pending
+* | tasks, so close releases share a wakeup without costing a deadline.
+******************************************************************************/
+#include "sched.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#include "trace.h"
+
+typedef struct {
+    sched_fn_t fn;
+    void *arg;
+    uint32_t period_us;       // 0 for one-shot tasks
+    uint32_t deadline_us;
+    uint64_t release_us;
+    uint8_t priority;
+    bool active;
+    sched_task_stats_t stats;
+} sched_task_t;
+
+#define SCHED_MAX_IDLE_US 1000000
+#define SCHED_COALESCE_US 1000      // Releases this close run in one wakeup
+
+static sched_task_t tasks[SCHED_MAX_TASKS];
+static uint64_t stats_start_us;
+static uint64_t busy_us;
+static uint64_t idle_us;
+static uint32_t wakeups;
+static volatile uint32_t notify_mask;
+static spin_lock_t *notify_lock;
+static void (*volatile wake_hook)(void);
+
+/********************************************************************************
+function:	Clear the task table and the run statistics
+parameter:
+********************************************************************************/
+void sched_init(void)
+{
+    if (notify_lock == NULL)
+        notify_lock = spin_lock_instance(spin_lock_claim_unused(true));    // Counted in IPC_CLAIMED_SPIN_LOCKS
+    notify_mask = 0;
+    memset(tasks, 0, sizeof(tasks));
+    sched_reset_stats();
+}
+
+static int sched_add(const char *name, sched_fn_t fn, void *arg, uint32_t period_us,
+                     uint32_t delay_us, uint32_t deadline_us, uint8_t priority)
+{
+    for (int i = 0; i < SCHED_MAX_TASKS; i++)
+    {
+        if (!tasks[i].active)
+        {
+            memset(&tasks[i], 0, sizeof(sched_task_t));
+            tasks[i].fn = fn;
+            tasks[i].arg = arg;
+            tasks[i].period_us = period_us;
+            tasks[i].deadline_us = deadline_us;
+            tasks[i].priority = priority;
+            tasks[i].release_us = time_us_64() + delay_us;
+            tasks[i].stats.name = name;
+            tasks[i].active = true;
+            return i;
+        }
+    }
+    return SCHED_INVALID_TASK;
+}
+
+/********************************************************************************
+function:	Add a task released every period_ms. A deadline of 0 means the task
+            only has to finish before its next release.
+parameter:
+    name        : Name reported in the statistics
+    fn, arg     : Task function and its argument
+    period_ms   : Release period
+    deadline_ms : Relative deadline from each release
+    priority    : 0 is the most urgent
+********************************************************************************/
+int sched_add_periodic(const char *name, sched_fn_t fn, void *arg,
+                       uint32_t period_ms, uint32_t deadline_ms, uint8_t priority)
+{
+    return sched_add_periodic_us(name, fn, arg, period_ms * 1000, deadline_ms * 1000, priority);
+}
+
+/********************************************************************************
+function:	sched_add_periodic for periods that are not whole milliseconds
+parameter:
+    period_us   : Release period
+    deadline_us : Relative deadline from each release, 0 for the period
+********************************************************************************/
+int sched_add_periodic_us(const char *name, sched_fn_t fn, void *arg,
+                          uint32_t period_us, uint32_t deadline_us, uint8_t priority)
+{
+    if (period_us == 0)
+        return SCHED_INVALID_TASK;
+    if (deadline_us == 0 || deadline_us > period_us)
+        deadline_us = period_us;
+    return sched_add(name, fn, arg, period_us, period_us, deadline_us, priority);
+}
+
+/********************************************************************************
+function:	Add a task run once, delay_ms from now
+parameter:
+    name        : Name reported in the statistics
+    fn, arg     : Task function and its argument
+    delay_ms    : Release time from now
+    deadline_ms : Relative deadline from the release, 0 to run as soon as due
+    priority    : 0 is the most urgent
+********************************************************************************/
+int sched_add_oneshot(const char *name, sched_fn_t fn, void *arg,
+                      uint32_t delay_ms, uint32_t deadline_ms, uint8_t priority)
+{
+    return sched_add(name, fn, arg, 0, delay_ms * 1000, deadline_ms * 1000, priority);
+}
+
+bool sched_cancel(int id)
+{
+    if (id < 0 || id >= SCHED_MAX_TASKS || !tasks[id].active)
+        return false;
+    tasks[id].active = false;
+    return true;
+}
+
+/********************************************************************************
+function:	Change the period of a periodic task, the deadline scales with it
+parameter:
+********************************************************************************/
+bool sched_set_period(int id, uint32_t period_ms)
+{
+    return sched_set_period_us(id, period_ms * 1000);
+}
+
+bool sched_set_period_us(int id, uint32_t period_us)
+{
+    if (id < 0 || id >= SCHED_MAX_TASKS || !tasks[id].active ||
+        tasks[id].period_us == 0 || period_us == 0)
+        return false;
+
+    sched_task_t *t = &tasks[id];
+    t->deadline_us = (uint32_t)(((uint64_t)t->deadline_us * period_us) / t->period_us);
+    t->release_us = t->release_us - t->period_us + period_us;
+    t->period_us = period_us;
+    return true;
+}
+
+/********************************************************************************
+function:	Move the next release of a task, normally from inside the task to
+            sleep until it next has work
+parameter:
+********************************************************************************/
+bool sched_set_next_release(int id, uint32_t delay_ms)
+{
+    if (id < 0 || id >= SCHED_MAX_TASKS || !tasks[id].active)
+        return false;
+    tasks[id].release_us = time_us_64() + delay_ms * 1000;
+    return true;
+}
+
+/********************************************************************************
+function:	Release a task now and wake the scheduler core. Safe from IRQ
+            context and from the other core.
+parameter:
+********************************************************************************/
+void sched_notify(int id)
+{
+    if (id < 0 || id >= SCHED_MAX_TASKS)
+        return;
+    uint32_t save = spin_lock_blocking(notify_lock);
+    notify_mask |= 1u << id;
+    spin_unlock(notify_lock, save);
+    __sev();
+
+    void (*wake)(void) = wake_hook;
+    if (wake != NULL)
+        wake();
+}
+
+/********************************************************************************
+function:	Set a function sched_notify calls to unblock the scheduler when it
+            does not idle in __wfe (for example an RTOS task notification)
+parameter:
+********************************************************************************/
+void sched_set_wake_hook(void (*wake)(void))
+{
+    wake_hook = wake;
+}
+
+static void sched_take_notifications(uint64_t now)
+{
+    uint32_t save = spin_lock_blocking(notify_lock);
+    uint32_t mask = notify_mask;
+    notify_mask = 0;
+    spin_unlock(notify_lock, save);
+
+    for (int i = 0; mask != 0; i++, mask >>= 1)
+    {
+        if ((mask & 1) && tasks[i].active && tasks[i].release_us > now)
+            tasks[i].release_us = now;
+    }
+}
+
+/********************************************************************************
+function:	Latest time a task can start and still finish by its deadline,
+            based on the worst runtime seen so far
+parameter:
+********************************************************************************/
+static uint64_t sched_latest_start(const sched_task_t *t)
+{
+    if (t->stats.run_us_max >= t->deadline_us)
+        return t->release_us;
+    return t->release_us + t->deadline_us - t->stats.run_us_max;
+}
+
+/********************************************************************************
+function:	Latest release that may run in the current wakeup: now plus the
+            coalescing window, cut at the earliest latest start of the tasks
+parameter:
+********************************************************************************/
+static uint64_t sched_horizon(uint64_t now)
+{
+    uint64_t horizon = now + SCHED_COALESCE_US;
+    for (int i = 0; i < SCHED_MAX_TASKS; i++)
+    {
+        if (tasks[i].active)
+        {
+            uint64_t latest = sched_latest_start(&tasks[i]);
+            if (latest < horizon)
+                horizon = latest;
+        }
+    }
+    return horizon > now ? horizon : now;
+}
+
+static int sched_pick_due(uint64_t horizon)
+{
+    int best = SCHED_INVALID_TASK;
+    for (int i = 0; i < SCHED_MAX_TASKS; i++)
+    {
+        const sched_task_t *t = &tasks[i];
+        if (!t->active || t->release_us > horizon)
+            continue;
+        if (best == SCHED_INVALID_TASK ||
+            t->priority < tasks[best].priority ||
+            (t->priority == tasks[best].priority && t->release_us < tasks[best].release_us))
+            best = i;
+    }
+    return best;
+}
+
+static void sched_dispatch(int id)
+{
+    sched_task_t *t = &tasks[id];
+    uint64_t release = t->release_us;
+    uint64_t start = time_us_64();
+
+    if (t->period_us)
+    {
+        // Skip releases we are already too late for instead of running a burst
+        t->release_us += t->period_us;
+        if (t->release_us <= start)
+        {
+            uint64_t skip = (start - t->release_us) / t->period_us + 1;
+            t->release_us += skip * t->period_us;
+            t->stats.skipped += (uint32_t)skip;
+        }
+    }
+    else
+    {
+        t->release_us = UINT64_MAX;
+    }
+
+    TRACE_BEGIN(TRACE_SCHED_TASK);
+    t->fn(t->arg);
+    TRACE_END(TRACE_SCHED_TASK, id);
+
+    uint64_t end = time_us_64();
+    uint32_t run_us = (uint32_t)(end - start);
+    uint32_t jitter_us = start > release ? (uint32_t)(start - release) : 0; // Coalesced early
+
+    busy_us += run_us;
+    t->stats.runs++;
+    t->stats.run_us_last = run_us;
+    t->stats.run_us_total += run_us;
+    if (run_us > t->stats.run_us_max)
+        t->stats.run_us_max = run_us;
+    t->stats.jitter_us_total += jitter_us;
+    if (jitter_us > t->stats.jitter_us_max)
+        t->stats.jitter_us_max = jitter_us;
+    if (end > release + t->deadline_us)
+        t->stats.misses++;
+
+    if (t->period_us == 0)
+        t->active = false;
+}
+
+/********************************************************************************
+function:	Run every released task, and those released within the coalescing
+            window, highest priority first
+parameter:
+return:     Time (us since boot) the caller may sleep until, the earliest
+            pending release
+********************************************************************************/
+uint64_t sched_run_once(void)
+{
+    int id;
+    sched_take_notifications(time_us_64());
+    while ((id = sched_pick_due(sched_horizon(time_us_64()))) != SCHED_INVALID_TASK)
+    {
+        sched_dispatch(id);
+    }
+
+    uint64_t wake_us = time_us_64() + SCHED_MAX_IDLE_US;
+    for (int i = 0; i < SCHED_MAX_TASKS; i++)
+    {
+        if (tasks[i].active && tasks[i].release_us < wake_us)
+            wake_us = tasks[i].release_us;
+    }
+    return wake_us;
+}
+
+/********************************************************************************
+function:	Scheduler main loop, never returns. Idles in __wfe until the next
+            release, an interrupt or a sched_notify.
+parameter:
+********************************************************************************/
+void sched_run(void)
+{
+    for (;;)
+    {
+        uint64_t wake_us = sched_run_once();
+        uint64_t idle_start = time_us_64();
+        if (wake_us > idle_start && notify_mask == 0)
+        {
+            best_effort_wfe_or_timeout(from_us_since_boot(wake_us));
+            idle_us += time_us_64() - idle_start;
+            wakeups++;
+        }
+    }
+}
+
+bool sched_get_stats(int id, sched_task_stats_t *stats)
+{
+    if (id < 0 || id >= SCHED_MAX_TASKS || !tasks[id].active)
+        return false;
+    *stats = tasks[id].stats;
+    return true;
+}
+
+void sched_get_summary(sched_summary_t *summary)
+{
+    summary->elapsed_us = time_us_64() - stats_start_us;
+    summary->busy_us = busy_us;
+    summary->idle_us = idle_us;
+    summary->wakeups = wakeups;
+    summary->utilisation_pct = summary->elapsed_us ?
+        (uint32_t)((busy_us * 100) / summary->elapsed_us) : 0;
+    summary->idle_pct = summary->elapsed_us ?
+        (uint32_t)((idle_us * 100) / summary->elapsed_us) : 0;
+}
+
+void sched_reset_stats(void)
+{
+    for (int i = 0; i < SCHED_MAX_TASKS; i++)
+    {
+        const char *name = tasks[i].stats.name;
+        memset(&tasks[i].stats, 0, sizeof(sched_task_stats_t));
+        tasks[i].stats.name = name;
+    }
+    stats_start_us = time_us_64();
+    busy_us = 0;
+    idle_us = 0;
+    wakeups = 0;
+}
@@ -0,0 +1,71 @@
+/*****************************************************************************
+* | File        :   sched.h
+* | Function    :   Deadline aware cooperative task scheduler
+* | Info        :
+*----------------
+* | Tasks are periodic or one-shot, have a relative deadline and a priority
+* | (0 is the most urgent). The run loop sleeps until the next release, and
+* | tasks whose releases fall within a short window of it share that
+* | wakeup as long as no pending task's deadline is put at risk. The core
+* | idles in __wfe, so any interrupt or sched_notify ends the sleep early.
+* |
+* | The scheduler is owned by one core: add, cancel and run from that core.
+* | Only sched_notify may be called from IRQ context or the other core.
+* | Under an RTOS the owning task calls sched_run_once and blocks itself;
+* | a wake hook then lets sched_notify unblock it.
+******************************************************************************/
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCHED_MAX_TASKS     10
+#define SCHED_INVALID_TASK  (-1)
+
+typedef void (*sched_fn_t)(void *arg);
+
+typedef struct {
+    const char *name;
+    uint32_t runs;
+    uint32_t misses;          // Finished after release + deadline
+    uint32_t skipped;         // Releases dropped because the task ran too late
+    uint32_t run_us_last;
+    uint32_t run_us_max;
+    uint64_t run_us_total;
+    uint32_t jitter_us_max;   // Start time minus release time
+    uint64_t jitter_us_total;
+} sched_task_stats_t;
+
+typedef struct {
+    uint64_t elapsed_us;      // Since sched_init or sched_reset_stats
+    uint64_t busy_us;         // Time spent inside task functions
+    uint64_t idle_us;         // Time spent waiting for an event or timeout
+    uint32_t wakeups;         // Number of times the idle sleep ended
+    uint32_t utilisation_pct; // busy_us / elapsed_us
+    uint32_t idle_pct;        // idle_us / elapsed_us
+} sched_summary_t;
+
+void sched_init(void);
+
+int  sched_add_periodic(const char *name, sched_fn_t fn, void *arg,
+                        uint32_t period_ms, uint32_t deadline_ms, uint8_t priority);
+int  sched_add_periodic_us(const char *name, sched_fn_t fn, void *arg,
+                           uint32_t period_us, uint32_t deadline_us, uint8_t priority);
+int  sched_add_oneshot(const char *name, sched_fn_t fn, void *arg,
+                       uint32_t delay_ms, uint32_t deadline_ms, uint8_t priority);
+bool sched_cancel(int id);
+bool sched_set_period(int id, uint32_t period_ms);
+bool sched_set_period_us(int id, uint32_t period_us);
+bool sched_set_next_release(int id, uint32_t delay_ms);
+void sched_notify(int id);
+void sched_set_wake_hook(void (*wake)(void));
+
+uint64_t sched_run_once(void);
+void sched_run(void);
+
+bool sched_get_stats(int id, sched_task_stats_t *stats);
+void sched_get_summary(sched_summary_t *summary);
+void sched_reset_stats(void);
+
+#endif
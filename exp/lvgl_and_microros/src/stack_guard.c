@@ -0,0 +1,92 @@
+/*****************************************************************************
+* | File        :   stack_guard.c
+* | Function    :   Stack painting, high water marks and overflow canaries
+* | Info        :
+*----------------
+* | The stack bounds come from the SDK linker script: core0 runs on
+* | .stack_dummy in SCRATCH_Y and core1 on .stack1_dummy in SCRATCH_X.
+******************************************************************************/
+#include "stack_guard.h"
+
+#include "pico/stdlib.h"
+
+#define STACK_PAINT      0xdeadbeefu
+#define STACK_CANARY     0x5ca1ab1eu
+#define STACK_MPU_BYTES  64   // Left unpainted for the PICO_USE_STACK_GUARDS region
+#define STACK_SP_MARGIN  64   // Not painted below the live stack pointer
+
+extern uint32_t __StackBottom;
+extern uint32_t __StackTop;
+extern uint32_t __StackOneBottom;
+extern uint32_t __StackOneTop;
+
+typedef struct {
+    uint32_t *canary;
+    uint32_t *top;
+    stack_guard_stats_t stats;
+} stack_region_t;
+
+static stack_region_t regions[2];
+
+static inline uint32_t *current_sp(void)
+{
+    uint32_t *sp;
+    __asm volatile ("mov %0, sp" : "=r" (sp));
+    return sp;
+}
+
+static void paint(stack_region_t *r, uint32_t *bottom, uint32_t *top, uint32_t *limit)
+{
+    r->canary = (uint32_t *)((uint8_t *)bottom + STACK_MPU_BYTES);
+    r->top = top;
+    r->stats.size = (uint8_t *)top - (uint8_t *)r->canary;
+    r->stats.canary_ok = true;
+    for (uint32_t *p = r->canary + 1; p < limit; p++)
+        *p = STACK_PAINT;
+    *r->canary = STACK_CANARY;
+}
+
+/********************************************************************************
+function:	Paint the unused part of the core0 stack and all of the core1
+            stack. Core0 only, before multicore_launch_core1.
+parameter:
+********************************************************************************/
+void stack_guard_init(void)
+{
+    uint32_t *limit = (uint32_t *)((uint8_t *)current_sp() - STACK_SP_MARGIN);
+    paint(&regions[0], &__StackBottom, &__StackTop, limit);
+    paint(&regions[1], &__StackOneBottom, &__StackOneTop, &__StackOneTop);
+}
+
+static void update(stack_region_t *r)
+{
+    uint32_t *p = r->canary + 1;
+    while (p < r->top && *p == STACK_PAINT)
+        p++;
+    r->stats.used_max = (uint8_t *)r->top - (uint8_t *)p;
+    r->stats.free_min = r->stats.size - r->stats.used_max;
+    r->stats.canary_ok = *r->canary == STACK_CANARY;
+}
+
+/********************************************************************************
+function:	Refresh both high water marks and verify the canaries. Panics
+            when a canary is gone: the stack below it has been overwritten.
+parameter:
+********************************************************************************/
+void stack_guard_check(void)
+{
+    for (int core = 0; core < 2; core++)
+    {
+        stack_region_t *r = &regions[core];
+        if (r->canary == NULL)
+            continue;
+        update(r);
+        if (!r->stats.canary_ok)
+            panic("stack overflow on core%d", core);
+    }
+}
+
+void stack_guard_get_stats(uint8_t core, stack_guard_stats_t *stats)
+{
+    *stats = regions[core & 1].stats;
+}
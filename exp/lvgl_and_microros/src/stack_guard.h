@@ -0,0 +1,34 @@
+/*****************************************************************************
+* | File        :   stack_guard.h
+* | Function    :   Stack painting, high water marks and overflow canaries
+* | Info        :
+*----------------
+* | Both core stacks are painted with a fill pattern at boot. On the M0+
+* | interrupts run on the interrupted core's main stack, so the figures for
+* | each core include its IRQ handlers. The lowest painted word is a canary;
+* | below it PICO_USE_STACK_GUARDS places an MPU no-access region, so a
+* | deep overflow faults at once and a near miss is caught by the canary.
+* |
+* | Call stack_guard_init first thing in main on core0, before core1 is
+* | launched. stack_guard_check can then run from any core.
+******************************************************************************/
+#ifndef _STACK_GUARD_H_
+#define _STACK_GUARD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define STACK_GUARD_CHECK_MS 500
+
+typedef struct {
+    uint32_t size;            // Painted bytes, excluding the MPU guard
+    uint32_t used_max;        // High water mark in bytes
+    uint32_t free_min;        // size - used_max
+    bool canary_ok;
+} stack_guard_stats_t;
+
+void stack_guard_init(void);
+void stack_guard_check(void);
+void stack_guard_get_stats(uint8_t core, stack_guard_stats_t *stats);
+
+#endif
@@ -0,0 +1,200 @@
+/*****************************************************************************
+* | File        :   trace.c
+* | Function    :   Ring buffer event tracing for both cores
+* | Info        :
+*----------------
+* | A dump is text, one TRACE_PREFIX line each:
+* |   TRACE events <slots per core>
+* |   TRACE event <id> <name>                     per trace_event_t
+* |   TRACE core <core> written <n> kept <n>
+* |   TRACE <core> <t_us> <id> <phase> <arg>      oldest first, t_us in hex
+* |   TRACE done
+* | trace_format hands it out in whole lines, in pieces of any size, so a
+* | frozen trace can go out over a slow link a message at a time.
+******************************************************************************/
+#include "trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define CORES       2
+
+enum { STAGE_HEADER = 0, STAGE_NAMES, STAGE_CORE, STAGE_RECORDS, STAGE_DONE, STAGE_END };
+
+#if TRACE
+trace_buffer_t trace_buffers[CORES];
+volatile bool trace_enabled = true;     // From boot, so start up is traced
+#endif
+
+static const char *const event_names[TRACE_EVENT_TYPES] = {
+    "sched_task",
+    "lv_timer_handler",
+    "disp_flush_cb",
+    "flush_dma",
+    "disp_wait_cb",
+    "touch_callback",
+    "imu_read",
+    "rtc_read",
+    "executor_spin",
+    "transport_wait",
+    "transport_write",
+    "transport_read",
+    "doorbell_ring",
+    "doorbell_irq",
+};
+
+/********************************************************************************
+function:	Clear both rings and trace from now on
+parameter:
+********************************************************************************/
+void trace_start(void)
+{
+#if TRACE
+    trace_enabled = false;
+    for(int i = 0; i < CORES; i++)
+        trace_buffers[i].head = 0;
+    trace_enabled = true;
+#endif
+}
+
+/********************************************************************************
+function:	Freeze the rings; an event being written on the other core lands
+            within a few cycles
+parameter:
+********************************************************************************/
+void trace_stop(void)
+{
+#if TRACE
+    trace_enabled = false;
+#endif
+}
+
+bool trace_running(void)
+{
+#if TRACE
+    return trace_enabled;
+#else
+    return false;
+#endif
+}
+
+static uint32_t written(uint8_t core)
+{
+#if TRACE
+    return trace_buffers[core].head;
+#else
+    return 0;
+#endif
+}
+
+static uint32_t kept(uint8_t core)
+{
+    uint32_t n = written(core);
+    return n < TRACE_EVENTS ? n : TRACE_EVENTS;
+}
+
+void trace_cursor_init(trace_cursor_t *cur)
+{
+    memset(cur, 0, sizeof(*cur));
+}
+
+static int next_line(const trace_cursor_t *cur, char *line)
+{
+    switch(cur->stage)
+    {
+    case STAGE_HEADER:
+        return snprintf(line, TRACE_LINE_BYTES, TRACE_PREFIX "events %u\n", TRACE_EVENTS);
+    case STAGE_NAMES:
+        return snprintf(line, TRACE_LINE_BYTES, TRACE_PREFIX "event %lu %s\n",
+                        (unsigned long)cur->index, event_names[cur->index]);
+    case STAGE_CORE:
+        return snprintf(line, TRACE_LINE_BYTES, TRACE_PREFIX "core %u written %lu kept %lu\n", cur->core,
+                        (unsigned long)written(cur->core), (unsigned long)kept(cur->core));
+#if TRACE
+    case STAGE_RECORDS:
+    {
+        const trace_buffer_t *b = &trace_buffers[cur->core];
+        uint32_t first = b->head - kept(cur->core);
+        const trace_record_t *r = &b->records[(first + cur->index) & (TRACE_EVENTS - 1)];
+        return snprintf(line, TRACE_LINE_BYTES, TRACE_PREFIX "%u %08lx %u %c %u\n", cur->core,
+                        (unsigned long)r->t_us, r->id, r->phase, r->arg);
+    }
+#endif
+    case STAGE_DONE:
+        return snprintf(line, TRACE_LINE_BYTES, TRACE_DONE "\n");
+    default:
+        return 0;
+    }
+}
+
+static void next_core(trace_cursor_t *cur)
+{
+    cur->stage = ++cur->core < CORES ? STAGE_CORE : STAGE_DONE;
+}
+
+static void advance(trace_cursor_t *cur)
+{
+    switch(cur->stage)
+    {
+    case STAGE_HEADER:
+        cur->stage = STAGE_NAMES;
+        cur->index = 0;
+        break;
+    case STAGE_NAMES:
+        if(++cur->index == TRACE_EVENT_TYPES)
+            cur->stage = STAGE_CORE;
+        break;
+    case STAGE_CORE:
+        cur->index = 0;
+        if(kept(cur->core) != 0)
+            cur->stage = STAGE_RECORDS;
+        else
+            next_core(cur);
+        break;
+    case STAGE_RECORDS:
+        if(++cur->index == kept(cur->core))
+            next_core(cur);
+        break;
+    case STAGE_DONE:
+        cur->stage = STAGE_END;
+        break;
+    }
+}
+
+/********************************************************************************
+function:	Write the next whole lines of a dump of the frozen rings
+parameter:
+    buf  : Filled with as many lines as fit, NUL terminated; size must hold
+           at least TRACE_LINE_BYTES
+return:     Bytes written, 0 once the dump is complete
+********************************************************************************/
+size_t trace_format(trace_cursor_t *cur, char *buf, size_t size)
+{
+    char line[TRACE_LINE_BYTES];
+    size_t len = 0;
+    int n;
+    while((n = next_line(cur, line)) > 0 && len + n < size)
+    {
+        memcpy(buf + len, line, n);
+        len += n;
+        advance(cur);
+    }
+    if(size > 0)
+        buf[len] = '\0';
+    return len;
+}
+
+/********************************************************************************
+function:	Freeze the rings and print them on stdio
+parameter:
+********************************************************************************/
+void trace_dump(void)
+{
+    char buf[256];
+    trace_cursor_t cur;
+    trace_stop();
+    trace_cursor_init(&cur);
+    while(trace_format(&cur, buf, sizeof(buf)) > 0)
+        fputs(buf, stdout);
+    fflush(stdout);
+}
@@ -0,0 +1,126 @@
+/*****************************************************************************
+* | File        :   trace.h
+* | Function    :   Ring buffer event tracing for both cores
+* | Info        :
+*----------------
+* | An event is 8 bytes: the low word of the microsecond timer, which both
+* | cores share, so their timelines line up, the event id, a phase and a
+* | 16 bit argument. Each core writes its own ring with interrupts masked
+* | for the few stores it takes, so handlers on the same core can trace
+* | too; when the ring is full the oldest events are overwritten.
+* |
+* | The phases are the Chrome trace ones: TRACE_BEGIN / TRACE_END nest on
+* | the core they run on, TRACE_ASYNC_BEGIN / TRACE_ASYNC_END may end in a
+* | handler (a DMA transfer), TRACE_INSTANT marks a point.
+* |
+* | Built with TRACE=1 (the LVGLPROJ_TRACE CMake option) tracing runs from
+* | boot; otherwise the macros compile to nothing and trace_* do nothing.
+* | trace_stop freezes the rings for trace_dump, which prints them as text
+* | on stdio, or for uros_trace.c, which publishes the same text on ROS.
+* | tools/trace_export.py turns it into Chrome trace JSON for Perfetto.
+******************************************************************************/
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef TRACE
+#define TRACE               0
+#endif
+#ifndef TRACE_EVENTS
+#define TRACE_EVENTS        1024    // Per core, a power of 2
+#endif
+#define TRACE_PREFIX        "TRACE "
+#define TRACE_DONE          TRACE_PREFIX "done"
+#define TRACE_LINE_BYTES    48      // Longest line of a dump, with the NUL
+
+typedef enum {
+    TRACE_SCHED_TASK = 0,     // sched_dispatch, arg task id
+    TRACE_LV_TIMER_HANDLER,   // One LVGL pass
+    TRACE_DISP_FLUSH,         // disp_flush_cb, arg pixels
+    TRACE_FLUSH_DMA,          // Async, flush start to DMA done, arg 1 on the last flush
+    TRACE_DISP_WAIT,          // disp_wait_cb, LVGL waiting for a draw buffer
+    TRACE_TOUCH_IRQ,          // touch_callback, with the controller read
+    TRACE_IMU_READ,
+    TRACE_RTC_READ,
+    TRACE_EXECUTOR_SPIN,      // rclc_executor_spin_some
+    TRACE_TRANSPORT_WAIT,     // uros_transport_wait, arg 1 if data came
+    TRACE_TRANSPORT_WRITE,    // arg bytes written
+    TRACE_TRANSPORT_READ,     // arg bytes read
+    TRACE_DOORBELL_RING,      // Instant, arg channel id
+    TRACE_DOORBELL_IRQ,       // Instant, arg pending channel bits
+    TRACE_EVENT_TYPES
+} trace_event_t;
+
+typedef enum {
+    TRACE_PHASE_BEGIN = 'B',
+    TRACE_PHASE_END = 'E',
+    TRACE_PHASE_INSTANT = 'i',
+    TRACE_PHASE_ASYNC_BEGIN = 'b',
+    TRACE_PHASE_ASYNC_END = 'e',
+} trace_phase_t;
+
+typedef struct {
+    uint32_t t_us;            // timerawl
+    uint8_t id;               // trace_event_t
+    uint8_t phase;            // trace_phase_t
+    uint16_t arg;
+} trace_record_t;
+
+typedef struct {
+    trace_record_t records[TRACE_EVENTS];
+    uint32_t head;            // Events written since the last start
+} trace_buffer_t;
+
+// Position of trace_format in the text of a dump
+typedef struct {
+    uint8_t stage;
+    uint8_t core;
+    uint32_t index;
+} trace_cursor_t;
+
+void trace_start(void);
+void trace_stop(void);
+bool trace_running(void);
+void trace_cursor_init(trace_cursor_t *cur);
+size_t trace_format(trace_cursor_t *cur, char *buf, size_t size);
+void trace_dump(void);
+
+#if TRACE
+#include "pico.h"
+#include "hardware/sync.h"
+#include "hardware/structs/timer.h"
+
+extern trace_buffer_t trace_buffers[2];
+extern volatile bool trace_enabled;
+
+static __force_inline void trace_emit(uint8_t id, uint8_t phase, uint16_t arg)
+{
+    if(!trace_enabled)
+        return;
+    trace_buffer_t *b = &trace_buffers[get_core_num()];
+    uint32_t save = save_and_disable_interrupts();
+    trace_record_t *r = &b->records[b->head++ & (TRACE_EVENTS - 1)];
+    r->t_us = timer_hw->timerawl;
+    r->id = id;
+    r->phase = phase;
+    r->arg = arg;
+    restore_interrupts(save);
+}
+
+#define TRACE_BEGIN(ev)             trace_emit((ev), TRACE_PHASE_BEGIN, 0)
+#define TRACE_END(ev, arg)          trace_emit((ev), TRACE_PHASE_END, (uint16_t)(arg))
+#define TRACE_INSTANT(ev, arg)      trace_emit((ev), TRACE_PHASE_INSTANT, (uint16_t)(arg))
+#define TRACE_ASYNC_BEGIN(ev, arg)  trace_emit((ev), TRACE_PHASE_ASYNC_BEGIN, (uint16_t)(arg))
+#define TRACE_ASYNC_END(ev, arg)    trace_emit((ev), TRACE_PHASE_ASYNC_END, (uint16_t)(arg))
+#else
+#define TRACE_BEGIN(ev)             ((void)0)
+#define TRACE_END(ev, arg)          ((void)0)
+#define TRACE_INSTANT(ev, arg)      ((void)0)
+#define TRACE_ASYNC_BEGIN(ev, arg)  ((void)0)
+#define TRACE_ASYNC_END(ev, arg)    ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ * micro-ROS transport benchmark, built as LVGLProj_TransportBench and driven
+ * from the host by tools/transport_bench.py.
+ *
+ * The host sends a mode byte and a transport byte, then:
+ *   'W' device writes BENCH_BYTES through the transport, host reads them
+ *   'R' host writes BENCH_BYTES, device reads them through the transport
+ *   'E' BENCH_ECHO_COUNT round trips of BENCH_ECHO_BYTES, host times them
+ * and the device answers "RESULT <mode> <transport> <bytes> <us>\n".
+ * Transport 'S' is pico_uart_transport.c, 'C' is usb_cdc_transport.c.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "pico_uart_transport.h"
+#include "usb_cdc_transport.h"
+
+#define BENCH_BYTES			65536
+#define BENCH_CHUNK			512
+#define BENCH_ECHO_BYTES	32
+#define BENCH_ECHO_COUNT	1000
+#define BENCH_TIMEOUT_MS	1000
+
+typedef size_t (*bench_write_t)(struct uxrCustomTransport*, const uint8_t*, size_t, uint8_t*);
+typedef size_t (*bench_read_t)(struct uxrCustomTransport*, uint8_t*, size_t, int, uint8_t*);
+
+static uint8_t buffer[BENCH_CHUNK];
+
+
+static size_t read_all(bench_read_t rd, uint8_t *buf, size_t len){
+	size_t got = 0;
+	while (got < len){
+		uint8_t err = 0;
+		size_t n = rd(NULL, buf + got, len - got, BENCH_TIMEOUT_MS, &err);
+		got += n;
+		if (n == 0 && err){
+			break;
+		}
+	}
+	return got;
+}
+
+static size_t write_all(bench_write_t wr, const uint8_t *buf, size_t len){
+	size_t sent = 0;
+	while (sent < len){
+		uint8_t err = 0;
+		size_t n = wr(NULL, buf + sent, len - sent, &err);
+		sent += n;
+		if (n == 0 && err){
+			break;
+		}
+	}
+	return sent;
+}
+
+static void bench(char mode, char transport){
+	bench_write_t wr = transport == 'S' ? pico_serial_transport_write : usb_cdc_transport_write;
+	bench_read_t rd = transport == 'S' ? pico_serial_transport_read : usb_cdc_transport_read;
+	size_t bytes = 0;
+
+	uint64_t start = time_us_64();
+	switch (mode){
+	case 'W':
+		for (size_t i = 0; i < BENCH_CHUNK; i++){
+			buffer[i] = (uint8_t)i;
+		}
+		while (bytes < BENCH_BYTES){
+			size_t n = write_all(wr, buffer, BENCH_CHUNK);
+			bytes += n;
+			if (n < BENCH_CHUNK){
+				break;
+			}
+		}
+		break;
+	case 'R':
+		while (bytes < BENCH_BYTES){
+			size_t n = read_all(rd, buffer, BENCH_CHUNK);
+			bytes += n;
+			if (n < BENCH_CHUNK){
+				break;
+			}
+		}
+		break;
+	case 'E':
+		for (int i = 0; i < BENCH_ECHO_COUNT; i++){
+			size_t n = read_all(rd, buffer, BENCH_ECHO_BYTES);
+			bytes += write_all(wr, buffer, n);
+			if (n < BENCH_ECHO_BYTES){
+				break;
+			}
+		}
+		break;
+	default:
+		return;
+	}
+	uint64_t elapsed = time_us_64() - start;
+
+	char result[64];
+	int len = snprintf(result, sizeof(result), "RESULT %c %c %u %llu\n",
+		mode, transport, (unsigned)bytes, (unsigned long long)elapsed);
+	write_all(usb_cdc_transport_write, (const uint8_t *)result, len);
+}
+
+
+
+int main(void)
+{
+	usb_cdc_transport_open(NULL);
+
+	for (;;){
+		uint8_t cmd[2];
+		if (read_all(usb_cdc_transport_read, cmd, 2) == 2){
+			bench((char)cmd[0], (char)cmd[1]);
+		}
+	}
+}
@@ -0,0 +1,240 @@
+/*****************************************************************************
+* | File        :   ui_input.c
+* | Function    :   Injected touch, gesture and key input from core0
+* | Info        :
+*----------------
+* | The events are consumed in place from ipc_input_channel by the input
+* | read callbacks. A read applies every due gesture and at most one
+* | pointer or key change, and asks LVGL to read again in the same pass
+* | (continue_reading) while more are due, so a burst that fell behind is
+* | replayed step by step instead of being merged into its last point.
+******************************************************************************/
+#include "ui_input.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ipc_channel.h"
+
+static lv_indev_t *pointer_indev;
+static lv_indev_drv_t keypad_drv;
+static lv_indev_t *keypad_indev;
+static lv_group_t *group;
+
+// Injected pointer, reported instead of the touch controller while owned
+static bool owned;
+static bool held;
+static lv_point_t point;
+
+// Injected key, pressed in one read and released in the next
+static bool key_down;
+static uint32_t key;
+
+static ui_input_stats_t stats;
+static uint32_t late_us_window;
+
+static void keypad_read_cb(lv_indev_drv_t * drv, lv_indev_data_t * data);
+
+/********************************************************************************
+function:	The event at the head of the channel if it is due
+parameter:
+return:     NULL when the channel is empty or the head is not due yet
+********************************************************************************/
+static const ipc_input_event_t *due_event(uint64_t now_us)
+{
+    const ipc_input_event_t *ev = ipc_channel_peek(&ipc_input_channel);
+    if(ev == NULL || ev->at_us > now_us)
+        return NULL;
+    return ev;
+}
+
+/********************************************************************************
+function:	Ready the read timer of the input device an event is for
+parameter:
+********************************************************************************/
+static void ready_reader(const ipc_input_event_t *ev)
+{
+    lv_timer_t *read_timer = ev->type == IPC_INPUT_KEY ?
+        keypad_drv.read_timer : lv_indev_get_read_timer(pointer_indev);
+    lv_timer_resume(read_timer);
+    lv_timer_ready(read_timer);
+}
+
+static void release_event(const ipc_input_event_t *ev, uint64_t now_us)
+{
+    uint32_t late_us = (uint32_t)(now_us - ev->at_us);
+    stats.events++;
+    stats.late_us_last = late_us;
+    stats.late_us_total += late_us;
+    if(late_us > stats.late_us_max)
+        stats.late_us_max = late_us;
+    if(late_us > late_us_window)
+        late_us_window = late_us;
+    ipc_channel_release(&ipc_input_channel);
+}
+
+/********************************************************************************
+function:	Register the keypad for injected keys and take the input doorbell
+parameter:
+    pointer : The touch screen input device, whose read_cb calls
+              ui_input_read_pointer
+********************************************************************************/
+void ui_input_init(lv_indev_t *pointer)
+{
+    pointer_indev = pointer;
+    owned = false;
+    held = false;
+    key_down = false;
+    memset(&stats, 0, sizeof(stats));
+
+    group = lv_group_create();
+    lv_indev_drv_init(&keypad_drv);
+    keypad_drv.type = LV_INDEV_TYPE_KEYPAD;
+    keypad_drv.read_cb = keypad_read_cb;
+    keypad_indev = lv_indev_drv_register(&keypad_drv);
+    lv_indev_set_group(keypad_indev, group);
+    lv_timer_pause(keypad_drv.read_timer); // Readied by ui_input_poll
+
+    ipc_channel_enable_doorbell(&ipc_input_channel);
+}
+
+/********************************************************************************
+function:	Group the injected keys go to. Add its objects without
+            LV_OBJ_FLAG_SCROLL_ON_FOCUS, or the first one added scrolls into
+            view as it takes the focus.
+parameter:
+********************************************************************************/
+lv_group_t *ui_input_group(void)
+{
+    return group;
+}
+
+/********************************************************************************
+function:	Ready the read timer of the device the next event is for, once it
+            is due. Call from the LVGL loop before lv_timer_handler.
+parameter:
+    next_ms : Set to the time until the next event, UINT32_MAX if none
+return:     true while injected input is due or an injected press is held
+********************************************************************************/
+bool ui_input_poll(uint32_t *next_ms)
+{
+    *next_ms = UINT32_MAX;
+    if(pointer_indev == NULL)
+        return false;
+    const ipc_input_event_t *ev = ipc_channel_peek(&ipc_input_channel);
+    if(ev == NULL)
+        return held;
+
+    uint64_t now_us = time_us_64();
+    if(ev->at_us > now_us)
+    {
+        *next_ms = (uint32_t)((ev->at_us - now_us + 999) / 1000);
+        return held;
+    }
+
+    ready_reader(ev);
+    return true;
+}
+
+/********************************************************************************
+function:	Apply the due pointer events, called first by the touch read_cb
+parameter:
+    data    : Filled while the injected pointer is owned
+    gesture : Set to the code of a due gesture event
+return:     false when the touch controller owns the pointer
+********************************************************************************/
+bool ui_input_read_pointer(lv_indev_data_t *data, uint8_t *gesture)
+{
+    uint64_t now_us = time_us_64();
+    const ipc_input_event_t *ev;
+    bool changed = false;
+
+    while(!changed && (ev = due_event(now_us)) != NULL)
+    {
+        if(ev->type == IPC_INPUT_KEY)
+            break; // For the keypad, the events stay in order
+        switch(ev->type)
+        {
+        case IPC_INPUT_GESTURE:
+            *gesture = (uint8_t)ev->x;
+            stats.gestures++;
+            break;
+        case IPC_INPUT_PRESS:
+            point.x = ev->x;
+            point.y = ev->y;
+            held = true;
+            owned = true;
+            changed = true;
+            stats.presses++;
+            break;
+        default:
+            held = false;
+            owned = true;
+            changed = true;
+            stats.releases++;
+            break;
+        }
+        release_event(ev, now_us);
+    }
+
+    if(!owned)
+        return false;
+
+    data->point = point;
+    data->state = held ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    if(!held)
+        owned = false; // The release is reported, back to the touch controller
+    ev = due_event(now_us);
+    data->continue_reading = ev != NULL && ev->type != IPC_INPUT_KEY;
+    if(ev != NULL && ev->type == IPC_INPUT_KEY)
+        ready_reader(ev); // Next is a key, in this timer pass
+    return true;
+}
+
+/********************************************************************************
+function:	Keypad read callback, pauses its timer once no key is due
+parameter:
+********************************************************************************/
+static void keypad_read_cb(lv_indev_drv_t * drv, lv_indev_data_t * data)
+{
+    uint64_t now_us = time_us_64();
+    const ipc_input_event_t *ev;
+
+    data->state = LV_INDEV_STATE_RELEASED;
+    if(key_down)
+    {
+        key_down = false; // Every injected key is a press and a release
+    }
+    else if((ev = due_event(now_us)) != NULL && ev->type == IPC_INPUT_KEY)
+    {
+        key = (uint32_t)ev->x;
+        key_down = true;
+        data->state = LV_INDEV_STATE_PRESSED;
+        stats.keys++;
+        release_event(ev, now_us);
+    }
+    data->key = key;
+
+    ev = due_event(now_us);
+    data->continue_reading = key_down || (ev != NULL && ev->type == IPC_INPUT_KEY);
+    if(data->continue_reading)
+        return;
+    lv_timer_pause(drv->read_timer);
+    if(ev != NULL)
+        ready_reader(ev); // Next is a pointer event
+}
+
+void ui_input_get_stats(ui_input_stats_t *out)
+{
+    *out = stats;
+}
+
+/********************************************************************************
+function:	Longest lateness since the last call, for the telemetry snapshot
+parameter:
+********************************************************************************/
+uint32_t ui_input_take_late_max(void)
+{
+    uint32_t late_us = late_us_window;
+    late_us_window = 0;
+    return late_us;
+}
@@ -0,0 +1,47 @@
+/*****************************************************************************
+* | File        :   ui_input.h
+* | Function    :   Injected touch, gesture and key input from core0
+* | Info        :
+*----------------
+* | uros_input turns ui_input messages into events on ipc_input_channel,
+* | each due at a time_us_64 instant. They are merged into the LVGL input
+* | stream here, at their time rather than when the message arrived:
+* |   pointer  ts_read_cb asks ui_input_read_pointer first; while an
+* |            injected press is held it owns the pointer, otherwise the
+* |            touch controller does
+* |   gesture  handed to ts_read_cb, which treats it like a CST816S one
+* |   key      a keypad input device on ui_input_group (the tile4 controls)
+* | Events leave the channel in order, so a key waits for the pointer
+* | events before it and the other way round. Lateness is measured from
+* | the due time to the read that applies the event.
+* |
+* | Runs on the LVGL core only. ui_input_poll, from the LVGL loop, readies
+* | the input read timers when an event is due and tells the loop how long
+* | it may sleep before the next one.
+******************************************************************************/
+#ifndef _UI_INPUT_H_
+#define _UI_INPUT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lvgl.h"
+
+typedef struct {
+    uint32_t events;          // Applied, all types
+    uint32_t presses;
+    uint32_t releases;
+    uint32_t keys;
+    uint32_t gestures;
+    uint32_t late_us_last;    // Due time to the read that applied it
+    uint32_t late_us_max;
+    uint64_t late_us_total;
+} ui_input_stats_t;
+
+void ui_input_init(lv_indev_t *pointer);
+lv_group_t *ui_input_group(void);
+bool ui_input_poll(uint32_t *next_ms);
+bool ui_input_read_pointer(lv_indev_data_t *data, uint8_t *gesture);
+void ui_input_get_stats(ui_input_stats_t *stats);
+uint32_t ui_input_take_late_max(void);
+
+#endif
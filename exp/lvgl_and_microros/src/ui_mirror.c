@@ -0,0 +1,291 @@
+/*****************************************************************************
+* | File        :   ui_mirror.c
+* | Function    :   Screen mirror: RLE encoded dirty rectangles to core0
+* | Info        :
+*----------------
+* | Runs on the LVGL core only: ui_mirror_flush from disp_flush_cb, the
+* | rest from the LVGL loop. The flushed buffer is only read, next to the
+* | DMA that sends it to the panel, and the chunks are filled in place in
+* | the channel slots.
+* |
+* | The missed area is kept in panel coordinates, like the flushed areas,
+* | and mapped back through the display rotation to be invalidated.
+******************************************************************************/
+#include "ui_mirror.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ipc_channel.h"
+
+#define RLE_RUN_MIN     2
+#define RLE_RUN_MAX     (0x7f + RLE_RUN_MIN)
+#define RLE_LITERAL_MAX 0x80
+
+static lv_disp_t *mirror_disp;
+static bool enabled;
+static bool missed_valid;
+static lv_area_t missed;          // Panel coordinates
+static uint32_t retry_ms;
+
+static uint16_t frame;
+static uint32_t frame_us;         // Encoding time of the current refresh
+static bool frame_sent;
+static ui_mirror_stats_t stats;
+
+// Chunk being filled
+static ipc_mirror_chunk_t *chunk;
+static uint16_t chunk_pixels;
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void add_missed(const lv_area_t *area)
+{
+    if(missed_valid)
+    {
+        _lv_area_join(&missed, &missed, area);
+    }
+    else
+    {
+        missed = *area;
+        missed_valid = true;
+    }
+}
+
+/********************************************************************************
+function:	Reserve a channel slot and write the chunk header
+parameter:
+return:     false if the channel is full
+********************************************************************************/
+static bool chunk_open(const lv_area_t *area, uint32_t start)
+{
+    chunk = ipc_channel_reserve(&ipc_mirror_channel);
+    if(chunk == NULL)
+        return false;
+
+    uint8_t *h = chunk->data;
+    put_u16(h + 0, frame);
+    put_u16(h + 2, (uint16_t)area->x1);
+    put_u16(h + 4, (uint16_t)area->y1);
+    put_u16(h + 6, (uint16_t)lv_area_get_width(area));
+    put_u16(h + 8, (uint16_t)lv_area_get_height(area));
+    put_u32(h + 12, start);
+    put_u16(h + 16, (uint16_t)mirror_disp->driver->hor_res);
+    put_u16(h + 18, (uint16_t)mirror_disp->driver->ver_res);
+    h[21] = 0;
+    chunk->flush_us = time_us_64();
+    chunk->len = UI_MIRROR_HEADER;
+    chunk_pixels = 0;
+    return true;
+}
+
+static void chunk_close(bool last)
+{
+    uint8_t *h = chunk->data;
+    put_u16(h + 10, chunk_pixels);
+    h[20] = (LV_COLOR_16_SWAP ? UI_MIRROR_SWAP : 0) | (last ? UI_MIRROR_LAST : 0);
+    stats.chunks++;
+    stats.bytes += chunk->len;
+    stats.pixels += chunk_pixels;
+    ipc_channel_commit(&ipc_mirror_channel);
+    chunk = NULL;
+    frame_sent = true;
+}
+
+/********************************************************************************
+function:	Encode one RLE token at px[i] into the open chunk
+parameter:
+    px : Area pixels
+    i  : First pixel of the token
+    n  : Pixels in the area
+return:     Pixels consumed, 0 when the chunk has no room left
+********************************************************************************/
+static uint32_t encode_token(const uint16_t *px, uint32_t i, uint32_t n)
+{
+    uint8_t *out = chunk->data + chunk->len;
+    uint32_t room = IPC_MIRROR_CHUNK - chunk->len;
+    if(room < 3)
+        return 0;
+
+    uint16_t v = px[i];
+    uint32_t run = 1;
+    while(i + run < n && run < RLE_RUN_MAX && px[i + run] == v)
+        run++;
+    if(run >= RLE_RUN_MIN)
+    {
+        out[0] = (uint8_t)(0x80 + run - RLE_RUN_MIN);
+        memcpy(out + 1, &v, 2);
+        chunk->len += 3;
+        return run;
+    }
+
+    // Literal up to the next run, the end of the area or the room left
+    uint32_t max = MIN(RLE_LITERAL_MAX, (room - 1) / 2);
+    uint32_t lit = 1;
+    while(lit < max && i + lit < n &&
+          !(i + lit + 1 < n && px[i + lit] == px[i + lit + 1]))
+        lit++;
+    out[0] = (uint8_t)(lit - 1);
+    memcpy(out + 1, px + i, lit * 2);
+    chunk->len += 1 + lit * 2;
+    return lit;
+}
+
+/********************************************************************************
+function:	Set the display whose flushes are mirrored
+parameter:
+********************************************************************************/
+void ui_mirror_init(lv_disp_t *disp)
+{
+    mirror_disp = disp;
+    enabled = false;
+    missed_valid = false;
+    memset(&stats, 0, sizeof(stats));
+}
+
+/********************************************************************************
+function:	Start or stop mirroring. Starting sends the whole screen once.
+parameter:
+********************************************************************************/
+void ui_mirror_enable(bool enable)
+{
+    enabled = enable;
+    missed_valid = false;
+    if(enable && mirror_disp != NULL)
+    {
+        lv_area_t all = { 0, 0, mirror_disp->driver->hor_res - 1, mirror_disp->driver->ver_res - 1 };
+        add_missed(&all);
+        retry_ms = lv_tick_get() - UI_MIRROR_RETRY_MS;
+    }
+}
+
+/********************************************************************************
+function:	Encode a flushed area, called from disp_flush_cb after the DMA
+            has been started
+parameter:
+    area    : Flushed area, panel coordinates
+    color_p : Its pixels
+    last    : lv_disp_flush_is_last, ends the refresh
+********************************************************************************/
+void ui_mirror_flush(const lv_area_t *area, const lv_color_t *color_p, bool last)
+{
+    if(!enabled)
+        return;
+
+    uint32_t start_us = time_us_32();
+    const uint16_t *px = (const uint16_t *)color_p;
+    uint32_t w = lv_area_get_width(area);
+    uint32_t n = w * lv_area_get_height(area);
+    uint32_t i = 0;
+    bool cut = false;
+
+    if(frame_us >= UI_MIRROR_BUDGET_US)
+    {
+        cut = true;
+        stats.over_budget++;
+    }
+    while(!cut && i < n)
+    {
+        // Budget and room are checked per chunk, a few hundred pixels
+        if(frame_us + (time_us_32() - start_us) >= UI_MIRROR_BUDGET_US)
+        {
+            stats.over_budget++;
+            cut = true;
+            break;
+        }
+        if(!chunk_open(area, i))
+        {
+            stats.channel_full++;
+            cut = true;
+            break;
+        }
+        uint32_t used;
+        while(i < n && (used = encode_token(px, i, n)) != 0)
+        {
+            i += used;
+            chunk_pixels += used;
+        }
+        chunk_close(last && i == n);
+    }
+
+    if(cut)
+    {
+        // Send the rest again later, from the row it stopped in
+        lv_area_t rest = *area;
+        rest.y1 += i / w;
+        add_missed(&rest);
+    }
+
+    frame_us += time_us_32() - start_us;
+    if(last)
+    {
+        if(frame_us > stats.encode_us_max)
+            stats.encode_us_max = frame_us;
+        if(frame_sent)
+            stats.frames++;
+        frame++;
+        frame_us = 0;
+        frame_sent = false;
+    }
+}
+
+/********************************************************************************
+function:	Invalidate the missed area again once the channel has drained.
+            Call from the LVGL loop before lv_timer_handler.
+parameter:
+return:     true if an area was invalidated, the refresh timer must run
+********************************************************************************/
+bool ui_mirror_poll(void)
+{
+    if(!enabled || !missed_valid ||
+       ipc_channel_count(&ipc_mirror_channel) > IPC_MIRROR_SLOTS / 2 ||
+       lv_tick_elaps(retry_ms) < UI_MIRROR_RETRY_MS)
+        return false;
+
+    // Panel to screen coordinates, the inverse of the software rotation
+    lv_disp_drv_t *drv = mirror_disp->driver;
+    lv_area_t a;
+    switch(drv->rotated)
+    {
+    case LV_DISP_ROT_90:
+        a.x1 = drv->ver_res - 1 - missed.y2;
+        a.x2 = drv->ver_res - 1 - missed.y1;
+        a.y1 = missed.x1;
+        a.y2 = missed.x2;
+        break;
+    case LV_DISP_ROT_180:
+        a.x1 = drv->hor_res - 1 - missed.x2;
+        a.x2 = drv->hor_res - 1 - missed.x1;
+        a.y1 = drv->ver_res - 1 - missed.y2;
+        a.y2 = drv->ver_res - 1 - missed.y1;
+        break;
+    case LV_DISP_ROT_270:
+        a.x1 = missed.y1;
+        a.x2 = missed.y2;
+        a.y1 = drv->hor_res - 1 - missed.x2;
+        a.y2 = drv->hor_res - 1 - missed.x1;
+        break;
+    default:
+        a = missed;
+        break;
+    }
+    _lv_inv_area(mirror_disp, &a);
+    missed_valid = false;
+    retry_ms = lv_tick_get();
+    stats.retries++;
+    return true;
+}
+
+void ui_mirror_get_stats(ui_mirror_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,62 @@
+/*****************************************************************************
+* | File        :   ui_mirror.h
+* | Function    :   Screen mirror: RLE encoded dirty rectangles to core0
+* | Info        :
+*----------------
+* | disp_flush_cb hands every flushed area to ui_mirror_flush while its DMA
+* | runs. The pixels are run length encoded into chunks on
+* | ipc_mirror_channel, which uros_mirror publishes, so the bandwidth
+* | follows what changes on screen rather than its size.
+* |
+* | Encoding is limited to UI_MIRROR_BUDGET_US per refresh. Areas that do
+* | not fit the budget, or find the channel full, are collected and
+* | invalidated again once the channel has drained, so the viewer still
+* | converges on the screen content.
+* |
+* | Chunk layout (little endian), the header followed by RLE data:
+* |   u16 frame     refresh counter
+* |   u16 x, y, w, h  flushed area, panel coordinates
+* |   u16 pixels    pixels encoded in this chunk
+* |   u32 start     index of its first pixel in the area, row major
+* |   u16 screen_w, screen_h
+* |   u8  flags     UI_MIRROR_*
+* |   u8  reserved
+* | RLE on RGB565 pixels, in the byte order sent to the panel:
+* |   c < 0x80   literal, c + 1 pixels follow
+* |   c >= 0x80  run, c - 0x80 + 2 copies of the pixel that follows
+* | tools/mirror_view.py reassembles the frames.
+******************************************************************************/
+#ifndef _UI_MIRROR_H_
+#define _UI_MIRROR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lvgl.h"
+
+#ifndef UI_MIRROR_BUDGET_US
+#define UI_MIRROR_BUDGET_US   2000  // Encoding time allowed per refresh
+#endif
+#define UI_MIRROR_RETRY_MS    100   // Least time between re-invalidations
+
+#define UI_MIRROR_HEADER      22
+#define UI_MIRROR_LAST        0x01  // Last chunk of the refresh
+#define UI_MIRROR_SWAP        0x02  // Pixels are byte swapped (LV_COLOR_16_SWAP)
+
+typedef struct {
+    uint32_t frames;          // Refreshes with at least one chunk
+    uint32_t chunks;
+    uint64_t bytes;           // Chunk bytes, header included
+    uint64_t pixels;
+    uint32_t over_budget;     // Areas cut short by UI_MIRROR_BUDGET_US
+    uint32_t channel_full;    // Areas cut short by a full channel
+    uint32_t retries;         // Re-invalidations of the missed area
+    uint32_t encode_us_max;   // Longest encoding time of one refresh
+} ui_mirror_stats_t;
+
+void ui_mirror_init(lv_disp_t *disp);
+void ui_mirror_enable(bool enable);
+void ui_mirror_flush(const lv_area_t *area, const lv_color_t *color_p, bool last);
+bool ui_mirror_poll(void);
+void ui_mirror_get_stats(ui_mirror_stats_t *stats);
+
+#endif
@@ -0,0 +1,109 @@
+/*****************************************************************************
+* | File        :   ui_queue.c
+* | Function    :   Widget update queue between producers and the LVGL loop
+* | Info        :
+*----------------
+* | The Cortex-M0+ has no exclusive load/store, so producers serialise on a
+* | hardware spinlock for the few cycles it takes to copy one record. The
+* | single consumer never takes the lock: it reads the published head and
+* | releases slots by advancing the tail.
+******************************************************************************/
+#include "ui_queue.h"
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+static ui_update_t slots[UI_QUEUE_SIZE];
+static volatile uint32_t head;    // Written by producers under the lock
+static volatile uint32_t tail;    // Written by the consumer only
+static volatile uint32_t dropped;
+static spin_lock_t *lock;
+static void (*volatile notify_consumer)(void);
+
+/********************************************************************************
+function:	Claim the producer spinlock, call once before any post
+parameter:
+********************************************************************************/
+void ui_queue_init(void)
+{
+    if (lock == NULL)
+        lock = spin_lock_instance(spin_lock_claim_unused(true));    // Counted in IPC_CLAIMED_SPIN_LOCKS
+    head = 0;
+    tail = 0;
+    dropped = 0;
+}
+
+/********************************************************************************
+function:	Set a function called after every post to wake the consumer. It
+            runs in the producer's context, so it must be IRQ and core safe.
+parameter:
+********************************************************************************/
+void ui_queue_set_notify(void (*notify)(void))
+{
+    notify_consumer = notify;
+}
+
+/********************************************************************************
+function:	Post an update record, never blocks
+parameter:
+return:     false if the queue was full and the record dropped
+********************************************************************************/
+bool ui_queue_post(const ui_update_t *update)
+{
+    uint32_t save = spin_lock_blocking(lock);
+    uint32_t h = head;
+    if (h - tail >= UI_QUEUE_SIZE)
+    {
+        dropped++;
+        spin_unlock(lock, save);
+        return false;
+    }
+    slots[h & (UI_QUEUE_SIZE - 1)] = *update;
+    __dmb();
+    head = h + 1;
+    spin_unlock(lock, save);
+
+    void (*notify)(void) = notify_consumer;
+    if (notify != NULL)
+        notify();
+    return true;
+}
+
+bool ui_queue_post_float(ui_update_type_t type, uint8_t index, float value)
+{
+    ui_update_t update = { .type = type, .index = index, .value.f = value };
+    return ui_queue_post(&update);
+}
+
+bool ui_queue_post_int(ui_update_type_t type, uint8_t index, int32_t value)
+{
+    ui_update_t update = { .type = type, .index = index, .value.i = value };
+    return ui_queue_post(&update);
+}
+
+/********************************************************************************
+function:	Copy out up to max pending records in post order
+parameter:
+return:     Number of records copied
+********************************************************************************/
+uint32_t ui_queue_drain(ui_update_t *updates, uint32_t max)
+{
+    uint32_t t = tail;
+    uint32_t h = head;
+    __dmb();
+
+    uint32_t n = 0;
+    while (t != h && n < max)
+    {
+        updates[n++] = slots[t & (UI_QUEUE_SIZE - 1)];
+        t++;
+    }
+    __dmb();
+    tail = t;
+    return n;
+}
+
+uint32_t ui_queue_dropped(void)
+{
+    return dropped;
+}
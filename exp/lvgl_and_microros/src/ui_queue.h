@@ -0,0 +1,45 @@
+/*****************************************************************************
+* | File        :   ui_queue.h
+* | Function    :   Widget update queue between producers and the LVGL loop
+* | Info        :
+*----------------
+* | Producers (scheduler tasks, IRQ handlers or the other core) post compact
+* | update records. Only the LVGL loop drains the queue and touches widgets.
+* | Posting is safe from any core and from IRQ context; draining must only be
+* | done by one consumer.
+******************************************************************************/
+#ifndef _UI_QUEUE_H_
+#define _UI_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UI_QUEUE_SIZE 64 // Must be a power of two
+
+typedef enum {
+    UI_UPDATE_IMU = 0,   // index 0-2 acc xyz (mg), 3-5 gyro xyz (dps)
+    UI_UPDATE_RTC,       // index 0-5 year, month, day, hour, min, sec
+    UI_UPDATE_TYPES
+} ui_update_type_t;
+
+typedef struct {
+    uint8_t type;        // ui_update_type_t
+    uint8_t index;
+    uint16_t reserved;
+    union {
+        float f;
+        int32_t i;
+    } value;
+} ui_update_t;
+
+void ui_queue_init(void);
+void ui_queue_set_notify(void (*notify)(void));
+
+bool ui_queue_post(const ui_update_t *update);
+bool ui_queue_post_float(ui_update_type_t type, uint8_t index, float value);
+bool ui_queue_post_int(ui_update_type_t type, uint8_t index, int32_t value);
+
+uint32_t ui_queue_drain(ui_update_t *updates, uint32_t max);
+uint32_t ui_queue_dropped(void);
+
+#endif
@@ -0,0 +1,291 @@
+/*****************************************************************************
+* | File        :   uros_alloc.c
+* | Function    :   Fixed size allocator for micro-ROS (rcl / rmw)
+* | Info        :
+*----------------
+* | Each pool is a contiguous run of equal blocks, so the owning class of a
+* | pointer is found by range checks and blocks need no header. Arena blocks
+* | carry an 8 byte header holding their size, for reallocate and for LIFO
+* | reclaim.
+******************************************************************************/
+#include "uros_alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <rcutils/allocator.h>
+
+#define UROS_ARENA_MAGIC 0x55524f53u
+
+typedef struct pool_block {
+    struct pool_block *next;
+} pool_block_t;
+
+typedef struct {
+    uint8_t *start;
+    uint8_t *end;
+    pool_block_t *free;
+} pool_t;
+
+typedef struct {
+    uint32_t size;
+    uint32_t magic;
+} arena_header_t;
+
+static const uint16_t class_size[UROS_ALLOC_CLASSES] = {
+    16, 32, 64, 128, 256, 512
+};
+static const uint16_t class_blocks[UROS_ALLOC_CLASSES] = {
+    UROS_ALLOC_BLOCKS_16, UROS_ALLOC_BLOCKS_32, UROS_ALLOC_BLOCKS_64,
+    UROS_ALLOC_BLOCKS_128, UROS_ALLOC_BLOCKS_256, UROS_ALLOC_BLOCKS_512
+};
+
+static uint64_t pool_storage[UROS_ALLOC_POOL_BYTES / sizeof(uint64_t)];
+static uint64_t arena_storage[UROS_ALLOC_ARENA_BYTES / sizeof(uint64_t)];
+static uint32_t arena_top;
+static pool_t pools[UROS_ALLOC_CLASSES];
+static uros_alloc_stats_t stats;
+static bool initialised;
+static bool sealed;
+
+/********************************************************************************
+function:	Build the free lists. Called by uros_alloc_get_allocator if needed.
+parameter:
+********************************************************************************/
+void uros_alloc_init(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    uint8_t *p = (uint8_t *)pool_storage;
+    for (int c = 0; c < UROS_ALLOC_CLASSES; c++)
+    {
+        pool_t *pool = &pools[c];
+        pool->start = p;
+        pool->free = NULL;
+        for (int i = class_blocks[c] - 1; i >= 0; i--)
+        {
+            pool_block_t *b = (pool_block_t *)(p + i * class_size[c]);
+            b->next = pool->free;
+            pool->free = b;
+        }
+        p += class_size[c] * class_blocks[c];
+        pool->end = p;
+        stats.pool[c].size = class_size[c];
+        stats.pool[c].blocks = class_blocks[c];
+    }
+    arena_top = 0;
+    stats.arena_size = UROS_ALLOC_ARENA_BYTES;
+    initialised = true;
+    sealed = false;
+}
+
+static void account(int32_t bytes)
+{
+    stats.bytes_in_use += bytes;
+    if (stats.bytes_in_use > stats.bytes_peak)
+        stats.bytes_peak = stats.bytes_in_use;
+}
+
+static void *arena_alloc(size_t size)
+{
+    uint32_t need = sizeof(arena_header_t) + ((size + 7) & ~7u);
+    if (need > UROS_ALLOC_ARENA_BYTES - arena_top)
+        return NULL;
+    arena_header_t *h = (arena_header_t *)((uint8_t *)arena_storage + arena_top);
+    h->size = need - sizeof(arena_header_t);
+    h->magic = UROS_ARENA_MAGIC;
+    arena_top += need;
+    stats.arena_used = arena_top;
+    if (arena_top > stats.arena_peak)
+        stats.arena_peak = arena_top;
+    account(h->size);
+    return h + 1;
+}
+
+static void *uros_allocate(size_t size, void *state)
+{
+    (void)state;
+    if (sealed)
+    {
+        stats.runtime_allocs++;
+        if (size > stats.runtime_size_max)
+            stats.runtime_size_max = size;
+    }
+
+    int c = 0;
+    while (c < UROS_ALLOC_CLASSES && size > class_size[c])
+        c++;
+
+    for (int k = c; k < UROS_ALLOC_CLASSES; k++)
+    {
+        pool_t *pool = &pools[k];
+        pool_block_t *b = pool->free;
+        if (b == NULL)
+            continue;
+        pool->free = b->next;
+
+        uros_alloc_pool_stats_t *s = &stats.pool[k];
+        s->allocs++;
+        if (k != c)
+            s->spills++;
+        if (++s->in_use > s->peak)
+            s->peak = s->in_use;
+        account(class_size[k]);
+        return b;
+    }
+
+    void *p = arena_alloc(size);
+    if (p == NULL)
+    {
+        stats.failures++;
+        if (size > stats.failure_size_max)
+            stats.failure_size_max = size;
+    }
+    return p;
+}
+
+static int owning_class(const void *ptr)
+{
+    const uint8_t *p = ptr;
+    for (int c = 0; c < UROS_ALLOC_CLASSES; c++)
+    {
+        if (p >= pools[c].start && p < pools[c].end)
+            return c;
+    }
+    return -1;
+}
+
+static arena_header_t *arena_header(void *ptr)
+{
+    uint8_t *p = ptr;
+    uint8_t *base = (uint8_t *)arena_storage;
+    if (p < base + sizeof(arena_header_t) || p >= base + UROS_ALLOC_ARENA_BYTES)
+        return NULL;
+    arena_header_t *h = (arena_header_t *)p - 1;
+    return h->magic == UROS_ARENA_MAGIC ? h : NULL;
+}
+
+static void uros_deallocate(void *ptr, void *state)
+{
+    (void)state;
+    if (ptr == NULL)
+        return;
+
+    int c = owning_class(ptr);
+    if (c >= 0)
+    {
+        pool_block_t *b = ptr;
+        b->next = pools[c].free;
+        pools[c].free = b;
+        stats.pool[c].in_use--;
+        account(-(int32_t)class_size[c]);
+        return;
+    }
+
+    arena_header_t *h = arena_header(ptr);
+    if (h != NULL)
+    {
+        account(-(int32_t)h->size);
+        h->magic = 0;
+        // Only the most recent block can be given back
+        if ((uint8_t *)ptr + h->size == (uint8_t *)arena_storage + arena_top)
+        {
+            arena_top = (uint8_t *)h - (uint8_t *)arena_storage;
+            stats.arena_used = arena_top;
+        }
+        return;
+    }
+
+    // Allocated before the allocator was installed
+    stats.foreign_frees++;
+    free(ptr);
+}
+
+static void *uros_reallocate(void *ptr, size_t size, void *state)
+{
+    if (ptr == NULL)
+        return uros_allocate(size, state);
+
+    size_t capacity;
+    int c = owning_class(ptr);
+    if (c >= 0)
+    {
+        capacity = class_size[c];
+    }
+    else
+    {
+        arena_header_t *h = arena_header(ptr);
+        if (h == NULL)
+        {
+            stats.foreign_frees++;
+            return realloc(ptr, size);
+        }
+        capacity = h->size;
+    }
+    if (size <= capacity)
+        return ptr;
+
+    void *p = uros_allocate(size, state);
+    if (p != NULL)
+    {
+        memcpy(p, ptr, capacity);
+        uros_deallocate(ptr, state);
+    }
+    return p;
+}
+
+static void *uros_zero_allocate(size_t count, size_t size, void *state)
+{
+    if (size != 0 && count > SIZE_MAX / size)
+    {
+        stats.failures++;
+        return NULL;
+    }
+    void *p = uros_allocate(count * size, state);
+    if (p != NULL)
+        memset(p, 0, count * size);
+    return p;
+}
+
+/********************************************************************************
+function:	rcl allocator backed by the pools, pass to rclc_support_init and
+            rclc_executor_init
+parameter:
+********************************************************************************/
+rcl_allocator_t uros_alloc_get_allocator(void)
+{
+    if (!initialised)
+        uros_alloc_init();
+
+    rcl_allocator_t allocator = {
+        .allocate = uros_allocate,
+        .deallocate = uros_deallocate,
+        .reallocate = uros_reallocate,
+        .zero_allocate = uros_zero_allocate,
+        .state = NULL,
+    };
+    return allocator;
+}
+
+/********************************************************************************
+function:	Make the pools the rcutils default, so allocations rmw makes
+            through rcutils_get_default_allocator are bounded too
+parameter:
+********************************************************************************/
+bool uros_alloc_set_default(void)
+{
+    rcl_allocator_t allocator = uros_alloc_get_allocator();
+    return rcutils_set_default_allocator(&allocator);
+}
+
+/********************************************************************************
+function:	End of set up: count every allocation from now on in runtime_allocs
+parameter:
+********************************************************************************/
+void uros_alloc_seal(void)
+{
+    sealed = true;
+}
+
+void uros_alloc_get_stats(uros_alloc_stats_t *out)
+{
+    *out = stats;
+}
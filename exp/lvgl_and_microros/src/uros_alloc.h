@@ -0,0 +1,89 @@
+/*****************************************************************************
+* | File        :   uros_alloc.h
+* | Function    :   Fixed size allocator for micro-ROS (rcl / rmw)
+* | Info        :
+*----------------
+* | Requests are served from size class pools (16 to 512 bytes) with O(1)
+* | free lists. When a class is exhausted the request spills to the next
+* | larger class. Anything bigger than the largest class is bump allocated
+* | from a small arena, which is only reclaimed in LIFO order; those are
+* | the one-off buffers created while the session and entities are set up.
+* | Nothing falls back to malloc, so the ROS stack's memory use is bounded
+* | by UROS_ALLOC_TOTAL_BYTES and a failure is counted, not hidden.
+* |
+* | uros_alloc_seal marks the end of set up: allocations after it are
+* | counted in runtime_allocs, which should stay zero once messages come
+* | from uros_msgpool.
+* |
+* | Not thread safe: only the micro-ROS executor task/core may allocate.
+******************************************************************************/
+#ifndef _UROS_ALLOC_H_
+#define _UROS_ALLOC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <rcl/allocator.h>
+
+/* Blocks per size class, override with compile definitions */
+#ifndef UROS_ALLOC_BLOCKS_16
+#define UROS_ALLOC_BLOCKS_16  32
+#endif
+#ifndef UROS_ALLOC_BLOCKS_32
+#define UROS_ALLOC_BLOCKS_32  32
+#endif
+#ifndef UROS_ALLOC_BLOCKS_64
+#define UROS_ALLOC_BLOCKS_64  32
+#endif
+#ifndef UROS_ALLOC_BLOCKS_128
+#define UROS_ALLOC_BLOCKS_128 16
+#endif
+#ifndef UROS_ALLOC_BLOCKS_256
+#define UROS_ALLOC_BLOCKS_256 8
+#endif
+#ifndef UROS_ALLOC_BLOCKS_512
+#define UROS_ALLOC_BLOCKS_512 4
+#endif
+#ifndef UROS_ALLOC_ARENA_BYTES
+#define UROS_ALLOC_ARENA_BYTES 4096
+#endif
+
+#define UROS_ALLOC_CLASSES 6
+
+#define UROS_ALLOC_POOL_BYTES                                           \
+    (16 * UROS_ALLOC_BLOCKS_16 + 32 * UROS_ALLOC_BLOCKS_32 +            \
+     64 * UROS_ALLOC_BLOCKS_64 + 128 * UROS_ALLOC_BLOCKS_128 +          \
+     256 * UROS_ALLOC_BLOCKS_256 + 512 * UROS_ALLOC_BLOCKS_512)
+
+#define UROS_ALLOC_TOTAL_BYTES (UROS_ALLOC_POOL_BYTES + UROS_ALLOC_ARENA_BYTES)
+
+typedef struct {
+    uint16_t size;                // Block size in bytes
+    uint16_t blocks;
+    uint16_t in_use;
+    uint16_t peak;
+    uint32_t allocs;
+    uint32_t spills;              // Allocations that wanted a smaller class
+} uros_alloc_pool_stats_t;
+
+typedef struct {
+    uros_alloc_pool_stats_t pool[UROS_ALLOC_CLASSES];
+    uint32_t arena_size;
+    uint32_t arena_used;
+    uint32_t arena_peak;
+    uint32_t bytes_in_use;        // Pool blocks plus arena, as allocated
+    uint32_t bytes_peak;
+    uint32_t failures;
+    uint32_t failure_size_max;    // Largest request that could not be met
+    uint32_t foreign_frees;       // Pointers not from this allocator
+    uint32_t runtime_allocs;      // Allocations and growing reallocations after uros_alloc_seal
+    uint32_t runtime_size_max;    // Largest of those
+} uros_alloc_stats_t;
+
+void uros_alloc_init(void);
+rcl_allocator_t uros_alloc_get_allocator(void);
+bool uros_alloc_set_default(void);
+void uros_alloc_seal(void);
+
+void uros_alloc_get_stats(uros_alloc_stats_t *stats);
+
+#endif
@@ -0,0 +1,45 @@
+#include "uros_boot.h"
+
+#include "pico/stdlib.h"
+
+#include <rcl/rcl.h>
+#include <std_msgs/msg/string.h>
+
+#include "uros_msgpool.h"
+
+#define BOOT_MEMORY	(UROS_BOOT_BYTES + 16)
+
+static rcl_publisher_t boot_publisher;
+UROS_MSGPOOL_DEFINE(boot_msgpool, std_msgs__msg__String, 1, BOOT_MEMORY);
+
+/***
+ * Create the publisher and send the timeline as it stands, with
+ * BOOT_ROS_READY already signalled
+ * @return false if the publisher could not be created or the send failed
+ */
+bool uros_boot_publish(rcl_node_t *node){
+	micro_ros_utilities_memory_conf_t conf = micro_ros_utilities_memory_conf_default;
+	conf.max_string_capacity = UROS_BOOT_BYTES;
+	if (!uros_msgpool_init(&boot_msgpool,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String), &conf)){
+		return false;
+	}
+
+	rmw_qos_profile_t qos = rmw_qos_profile_default;
+	qos.durability = RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL;
+	qos.depth = 1;
+	if (rclc_publisher_init(
+		&boot_publisher,
+		node,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String),
+		"boot",
+		&qos) != RCL_RET_OK){
+		return false;
+	}
+
+	std_msgs__msg__String *msg = uros_msgpool_take(&boot_msgpool);
+	msg->data.size = boot_format(msg->data.data, msg->data.capacity);
+	bool sent = rcl_publish(&boot_publisher, msg, NULL) == RCL_RET_OK;
+	uros_msgpool_give(&boot_msgpool, msg);
+	return sent;
+}
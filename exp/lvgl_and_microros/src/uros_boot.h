@@ -0,0 +1,24 @@
+#ifndef _UROS_BOOT_H_
+#define _UROS_BOOT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rclc/rclc.h>
+
+#include "boot.h"
+
+/*
+ * The start up timeline (boot.h) as one std_msgs/String on "boot", the text
+ * of boot_format, sent once when the node is up. The publisher is reliable
+ * and transient local with a depth of one, so a subscriber that starts
+ * later still gets it:
+ *   ros2 topic echo --qos-durability transient_local --once /boot
+ * Takes no executor handles.
+ */
+
+#define UROS_BOOT_BYTES		1024
+
+bool uros_boot_publish(rcl_node_t *node);
+
+#endif //_UROS_BOOT_H_
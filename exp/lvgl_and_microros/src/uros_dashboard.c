@@ -0,0 +1,138 @@
+#include "uros_dashboard.h"
+
+#include "pico/stdlib.h"
+
+#include <rcl/rcl.h>
+#include <geometry_msgs/msg/vector3_stamped.h>
+
+#include "ipc_channel.h"
+#include "uros_time.h"
+#include "uros_msgpool.h"
+
+#define DASHBOARD_TOPICS	3
+#define DASHBOARD_FRAME_ID	16	// Longest frame id accepted, with the NUL
+#define DASHBOARD_MEMORY	(DASHBOARD_TOPICS * (DASHBOARD_FRAME_ID + 8))
+
+typedef enum {
+	DASHBOARD_JOG = 0,
+	DASHBOARD_STATE,
+	DASHBOARD_AXIS,
+} dashboard_topic_t;
+
+static const char *const topic_names[DASHBOARD_TOPICS] = {
+	"dashboard/jog",
+	"dashboard/state",
+	"dashboard/axis",
+};
+
+static rcl_subscription_t subscriptions[DASHBOARD_TOPICS];
+
+// One receive buffer per subscription, frame ids of DASHBOARD_FRAME_ID
+UROS_MSGPOOL_DEFINE(dashboard_msgpool, geometry_msgs__msg__Vector3Stamped, DASHBOARD_TOPICS, DASHBOARD_MEMORY);
+
+static ipc_dashboard_t state;	// Whole dashboard, the mailbox only takes full values
+static uros_dashboard_stats_t stats;
+
+/*
+ * Map the header stamp to time_us_64. Without a time sync, or with a
+ * zero or future stamp, the receive time stands in for the publish time.
+ */
+static uint64_t publish_time_us(const builtin_interfaces__msg__Time *stamp, uint64_t receive_us)
+{
+	int64_t stamp_ns = (int64_t)stamp->sec * 1000000000 + stamp->nanosec;
+	int64_t receive_ns;
+	if (stamp_ns == 0 || !uros_time_to_ros_ns(receive_us, &receive_ns)){
+		return receive_us;
+	}
+	int64_t age_ns = receive_ns - stamp_ns;
+	if (age_ns < 0 || (uint64_t)(age_ns / 1000) > receive_us){
+		return receive_us;
+	}
+
+	uint32_t transit_us = (uint32_t)(age_ns / 1000);
+	stats.stamped++;
+	stats.transit_us_last = transit_us;
+	if (transit_us > stats.transit_us_max){
+		stats.transit_us_max = transit_us;
+	}
+	return receive_us - transit_us;
+}
+
+static void dashboard_callback(const void *msgin, void *context)
+{
+	const geometry_msgs__msg__Vector3Stamped *msg = msgin;
+	dashboard_topic_t topic = (dashboard_topic_t)(uintptr_t)context;
+	uint64_t receive_us = time_us_64();
+
+	stats.received++;
+	switch (topic){
+	case DASHBOARD_JOG:
+		state.jog[0] = (float)msg->vector.x;
+		state.jog[1] = (float)msg->vector.y;
+		break;
+	case DASHBOARD_STATE:
+		state.state[0] = (float)msg->vector.x;
+		state.state[1] = (float)msg->vector.y;
+		break;
+	case DASHBOARD_AXIS:
+		state.axis[0] = (float)msg->vector.x;
+		state.axis[1] = (float)msg->vector.z;
+		break;
+	}
+	state.receive_us = receive_us;
+	state.publish_us = publish_time_us(&msg->header.stamp, receive_us);
+
+	// Straight into the producer slot, the UI core reads it in place
+	ipc_dashboard_t *slot = ipc_mailbox_write(&ipc_dashboard_mailbox);
+	*slot = state;
+	ipc_mailbox_publish(&ipc_dashboard_mailbox);
+}
+
+/***
+ * Create the subscriptions, the executor needs UROS_DASHBOARD_HANDLES handles.
+ * Call after uros_time_init so the first stamps can be used.
+ * @return false if an entity could not be created
+ */
+bool uros_dashboard_init(rcl_node_t *node, rclc_executor_t *executor){
+	// Start from the values tile1 is created with
+	state.jog[0] = 3;
+	state.jog[1] = 5;
+	state.state[0] = 9;
+	state.state[1] = 6;
+	state.axis[0] = 9;
+	state.axis[1] = 6;
+
+	micro_ros_utilities_memory_conf_t conf = micro_ros_utilities_memory_conf_default;
+	conf.max_string_capacity = DASHBOARD_FRAME_ID;
+	if (!uros_msgpool_init(&dashboard_msgpool,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(geometry_msgs, msg, Vector3Stamped), &conf)){
+		return false;
+	}
+
+	for (int i = 0; i < DASHBOARD_TOPICS; i++){
+		// Held for the life of the subscription, the executor deserialises into it
+		geometry_msgs__msg__Vector3Stamped *msg = uros_msgpool_take(&dashboard_msgpool);
+
+		if (rclc_subscription_init_best_effort(
+			&subscriptions[i],
+			node,
+			ROSIDL_GET_MSG_TYPE_SUPPORT(geometry_msgs, msg, Vector3Stamped),
+			topic_names[i]) != RCL_RET_OK){
+			return false;
+		}
+		if (rclc_executor_add_subscription_with_context(
+			executor,
+			&subscriptions[i],
+			msg,
+			dashboard_callback,
+			(void *)(uintptr_t)i,
+			ON_NEW_DATA) != RCL_RET_OK){
+			return false;
+		}
+	}
+	return true;
+}
+
+void uros_dashboard_get_stats(uros_dashboard_stats_t *out){
+	*out = stats;
+}
@@ -0,0 +1,33 @@
+#ifndef _UROS_DASHBOARD_H_
+#define _UROS_DASHBOARD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rclc/rclc.h>
+#include <rclc/executor.h>
+
+/*
+ * Subscriptions that drive the tile1 meters, all geometry_msgs/Vector3Stamped,
+ * best effort, values on the meter scale of -10..10:
+ *   dashboard/jog    x: red arc from -10, y: green arc from +10 (meterJog)
+ *   dashboard/state  same layout (meterState)
+ *   dashboard/axis   x: meterX, z: meterZ
+ * Every message publishes the whole dashboard to ipc_dashboard_mailbox.
+ * The header stamp, in agent time, is carried over to the UI so it can
+ * measure publish to pixel latency; leave it zero to measure from receipt.
+ */
+
+#define UROS_DASHBOARD_HANDLES	3	// Executor handles taken by uros_dashboard_init
+
+typedef struct {
+	uint32_t received;
+	uint32_t stamped;		// Messages with a usable agent time stamp
+	uint32_t transit_us_last;	// Agent publish to executor, stamped messages only
+	uint32_t transit_us_max;
+} uros_dashboard_stats_t;
+
+bool uros_dashboard_init(rcl_node_t *node, rclc_executor_t *executor);
+void uros_dashboard_get_stats(uros_dashboard_stats_t *stats);
+
+#endif //_UROS_DASHBOARD_H_
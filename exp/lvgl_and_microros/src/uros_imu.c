@@ -0,0 +1,137 @@
+#include "uros_imu.h"
+
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include <rcl/rcl.h>
+#include <sensor_msgs/msg/imu.h>
+
+#include "uros_transport.h"
+#include "uros_time.h"
+
+#define MG_TO_MS2	(9.80665f / 1000.0f)
+#define DPS_TO_RADS	((float)M_PI / 180.0f)
+
+static rcl_publisher_t imu_publisher;
+static rcl_timer_t imu_timer;
+static sensor_msgs__msg__Imu imu_msg;
+static char frame_id[] = UROS_IMU_FRAME_ID;
+
+static ipc_imu_sample_t latest;
+static bool have_latest;
+static uros_imu_stats_t stats;
+static uint64_t window_start_us;
+static uint32_t window_published;
+
+static void fill_msg(const ipc_imu_sample_t *sample)
+{
+	// Agent time of the sensor read, once the session clock is synchronised
+	uros_time_to_msg(sample->timestamp_us, &imu_msg.header.stamp);
+
+	imu_msg.linear_acceleration.x = sample->acc[0] * MG_TO_MS2;
+	imu_msg.linear_acceleration.y = sample->acc[1] * MG_TO_MS2;
+	imu_msg.linear_acceleration.z = sample->acc[2] * MG_TO_MS2;
+	imu_msg.angular_velocity.x = sample->gyro[0] * DPS_TO_RADS;
+	imu_msg.angular_velocity.y = sample->gyro[1] * DPS_TO_RADS;
+	imu_msg.angular_velocity.z = sample->gyro[2] * DPS_TO_RADS;
+}
+
+static void imu_timer_callback(rcl_timer_t *timer, int64_t last_call_time)
+{
+	const ipc_imu_sample_t *sample;
+	uint32_t n = 0;
+
+	if (UROS_IMU_BATCH > 1){
+		uros_transport_hold();
+	}
+	while ((sample = ipc_channel_peek(&ipc_sensor_channel)) != NULL){
+		fill_msg(sample);
+		latest = *sample;
+		have_latest = true;
+		ipc_channel_release(&ipc_sensor_channel);
+
+		if (rcl_publish(&imu_publisher, &imu_msg, NULL) == RCL_RET_OK){
+			stats.published++;
+			window_published++;
+		} else {
+			stats.publish_errors++;
+		}
+		if (UROS_IMU_BATCH > 1 && ++n % UROS_IMU_BATCH == 0){
+			uros_transport_flush();
+		}
+	}
+	if (UROS_IMU_BATCH > 1){
+		uros_transport_release();
+	}
+
+	uint64_t now = time_us_64();
+	uint64_t window_us = now - window_start_us;
+	if (window_us >= 1000000){
+		stats.rate_mhz = (uint32_t)((uint64_t)window_published * 1000000000ull / window_us);
+		window_published = 0;
+		window_start_us = now;
+
+		ipc_channel_stats_t ch;
+		ipc_channel_get_stats(&ipc_sensor_channel, &ch);
+		stats.dropped = ch.overflows + (have_latest ? latest.skipped : 0);
+	}
+}
+
+/***
+ * Create the publisher and its timer, the executor needs one handle
+ * @return false if an entity could not be created
+ */
+bool uros_imu_init(rcl_node_t *node, rclc_support_t *support, rclc_executor_t *executor){
+	// Preallocated message: fixed frame id, orientation not provided
+	memset(&imu_msg, 0, sizeof(imu_msg));
+	imu_msg.header.frame_id.data = frame_id;
+	imu_msg.header.frame_id.size = strlen(frame_id);
+	imu_msg.header.frame_id.capacity = sizeof(frame_id);
+	imu_msg.orientation_covariance[0] = -1;
+
+	if (rclc_publisher_init_best_effort(
+		&imu_publisher,
+		node,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Imu),
+		"imu") != RCL_RET_OK){
+		return false;
+	}
+
+	// Drain the channel once per batch
+	if (rclc_timer_init_default(
+		&imu_timer,
+		support,
+		RCL_US_TO_NS(IMU_SAMPLE_PERIOD_US * UROS_IMU_BATCH),
+		imu_timer_callback) != RCL_RET_OK){
+		return false;
+	}
+	window_start_us = time_us_64();
+	return rclc_executor_add_timer(executor, &imu_timer) == RCL_RET_OK;
+}
+
+/***
+ * Drain the sensor channel at a new sampling period, once per batch
+ * @return false if the timer period could not be changed
+ */
+bool uros_imu_set_period(uint32_t sample_period_us){
+	int64_t old_ns;
+	return rcl_timer_exchange_period(&imu_timer,
+		RCL_US_TO_NS((int64_t)sample_period_us * UROS_IMU_BATCH), &old_ns) == RCL_RET_OK;
+}
+
+/***
+ * Copy the most recently published sample
+ * @return false before the first sample
+ */
+bool uros_imu_latest(ipc_imu_sample_t *sample){
+	if (!have_latest){
+		return false;
+	}
+	*sample = latest;
+	return true;
+}
+
+void uros_imu_get_stats(uros_imu_stats_t *out){
+	*out = stats;
+}
@@ -0,0 +1,39 @@
+#ifndef _UROS_IMU_H_
+#define _UROS_IMU_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rclc/rclc.h>
+#include <rclc/executor.h>
+
+#include "ipc_channel.h"
+
+/*
+ * sensor_msgs/Imu publisher on "imu", best effort, one message per sample
+ * produced by core1 at IMU_SAMPLE_RATE_HZ. With UROS_IMU_BATCH > 1 that
+ * many samples are published back to back and leave in one transport
+ * write (see uros_transport_hold). uros_imu_set_period follows a change of
+ * the sampling period on core1 (see uros_params.h).
+ */
+
+#ifndef UROS_IMU_BATCH
+#define UROS_IMU_BATCH		1
+#endif
+#ifndef UROS_IMU_FRAME_ID
+#define UROS_IMU_FRAME_ID	"imu_link"
+#endif
+
+typedef struct {
+	uint32_t published;
+	uint32_t publish_errors;
+	uint32_t dropped;		// Samples lost: sensor channel full, or releases the sampler missed
+	uint32_t rate_mhz;		// Achieved publish rate over the last second, in mHz
+} uros_imu_stats_t;
+
+bool uros_imu_init(rcl_node_t *node, rclc_support_t *support, rclc_executor_t *executor);
+bool uros_imu_latest(ipc_imu_sample_t *sample);
+bool uros_imu_set_period(uint32_t sample_period_us);
+void uros_imu_get_stats(uros_imu_stats_t *stats);
+
+#endif //_UROS_IMU_H_
@@ -0,0 +1,105 @@
+#include "uros_input.h"
+
+#include "pico/stdlib.h"
+
+#include <rcl/rcl.h>
+#include <std_msgs/msg/int32_multi_array.h>
+
+#include "uros_msgpool.h"
+
+#define INPUT_FIELDS	4	// type, x, y, at_ms
+#define INPUT_LABEL		32	// Layout labels are accepted up to this, and ignored
+#define INPUT_MEMORY	(UROS_INPUT_MAX_EVENTS * INPUT_FIELDS * sizeof(int32_t) + \
+	sizeof(std_msgs__msg__MultiArrayDimension) + INPUT_LABEL + 16)
+
+static rcl_subscription_t input_subscription;
+UROS_MSGPOOL_DEFINE(input_msgpool, std_msgs__msg__Int32MultiArray, 1, INPUT_MEMORY);
+
+static uint64_t last_at_us;		// Due time of the last event queued
+static uros_input_stats_t stats;
+
+static bool valid_event(const int32_t *e)
+{
+	if (e[0] < 0 || e[0] >= IPC_INPUT_TYPES || e[3] < 0 || e[3] > UROS_INPUT_MAX_AT_MS){
+		return false;
+	}
+	return e[1] >= 0 && e[1] <= INT16_MAX && e[2] >= 0 && e[2] <= INT16_MAX;
+}
+
+static void input_callback(const void *msgin)
+{
+	const std_msgs__msg__Int32MultiArray *msg = msgin;
+	uint64_t receive_us = time_us_64();
+	const int32_t *data = msg->data.data;
+	size_t n = msg->data.size / INPUT_FIELDS;
+
+	stats.received++;
+	if (msg->data.size % INPUT_FIELDS != 0){
+		stats.malformed++;
+		return;
+	}
+	int32_t prev_ms = 0;
+	for (size_t i = 0; i < n; i++){
+		const int32_t *e = &data[i * INPUT_FIELDS];
+		if (!valid_event(e) || e[3] < prev_ms){
+			stats.malformed++;
+			return;
+		}
+		prev_ms = e[3];
+	}
+	// All or nothing, a gesture cut short could leave the pointer pressed
+	if (n > IPC_INPUT_SLOTS - ipc_channel_count(&ipc_input_channel)){
+		stats.channel_full++;
+		return;
+	}
+
+	uint64_t start_us = MAX(receive_us, last_at_us);
+	for (size_t i = 0; i < n; i++){
+		const int32_t *e = &data[i * INPUT_FIELDS];
+		ipc_input_event_t *ev = ipc_channel_reserve(&ipc_input_channel);
+		ev->at_us = start_us + (uint64_t)e[3] * 1000;
+		ev->type = (uint8_t)e[0];
+		ev->x = (int16_t)e[1];
+		ev->y = (int16_t)e[2];
+		ipc_channel_commit(&ipc_input_channel);
+		last_at_us = ev->at_us;
+	}
+	stats.events += n;
+}
+
+/***
+ * Create the subscription, the executor needs UROS_INPUT_HANDLES handles
+ * @return false if an entity could not be created
+ */
+bool uros_input_init(rcl_node_t *node, rclc_executor_t *executor){
+	micro_ros_utilities_memory_rule_t rules[] = {
+		{"data", UROS_INPUT_MAX_EVENTS * INPUT_FIELDS},
+		{"layout.dim", 1},
+	};
+	micro_ros_utilities_memory_conf_t conf = micro_ros_utilities_memory_conf_default;
+	conf.max_string_capacity = INPUT_LABEL;
+	conf.rules = rules;
+	conf.n_rules = sizeof(rules) / sizeof(rules[0]);
+	if (!uros_msgpool_init(&input_msgpool,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, Int32MultiArray), &conf)){
+		return false;
+	}
+
+	// Held for the life of the subscription, the executor deserialises into it
+	std_msgs__msg__Int32MultiArray *msg = uros_msgpool_take(&input_msgpool);
+
+	// Reliable: a lost release would leave the pointer pressed
+	if (rclc_subscription_init_default(
+		&input_subscription,
+		node,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, Int32MultiArray),
+		"ui_input") != RCL_RET_OK){
+		return false;
+	}
+	return rclc_executor_add_subscription(
+		executor, &input_subscription, msg, input_callback, ON_NEW_DATA) == RCL_RET_OK;
+}
+
+void uros_input_get_stats(uros_input_stats_t *out){
+	*out = stats;
+}
@@ -0,0 +1,44 @@
+#ifndef _UROS_INPUT_H_
+#define _UROS_INPUT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rclc/rclc.h>
+#include <rclc/executor.h>
+
+#include "ipc_channel.h"
+
+/*
+ * Injected UI input on "ui_input", a reliable std_msgs/Int32MultiArray
+ * (the layout is ignored). The data is a script of events, four values
+ * each:
+ *   type   ipc_input_type_t: 0 press / move, 1 release, 2 key, 3 gesture
+ *   x, y   panel coordinates like the touch controller, or the key
+ *          (LV_KEY_*) / gesture (CST816S_Gesture_*) code in x
+ *   at_ms  time after the message is received, not decreasing
+ * The events go to ipc_input_channel and ui_input.c merges them into the
+ * LVGL input at their time, so a gesture sent as one message replays with
+ * the same timing whatever the link latency. A message that is malformed,
+ * or does not fit the channel as a whole, is dropped; events of a message
+ * never start before those of the previous one end. A full message is about
+ * 1 KB and arrives fragmented, within the reliable input stream buffer of
+ * the default rmw build (4 x 512 bytes).
+ * tools/ui_automation.py drives scripted runs with it.
+ */
+
+#define UROS_INPUT_MAX_EVENTS	IPC_INPUT_SLOTS	// Per message
+#define UROS_INPUT_MAX_AT_MS	60000
+#define UROS_INPUT_HANDLES		1	// Executor handles taken by uros_input_init
+
+typedef struct {
+	uint32_t received;
+	uint32_t events;		// Queued to the UI core
+	uint32_t malformed;		// Messages dropped for a bad event
+	uint32_t channel_full;	// Messages dropped for lack of room
+} uros_input_stats_t;
+
+bool uros_input_init(rcl_node_t *node, rclc_executor_t *executor);
+void uros_input_get_stats(uros_input_stats_t *stats);
+
+#endif //_UROS_INPUT_H_
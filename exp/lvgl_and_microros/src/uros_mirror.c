@@ -0,0 +1,107 @@
+#include "uros_mirror.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include <rcl/rcl.h>
+#include <sensor_msgs/msg/compressed_image.h>
+
+#include "ipc_channel.h"
+#include "uros_time.h"
+#include "uros_msgpool.h"
+
+#define MIRROR_FRAME_ID		"lcd"
+#define MIRROR_STRING		16	// Frame id and format, with the NUL
+#define MIRROR_MEMORY		(IPC_MIRROR_CHUNK + 2 * MIRROR_STRING + 16)
+
+static rcl_publisher_t mirror_publisher;
+static rcl_timer_t mirror_timer;
+static sensor_msgs__msg__CompressedImage *mirror_msg;
+UROS_MSGPOOL_DEFINE(mirror_msgpool, sensor_msgs__msg__CompressedImage, 1, MIRROR_MEMORY);
+
+static uint32_t tokens;			// Bytes that may be sent now
+static uint64_t refill_us;
+static uros_mirror_stats_t stats;
+
+static void set_string(rosidl_runtime_c__String *s, const char *text)
+{
+	size_t len = strlen(text);
+	memcpy(s->data, text, len + 1);
+	s->size = len;
+}
+
+static void mirror_timer_callback(rcl_timer_t *timer, int64_t last_call_time)
+{
+	uint64_t now = time_us_64();
+	uint64_t refill = (now - refill_us) * UROS_MIRROR_BYTES_PER_S / 1000000;
+	if (refill > 0){
+		tokens = (uint32_t)MIN(tokens + refill, (uint64_t)UROS_MIRROR_BURST);
+		refill_us = now;
+	}
+
+	const ipc_mirror_chunk_t *chunk;
+	while ((chunk = ipc_channel_peek(&ipc_mirror_channel)) != NULL){
+		if (chunk->len > tokens){
+			stats.throttled++;
+			break;
+		}
+		tokens -= chunk->len;
+
+		uros_time_to_msg(chunk->flush_us, &mirror_msg->header.stamp);
+		memcpy(mirror_msg->data.data, chunk->data, chunk->len);
+		mirror_msg->data.size = chunk->len;
+		ipc_channel_release(&ipc_mirror_channel);
+
+		if (rcl_publish(&mirror_publisher, mirror_msg, NULL) == RCL_RET_OK){
+			stats.published++;
+			stats.bytes += mirror_msg->data.size;
+		} else {
+			stats.publish_errors++;
+		}
+	}
+}
+
+/***
+ * Create the publisher and its timer, the executor needs one handle
+ * @return false if an entity could not be created
+ */
+bool uros_mirror_init(rcl_node_t *node, rclc_support_t *support, rclc_executor_t *executor){
+	micro_ros_utilities_memory_rule_t rules[] = {
+		{"data", IPC_MIRROR_CHUNK},
+	};
+	micro_ros_utilities_memory_conf_t conf = micro_ros_utilities_memory_conf_default;
+	conf.max_string_capacity = MIRROR_STRING;
+	conf.rules = rules;
+	conf.n_rules = sizeof(rules) / sizeof(rules[0]);
+	if (!uros_msgpool_init(&mirror_msgpool,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, CompressedImage), &conf)){
+		return false;
+	}
+
+	// Held for good, only the stamp and data change per chunk
+	mirror_msg = uros_msgpool_take(&mirror_msgpool);
+	set_string(&mirror_msg->header.frame_id, MIRROR_FRAME_ID);
+	set_string(&mirror_msg->format, UROS_MIRROR_FORMAT);
+
+	if (rclc_publisher_init_best_effort(
+		&mirror_publisher,
+		node,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, CompressedImage),
+		"screen_mirror") != RCL_RET_OK){
+		return false;
+	}
+
+	if (rclc_timer_init_default(
+		&mirror_timer,
+		support,
+		RCL_MS_TO_NS(UROS_MIRROR_MS),
+		mirror_timer_callback) != RCL_RET_OK){
+		return false;
+	}
+	refill_us = time_us_64();
+	return rclc_executor_add_timer(executor, &mirror_timer) == RCL_RET_OK;
+}
+
+void uros_mirror_get_stats(uros_mirror_stats_t *out){
+	*out = stats;
+}
@@ -0,0 +1,46 @@
+#ifndef _UROS_MIRROR_H_
+#define _UROS_MIRROR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rclc/rclc.h>
+#include <rclc/executor.h>
+
+#include "ipc_channel.h"
+
+/*
+ * Screen mirror on "screen_mirror", best effort sensor_msgs/CompressedImage
+ * with format UROS_MIRROR_FORMAT. Each message is one chunk from
+ * ipc_mirror_channel: a dirty rectangle, or part of one, RLE encoded by
+ * ui_mirror.c (layout in ui_mirror.h); the stamp is the flush time.
+ * Mirroring is off until the mirror knob is set to 1, which also sends a
+ * full frame: "mirror 1" on pico_param, or the parameter where the rmw
+ * build has the services (uros_params.h). tools/mirror_view.py sends the
+ * command and shows the screen.
+ *
+ * Chunks leave at most at UROS_MIRROR_BYTES_PER_S. Beyond that they wait
+ * in the channel, and once it is full the UI core stops encoding and sends
+ * the missed area again later, so a busy screen costs latency, not link
+ * bandwidth or UI frame time.
+ */
+
+#ifndef UROS_MIRROR_BYTES_PER_S
+#define UROS_MIRROR_BYTES_PER_S	32768
+#endif
+#define UROS_MIRROR_MS			20		// Channel drain period
+#define UROS_MIRROR_BURST		(2 * IPC_MIRROR_CHUNK)
+#define UROS_MIRROR_FORMAT		"pico_rle565_v1"
+#define UROS_MIRROR_HANDLES		1	// Executor handles taken by uros_mirror_init
+
+typedef struct {
+	uint32_t published;
+	uint32_t publish_errors;
+	uint64_t bytes;
+	uint32_t throttled;		// Drains that stopped at the rate limit
+} uros_mirror_stats_t;
+
+bool uros_mirror_init(rcl_node_t *node, rclc_support_t *support, rclc_executor_t *executor);
+void uros_mirror_get_stats(uros_mirror_stats_t *stats);
+
+#endif //_UROS_MIRROR_H_
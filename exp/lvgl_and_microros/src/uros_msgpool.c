@@ -0,0 +1,75 @@
+#include "uros_msgpool.h"
+
+#include <string.h>
+
+/***
+ * Give every message of the pool its string and sequence capacities, from
+ * the pool memory. conf NULL takes micro_ros_utilities_memory_conf_default.
+ * @return false if the pool memory is too small, memory_used is then the
+ * size it needed
+ */
+bool uros_msgpool_init(uros_msgpool_t *pool, const rosidl_message_type_support_t *type,
+	const micro_ros_utilities_memory_conf_t *conf){
+	micro_ros_utilities_memory_conf_t c = conf != NULL ? *conf : micro_ros_utilities_memory_conf_default;
+
+	memset(pool->msgs, 0, pool->count * pool->msg_size);
+	memset(&pool->stats, 0, sizeof(pool->stats));
+	pool->free_mask = 0;
+	pool->memory_used = 0;
+	if (pool->count == 0 || pool->count > UROS_MSGPOOL_MAX){
+		return false;
+	}
+
+	// Rounded up so every message starts its storage 8 byte aligned
+	size_t per_msg = (micro_ros_utilities_get_static_size(type, c) + 7) & ~(size_t)7;
+	if (per_msg * pool->count > pool->memory_size){
+		pool->memory_used = per_msg * pool->count;
+		return false;
+	}
+
+	for (uint8_t i = 0; i < pool->count; i++){
+		if (!micro_ros_utilities_create_static_message_memory(type,
+			pool->msgs + i * pool->msg_size, c,
+			pool->memory + pool->memory_used, per_msg)){
+			return false;
+		}
+		pool->memory_used += per_msg;
+	}
+	pool->free_mask = pool->count == 32 ? UINT32_MAX : (1u << pool->count) - 1;
+	return true;
+}
+
+/***
+ * Hand out a free message
+ * @return message pointer, or NULL (and counted) when all are taken
+ */
+void *uros_msgpool_take(uros_msgpool_t *pool){
+	pool->stats.takes++;
+	if (pool->free_mask == 0){
+		pool->stats.exhausted++;
+		return NULL;
+	}
+	uint32_t i = __builtin_ctz(pool->free_mask);
+	pool->free_mask &= ~(1u << i);
+	if (++pool->stats.in_use > pool->stats.in_use_peak){
+		pool->stats.in_use_peak = pool->stats.in_use;
+	}
+	return pool->msgs + i * pool->msg_size;
+}
+
+void uros_msgpool_give(uros_msgpool_t *pool, void *msg){
+	if (msg == NULL){
+		return;
+	}
+	uint32_t i = (uint32_t)(((uint8_t *)msg - pool->msgs) / pool->msg_size);
+	if (i >= pool->count || (pool->free_mask & (1u << i))){
+		return;	// Not from this pool, or given back twice
+	}
+	pool->free_mask |= 1u << i;
+	pool->stats.gives++;
+	pool->stats.in_use--;
+}
+
+void uros_msgpool_get_stats(const uros_msgpool_t *pool, uros_msgpool_stats_t *out){
+	*out = pool->stats;
+}
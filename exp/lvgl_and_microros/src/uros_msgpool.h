@@ -0,0 +1,68 @@
+#ifndef _UROS_MSGPOOL_H_
+#define _UROS_MSGPOOL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <rosidl_runtime_c/message_type_support_struct.h>
+#include <micro_ros_utilities/type_utilities.h>
+
+/*
+ * Preallocated ROS messages. uros_msgpool_init gives every string and
+ * sequence of every message in the pool its capacity once, carved from the
+ * pool's static memory, and publishers and subscriptions then take and give
+ * back whole messages. Nothing on that path calls the allocator; with
+ * uros_alloc_seal, uros_alloc_stats_t.runtime_allocs shows it stays that way.
+ *
+ * A taken message keeps whatever the previous user left in it: set every
+ * field, and the size of every sequence (up to its capacity). Sequences
+ * must not be resized or reallocated by the user.
+ *
+ * Like uros_alloc, only the micro-ROS executor task/core may use a pool.
+ */
+
+#define UROS_MSGPOOL_MAX	32	// Messages per pool, one bit each in free_mask
+
+typedef struct {
+	uint32_t takes;
+	uint32_t gives;
+	uint32_t exhausted;		// Takes that found no free message
+	uint8_t in_use;
+	uint8_t in_use_peak;
+} uros_msgpool_stats_t;
+
+typedef struct {
+	uint8_t *msgs;			// count messages of msg_size bytes
+	size_t msg_size;
+	uint8_t count;
+	uint8_t *memory;		// String and sequence storage
+	size_t memory_size;
+	size_t memory_used;
+	uint32_t free_mask;
+	uros_msgpool_stats_t stats;
+} uros_msgpool_t;
+
+/*
+ * Define a pool of n messages of msg_type, with memory_bytes for their
+ * strings and sequences. uros_msgpool_init fails, and reports the size it
+ * needed in memory_used, when memory_bytes is too small.
+ */
+#define UROS_MSGPOOL_DEFINE(var, msg_type, n, memory_bytes)     \
+    static msg_type var##_msgs[n];                              \
+    static uint64_t var##_memory[((memory_bytes) + 7) / 8];     \
+    uros_msgpool_t var = {                                      \
+        .msgs = (uint8_t *)var##_msgs,                          \
+        .msg_size = sizeof(msg_type),                           \
+        .count = (n),                                           \
+        .memory = (uint8_t *)var##_memory,                      \
+        .memory_size = sizeof(var##_memory),                    \
+    }
+
+bool uros_msgpool_init(uros_msgpool_t *pool, const rosidl_message_type_support_t *type,
+	const micro_ros_utilities_memory_conf_t *conf);
+void *uros_msgpool_take(uros_msgpool_t *pool);
+void uros_msgpool_give(uros_msgpool_t *pool, void *msg);
+void uros_msgpool_get_stats(const uros_msgpool_t *pool, uros_msgpool_stats_t *stats);
+
+#endif //_UROS_MSGPOOL_H_
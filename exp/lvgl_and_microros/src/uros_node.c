@@ -0,0 +1,207 @@
+#include "uros_node.h"
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+
+#include <rcl/rcl.h>
+#include <rcl/error_handling.h>
+#include <rclc/rclc.h>
+#include <rclc/executor.h>
+#include <std_msgs/msg/int32.h>
+#include <rmw_microros/rmw_microros.h>
+
+#include "ipc_channel.h"
+#include "uros_alloc.h"
+#include "uros_imu.h"
+#include "uros_dashboard.h"
+#include "uros_transport.h"
+#include "uros_time.h"
+#include "uros_telemetry.h"
+#include "uros_params.h"
+#include "uros_mirror.h"
+#include "uros_input.h"
+#include "uros_profile.h"
+#include "uros_trace.h"
+#include "uros_boot.h"
+#include "boot.h"
+
+#define UROS_NODE_HANDLES (2 + UROS_TIME_HANDLES + UROS_DASHBOARD_HANDLES + \
+	UROS_TELEMETRY_HANDLES + UROS_MIRROR_HANDLES + UROS_INPUT_HANDLES + \
+	UROS_PROFILE_HANDLES + UROS_TRACE_HANDLES + UROS_PARAMS_HANDLES)
+
+static rcl_publisher_t publisher;
+static std_msgs__msg__Int32 msg;
+
+static rcl_timer_t timer;
+static rcl_node_t node;
+static rcl_allocator_t allocator;
+static rclc_support_t support;
+static rclc_executor_t executor;
+
+static bool sealed;
+static uros_node_stats_t stats;
+static uint64_t window_start_us;
+static uint64_t window_idle_us;
+
+static void module_init(uros_node_module_t module, bool ok)
+{
+	if (!ok){
+		stats.init_failures |= 1u << module;
+	}
+}
+
+static void timer_callback(rcl_timer_t *timer, int64_t last_call_time)
+{
+	// Publish the latest vertical acceleration (mg) sampled by the UI core
+	ipc_imu_sample_t sample;
+	if (uros_imu_latest(&sample)){
+		msg.data = (int32_t)sample.acc[2];
+	}
+	rcl_ret_t ret = rcl_publish(&publisher, &msg, NULL);
+}
+
+/***
+ * Wait for the agent and create the node, publisher, timer and executor;
+ * on success BOOT_ROS_READY is signalled
+ * @return false if the agent did not answer within
+ * UROS_NODE_PING_ATTEMPTS pings, call again to keep waiting
+ */
+bool uros_node_init(void){
+	// Bounded pools instead of the shared newlib heap, see uros_alloc.h
+	uros_alloc_set_default();
+	allocator = uros_alloc_get_allocator();
+
+	rcl_ret_t ret = rmw_uros_ping_agent(UROS_NODE_PING_MS, UROS_NODE_PING_ATTEMPTS);
+
+	if (ret != RCL_RET_OK)
+	{
+		// Unreachable agent
+		return false;
+	}
+
+	rclc_support_init(&support, 0, NULL, &allocator);
+
+	rclc_node_init_default(&node, "pico_node", "", &support);
+	rclc_publisher_init_default(
+		&publisher,
+		&node,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, Int32),
+		"pico_publisher");
+
+	rclc_timer_init_default(
+		&timer,
+		&support,
+		RCL_MS_TO_NS(UROS_NODE_PUBLISH_MS),
+		timer_callback);
+
+	rclc_executor_init(&executor, &support.context, UROS_NODE_HANDLES, &allocator);
+	rclc_executor_add_timer(&executor, &timer);
+	// A module that fails leaves the others running; telemetry reports it
+	module_init(UROS_NODE_MODULE_TIME, uros_time_init(&support, &executor));
+	module_init(UROS_NODE_MODULE_IMU, uros_imu_init(&node, &support, &executor));
+	module_init(UROS_NODE_MODULE_DASHBOARD, uros_dashboard_init(&node, &executor));
+	module_init(UROS_NODE_MODULE_TELEMETRY, uros_telemetry_init(&node, &support, &executor));
+	module_init(UROS_NODE_MODULE_MIRROR, uros_mirror_init(&node, &support, &executor));
+	module_init(UROS_NODE_MODULE_INPUT, uros_input_init(&node, &executor));
+	module_init(UROS_NODE_MODULE_PROFILE, uros_profile_init(&node, &support, &executor));
+	module_init(UROS_NODE_MODULE_TRACE, uros_trace_init(&node, &support, &executor));
+	// Last: without the services in the rmw build only the pico_param topic sets knobs
+	module_init(UROS_NODE_MODULE_PARAMS, uros_params_init(&node, &executor));
+
+	msg.data = 0;
+	boot_signal(BOOT_ROS_READY);
+	module_init(UROS_NODE_MODULE_BOOT, uros_boot_publish(&node));
+	return true;
+}
+
+/***
+ * The executor sets up its wait set on the first spin; anything the
+ * allocator sees after that is a runtime allocation
+ */
+static void seal_after_first_spin(void){
+	if (!sealed){
+		uros_alloc_seal();
+		sealed = true;
+	}
+}
+
+/***
+ * Change the pico_publisher period
+ * @return false if the timer period could not be changed
+ */
+bool uros_node_set_publish_period(uint32_t period_ms){
+	int64_t old_ns;
+	return rcl_timer_exchange_period(&timer, RCL_MS_TO_NS(period_ms), &old_ns) == RCL_RET_OK;
+}
+
+void uros_node_spin_some(int64_t timeout_ns){
+	TRACE_BEGIN(TRACE_EXECUTOR_SPIN);
+	rclc_executor_spin_some(&executor, timeout_ns);
+	TRACE_END(TRACE_EXECUTOR_SPIN, 0);
+	seal_after_first_spin();
+}
+
+/***
+ * Time until the earliest executor timer is due
+ * @return nanoseconds, at most max_ns and never negative
+ */
+static int64_t next_timer_ns(int64_t max_ns){
+	int64_t wait_ns = max_ns;
+	for (size_t i = 0; i < executor.index; i++){
+		int64_t t;
+		if (executor.handles[i].type == RCLC_TIMER &&
+			rcl_timer_get_time_until_next_call(executor.handles[i].timer, &t) == RCL_RET_OK &&
+			t < wait_ns){
+			wait_ns = t > 0 ? t : 0;
+		}
+	}
+	return wait_ns;
+}
+
+/***
+ * Sleep until the transport has received data or the next timer is due,
+ * then run the executor once without blocking. Replaces a spin_some loop
+ * that polls with a timeout slice.
+ */
+void uros_node_spin_event(int64_t max_wait_ns){
+	uint64_t start_us = time_us_64();
+	uint64_t deadline_us = start_us + next_timer_ns(max_wait_ns) / 1000;
+
+	bool rx = uros_transport_wait(deadline_us);
+	uint64_t woken_us = time_us_64();
+	window_idle_us += woken_us - start_us;
+	if (rx){
+		stats.rx_wakeups++;
+	} else {
+		stats.timer_wakeups++;
+	}
+
+	uint64_t rx_us = uros_transport_take_rx_time();
+	TRACE_BEGIN(TRACE_EXECUTOR_SPIN);
+	rclc_executor_spin_some(&executor, 0);
+	TRACE_END(TRACE_EXECUTOR_SPIN, rx);
+	seal_after_first_spin();
+	uint64_t done_us = time_us_64();
+
+	// Receive interrupt to the end of the spin that handled the data
+	if (rx && rx_us != 0){
+		uint32_t latency_us = (uint32_t)(done_us - rx_us);
+		stats.messages++;
+		stats.latency_us_last = latency_us;
+		stats.latency_us_total += latency_us;
+		if (latency_us > stats.latency_us_max){
+			stats.latency_us_max = latency_us;
+		}
+	}
+
+	uint64_t window_us = done_us - window_start_us;
+	if (window_us >= 1000000){
+		stats.idle_pct = (uint8_t)(window_idle_us * 100 / window_us);
+		window_idle_us = 0;
+		window_start_us = done_us;
+	}
+}
+
+void uros_node_get_stats(uros_node_stats_t *out){
+	*out = stats;
+}
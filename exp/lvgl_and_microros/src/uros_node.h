@@ -0,0 +1,54 @@
+#ifndef _UROS_NODE_H_
+#define _UROS_NODE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * pico_node and its entities. The transport must be set with
+ * rmw_uros_set_custom_transport before uros_node_init.
+ *
+ * uros_node_spin_event sleeps on the transport's receive wakeup, so it
+ * needs the transport to come from uros_transport_select. The FreeRTOS
+ * build blocks in its stream buffer transport and keeps spin_some.
+ */
+
+#ifndef UROS_SPIN_EVENT
+#define UROS_SPIN_EVENT 1	// main spins with uros_node_spin_event
+#endif
+#define UROS_NODE_PUBLISH_MS 1000	// Default pico_publisher period
+#define UROS_NODE_PING_MS 100		// A short ping notices the agent soon after it starts
+#define UROS_NODE_PING_ATTEMPTS 10	// Per uros_node_init call
+
+// Bits of uros_node_stats_t.init_failures
+typedef enum {
+	UROS_NODE_MODULE_TIME = 0,
+	UROS_NODE_MODULE_IMU,
+	UROS_NODE_MODULE_DASHBOARD,
+	UROS_NODE_MODULE_TELEMETRY,
+	UROS_NODE_MODULE_MIRROR,
+	UROS_NODE_MODULE_INPUT,
+	UROS_NODE_MODULE_PROFILE,
+	UROS_NODE_MODULE_TRACE,
+	UROS_NODE_MODULE_PARAMS,	// Also set when only the parameter server failed
+	UROS_NODE_MODULE_BOOT,
+} uros_node_module_t;
+
+typedef struct {
+	uint32_t rx_wakeups;		// Spins started by received data
+	uint32_t timer_wakeups;		// Spins started by a timer deadline or max wait
+	uint32_t messages;		// Receive wakeups with a measured latency
+	uint32_t latency_us_last;	// Receive IRQ to end of the executor spin
+	uint32_t latency_us_max;
+	uint64_t latency_us_total;
+	uint8_t idle_pct;		// Time core0 slept in the last second
+	uint32_t init_failures;		// 1 << uros_node_module_t of each init that failed
+} uros_node_stats_t;
+
+bool uros_node_init(void);
+bool uros_node_set_publish_period(uint32_t period_ms);
+void uros_node_spin_some(int64_t timeout_ns);
+void uros_node_spin_event(int64_t max_wait_ns);
+void uros_node_get_stats(uros_node_stats_t *stats);
+
+#endif //_UROS_NODE_H_
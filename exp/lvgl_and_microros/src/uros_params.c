@@ -0,0 +1,225 @@
+#include "uros_params.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+
+#include <std_msgs/msg/string.h>
+
+#include "LVGL_example.h"
+#include "ipc_channel.h"
+#include "uros_node.h"
+#include "uros_imu.h"
+#include "uros_profile.h"
+#include "uros_trace.h"
+#include "uros_msgpool.h"
+
+#define PARAM_CORE0	(-1)	// Applied on this core, no command
+#define PARAM_PROFILE	(-2)	// Sampling profiler, on both cores
+#define PARAM_TRACE	(-3)	// Event trace, on both cores
+
+typedef struct {
+	const char *name;
+	int16_t cmd;			// ipc_cmd_id_t for the UI core, or a PARAM_* above
+	int64_t min;
+	int64_t max;
+	int64_t value;			// Default until set
+} param_t;
+
+static param_t params[] = {
+	{ "publish_period_ms", PARAM_CORE0,          10, 60000, UROS_NODE_PUBLISH_MS },
+	{ "imu_rate_hz",       IPC_CMD_IMU_PERIOD,   10,   400, IMU_SAMPLE_RATE_HZ },
+	{ "refr_period_ms",    IPC_CMD_REFR_PERIOD,   1,  1000, LV_DISP_DEF_REFR_PERIOD },
+	{ "indev_period_ms",   IPC_CMD_INDEV_PERIOD,  1,  1000, LV_INDEV_DEF_READ_PERIOD },
+	{ "max_idle_ms",       IPC_CMD_MAX_IDLE,      5, 10000, LVGL_MAX_IDLE_MS },
+	{ "rtc_period_ms",     IPC_CMD_RTC_PERIOD,   50, 60000, RTC_UPDATE_PERIOD_MS },
+	{ "spi_hz",            IPC_CMD_SPI_CLOCK, 1000000, 0, 0 },	// Limits read at init
+	{ "backlight",         IPC_CMD_BACKLIGHT,     1,    10, 6 },	// DEV_SET_PWM(60)
+	{ "mirror",            IPC_CMD_MIRROR,        0,     1, 0 },	// See uros_mirror.h
+	{ "profile_hz",        PARAM_PROFILE,         0, PROFILER_MAX_HZ, 0 },	// See uros_profile.h
+	{ "trace",             PARAM_TRACE,           0,     1, TRACE },	// See uros_trace.h
+};
+
+#define PARAM_COUNT	(sizeof(params) / sizeof(params[0]))
+
+static rclc_parameter_server_t server;
+static bool server_up;
+static bool syncing;			// A command is copying its value to the server
+
+static rcl_subscription_t command_subscription;
+UROS_MSGPOOL_DEFINE(command_msgpool, std_msgs__msg__String, 1, UROS_PARAMS_COMMAND + 16);
+
+static uros_params_stats_t stats;
+
+static param_t *find_param(const char *name)
+{
+	for (size_t i = 0; i < PARAM_COUNT; i++){
+		if (strcmp(params[i].name, name) == 0){
+			return &params[i];
+		}
+	}
+	return NULL;
+}
+
+static bool apply(param_t *p, int64_t value)
+{
+	if (p->cmd == PARAM_CORE0){
+		return uros_node_set_publish_period((uint32_t)value);
+	}
+	if (p->cmd == PARAM_PROFILE){
+		return uros_profile_set_hz((uint32_t)value);
+	}
+	if (p->cmd == PARAM_TRACE){
+		return uros_trace_set_enabled(value != 0);
+	}
+
+	ipc_cmd_t cmd = { .id = (uint16_t)p->cmd, .value = (int32_t)value };
+	if (p->cmd == IPC_CMD_IMU_PERIOD){
+		// Rounded like IMU_SAMPLE_PERIOD_US
+		cmd.value = (1000000 + (int32_t)value / 2) / (int32_t)value;
+	}
+	if (!ipc_channel_push(&ipc_command_channel, &cmd)){
+		return false;
+	}
+	if (p->cmd == IPC_CMD_IMU_PERIOD){
+		uros_imu_set_period((uint32_t)cmd.value);
+	}
+	return true;
+}
+
+/*
+ * Runs in the executor on a set request; returning false rejects it and
+ * the parameter keeps its value
+ */
+static bool on_parameter_changed(const Parameter *old_param, const Parameter *new_param, void *context)
+{
+	if (syncing){
+		return true;	// Already applied by command_callback
+	}
+	if (old_param == NULL || new_param == NULL){
+		return false;	// Parameters are neither added nor deleted remotely
+	}
+	param_t *p = find_param(new_param->name.data);
+	if (p == NULL || new_param->value.type != RCLC_PARAMETER_INT){
+		return false;
+	}
+	int64_t value = new_param->value.integer_value;
+	if (value < p->min || value > p->max || !apply(p, value)){
+		return false;
+	}
+	p->value = value;
+	return true;
+}
+
+/*
+ * A "<name> <value>" command on UROS_PARAMS_TOPIC, checked and applied
+ * like a parameter set request
+ */
+static void command_callback(const void *msgin)
+{
+	const std_msgs__msg__String *msg = msgin;
+	char text[UROS_PARAMS_COMMAND + 1];
+	size_t len = MIN(msg->data.size, UROS_PARAMS_COMMAND);
+	memcpy(text, msg->data.data, len);
+	text[len] = '\0';
+
+	stats.commands++;
+	char *value_text = strchr(text, ' ');
+	if (value_text == NULL){
+		stats.rejected++;
+		return;
+	}
+	*value_text++ = '\0';
+	char *end;
+	int64_t value = strtoll(value_text, &end, 10);
+	param_t *p = find_param(text);
+	if (p == NULL || end == value_text || *end != '\0' ||
+		value < p->min || value > p->max || !apply(p, value)){
+		stats.rejected++;
+		return;
+	}
+	p->value = value;
+
+	if (server_up){
+		syncing = true;
+		rclc_parameter_set_int(&server, p->name, value);
+		syncing = false;
+	}
+}
+
+static bool command_init(rcl_node_t *node, rclc_executor_t *executor)
+{
+	micro_ros_utilities_memory_conf_t conf = micro_ros_utilities_memory_conf_default;
+	conf.max_string_capacity = UROS_PARAMS_COMMAND;
+	if (!uros_msgpool_init(&command_msgpool,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String), &conf)){
+		return false;
+	}
+
+	// Held for the life of the subscription, the executor deserialises into it
+	std_msgs__msg__String *msg = uros_msgpool_take(&command_msgpool);
+
+	// Reliable: a lost "profile_hz 0" would leave the profile unsent
+	if (rclc_subscription_init_default(
+		&command_subscription,
+		node,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String),
+		UROS_PARAMS_TOPIC) != RCL_RET_OK){
+		return false;
+	}
+	return rclc_executor_add_subscription(
+		executor, &command_subscription, msg, command_callback, ON_NEW_DATA) == RCL_RET_OK;
+}
+
+/***
+ * Declare the parameters with their current values and start the server.
+ * On failure the services created so far are destroyed again.
+ */
+static bool server_init(rcl_node_t *node, rclc_executor_t *executor){
+	const rclc_parameter_options_t options = {
+		.notify_changed_over_dds = false,	// No parameter_events publisher
+		.max_params = PARAM_COUNT,
+		.allow_undeclared_parameters = false,
+		.low_mem_mode = true,
+	};
+	if (rclc_parameter_server_init_with_option(&server, node, &options) != RCL_RET_OK){
+		rclc_parameter_server_fini(&server, node);
+		return false;
+	}
+
+	// Before the server joins the executor, so no callback runs for these
+	for (size_t i = 0; i < PARAM_COUNT; i++){
+		param_t *p = &params[i];
+		if (rclc_add_parameter(&server, p->name, RCLC_PARAMETER_INT) != RCL_RET_OK ||
+			rclc_parameter_set_int(&server, p->name, p->value) != RCL_RET_OK){
+			rclc_parameter_server_fini(&server, node);
+			return false;
+		}
+		rclc_add_parameter_constraint_integer(&server, p->name, p->min, p->max, 1);
+	}
+
+	// Cannot run out of handles, UROS_PARAMS_HANDLES reserves them
+	return rclc_executor_add_parameter_server_with_context(
+		executor, &server, on_parameter_changed, NULL) == RCL_RET_OK;
+}
+
+/***
+ * Subscribe to UROS_PARAMS_TOPIC and start the parameter server, the
+ * executor needs UROS_PARAMS_HANDLES handles
+ * @return false if the topic or the server could not be created; the
+ * other one still works
+ */
+bool uros_params_init(rcl_node_t *node, rclc_executor_t *executor){
+	param_t *spi = find_param("spi_hz");
+	spi->max = clock_get_hz(clk_peri) / 2;
+	spi->value = spi_get_baudrate(LCD_SPI_PORT);
+
+	bool topic_up = command_init(node, executor);
+	server_up = server_init(node, executor);
+	return topic_up && server_up;
+}
+
+void uros_params_get_stats(uros_params_stats_t *out){
+	*out = stats;
+}
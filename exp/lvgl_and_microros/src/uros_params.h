@@ -0,0 +1,57 @@
+#ifndef _UROS_PARAMS_H_
+#define _UROS_PARAMS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rclc/rclc.h>
+#include <rclc/executor.h>
+#include <rclc_parameter/rclc_parameter.h>
+
+/*
+ * Performance knobs of pico_node, applied as soon as they are set. Each is
+ * set by a text command "<name> <value>" on "pico_param", a reliable
+ * std_msgs/String:
+ *   ros2 topic pub --once /pico_param std_msgs/msg/String "{data: 'mirror 1'}"
+ * and, where the rmw build has the services, as an integer parameter
+ * (ros2 param set /pico_node <name> <value>). The knobs are:
+ *
+ *   publish_period_ms  pico_publisher timer
+ *   imu_rate_hz        IMU sampling on core1 and the imu publisher, 10-400
+ *   refr_period_ms     LVGL display refresh timer (LV_DISP_DEF_REFR_PERIOD)
+ *   indev_period_ms    LVGL touch read timer (LV_INDEV_DEF_READ_PERIOD)
+ *   max_idle_ms        longest sleep of the LVGL task
+ *   rtc_period_ms      RTC table update
+ *   spi_hz             LCD SPI clock, the panel is reclocked between flushes
+ *   backlight          1-10, like the brightness roller
+ *   mirror             1 streams the screen on screen_mirror, see uros_mirror.h
+ *   profile_hz         samples both cores at this rate, 0 stops and sends
+ *                      the profile, see uros_profile.h (PROFILER builds)
+ *   trace              0 freezes the event trace and sends it, 1 clears it
+ *                      and traces again, see uros_trace.h (TRACE builds)
+ *
+ * The UI core knobs travel as commands on ipc_command_channel; a change that
+ * is unknown, out of range or finds the channel full is rejected and the
+ * knob keeps its value. A command also updates the parameter.
+ *
+ * The parameter server needs RCLC_EXECUTOR_PARAMETER_SERVER_HANDLES
+ * executor handles and that many services in the rmw build
+ * (RMW_UXRCE_MAX_SERVICES in the libmicroros colcon.meta). The prebuilt
+ * library allows one, so there the server is torn down again, the
+ * failure shows in the init_failures telemetry field and only the
+ * pico_param topic sets the knobs.
+ */
+
+#define UROS_PARAMS_TOPIC	"pico_param"
+#define UROS_PARAMS_COMMAND	48		// Longest command text
+#define UROS_PARAMS_HANDLES	(1 + RCLC_EXECUTOR_PARAMETER_SERVER_HANDLES)
+
+typedef struct {
+	uint32_t commands;		// Received on UROS_PARAMS_TOPIC
+	uint32_t rejected;		// Malformed, unknown, out of range or not applied
+} uros_params_stats_t;
+
+bool uros_params_init(rcl_node_t *node, rclc_executor_t *executor);
+void uros_params_get_stats(uros_params_stats_t *stats);
+
+#endif //_UROS_PARAMS_H_
@@ -0,0 +1,163 @@
+#include "uros_profile.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+
+#if PROFILER
+#include <rcl/rcl.h>
+#include <std_msgs/msg/u_int32_multi_array.h>
+
+#include "uros_msgpool.h"
+
+#define PROFILE_CORES	2
+#define PROFILE_FIELDS	3	// pc, lr, count
+#define PROFILE_WORDS	(UROS_PROFILE_HEADER + UROS_PROFILE_PAIRS * PROFILE_FIELDS)
+#define PROFILE_LABEL	sizeof(UROS_PROFILE_LAYOUT)
+#define PROFILE_MEMORY	(PROFILE_WORDS * sizeof(uint32_t) + \
+	sizeof(std_msgs__msg__MultiArrayDimension) + PROFILE_LABEL + 16)
+
+static rcl_publisher_t profile_publisher;
+static rcl_timer_t profile_timer;
+static std_msgs__msg__UInt32MultiArray *profile_msg;
+UROS_MSGPOOL_DEFINE(profile_msgpool, std_msgs__msg__UInt32MultiArray, 1, PROFILE_MEMORY);
+
+// Dump in progress: the next slot of the core being sent
+static bool dumping;
+static uint8_t dump_core;
+static uint32_t dump_slot;
+static uint32_t dump_seq;
+
+/***
+ * Fill the message with the next pairs of the dump core, up to the end of
+ * its histogram
+ * @return true if the core's histogram is done
+ */
+static bool fill_chunk(void){
+	const profiler_entry_t *slots = profiler_entries(dump_core);
+	uint32_t *data = profile_msg->data.data;
+	uint32_t pairs = 0;
+	for (; dump_slot < PROFILER_SLOTS && pairs < UROS_PROFILE_PAIRS; dump_slot++){
+		const profiler_entry_t *e = &slots[dump_slot];
+		if (e->count != 0){
+			uint32_t *p = &data[UROS_PROFILE_HEADER + pairs * PROFILE_FIELDS];
+			p[0] = e->pc;
+			p[1] = e->lr;
+			p[2] = e->count;
+			pairs++;
+		}
+	}
+	// Pairs may sit in the last slots, look ahead so no empty message follows
+	while (dump_slot < PROFILER_SLOTS && slots[dump_slot].count == 0){
+		dump_slot++;
+	}
+
+	profiler_stats_t stats;
+	profiler_get_stats(dump_core, &stats);
+	bool core_done = dump_slot == PROFILER_SLOTS;
+	data[0] = dump_seq;
+	data[1] = core_done && dump_core == PROFILE_CORES - 1;
+	data[2] = dump_core;
+	data[3] = stats.hz;
+	data[4] = stats.samples;
+	data[5] = stats.dropped;
+	data[6] = stats.entries;
+	profile_msg->data.size = UROS_PROFILE_HEADER + pairs * PROFILE_FIELDS;
+	profile_msg->layout.dim.data[0].size = pairs;
+	return core_done;
+}
+
+static void profile_timer_callback(rcl_timer_t *timer, int64_t last_call_time)
+{
+	if (!dumping){
+		return;
+	}
+	uint32_t slot = dump_slot;
+	bool core_done = fill_chunk();
+	if (rcl_publish(&profile_publisher, profile_msg, NULL) != RCL_RET_OK){
+		dump_slot = slot;	// Again on the next tick
+		return;
+	}
+	dump_seq++;
+	if (core_done){
+		dump_slot = 0;
+		if (++dump_core == PROFILE_CORES){
+			dumping = false;
+		}
+	}
+}
+
+/***
+ * Create the publisher and its timer, the executor needs
+ * UROS_PROFILE_HANDLES handles
+ * @return false if an entity could not be created
+ */
+bool uros_profile_init(rcl_node_t *node, rclc_support_t *support, rclc_executor_t *executor){
+	micro_ros_utilities_memory_rule_t rules[] = {
+		{"data", PROFILE_WORDS},
+		{"layout.dim", 1},
+	};
+	micro_ros_utilities_memory_conf_t conf = micro_ros_utilities_memory_conf_default;
+	conf.max_string_capacity = PROFILE_LABEL;
+	conf.rules = rules;
+	conf.n_rules = sizeof(rules) / sizeof(rules[0]);
+	if (!uros_msgpool_init(&profile_msgpool,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, UInt32MultiArray), &conf)){
+		return false;
+	}
+
+	// Held for good, the layout names the format
+	profile_msg = uros_msgpool_take(&profile_msgpool);
+	std_msgs__msg__MultiArrayDimension *dim = profile_msg->layout.dim.data;
+	memcpy(dim->label.data, UROS_PROFILE_LAYOUT, PROFILE_LABEL);
+	dim->label.size = PROFILE_LABEL - 1;
+	dim->stride = PROFILE_FIELDS;
+	profile_msg->layout.dim.size = 1;
+	profile_msg->layout.data_offset = UROS_PROFILE_HEADER;
+
+	// Reliable: a lost chunk would skew the profile
+	if (rclc_publisher_init_default(
+		&profile_publisher,
+		node,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, UInt32MultiArray),
+		"profile") != RCL_RET_OK){
+		return false;
+	}
+
+	if (rclc_timer_init_default(
+		&profile_timer,
+		support,
+		RCL_MS_TO_NS(UROS_PROFILE_MS),
+		profile_timer_callback) != RCL_RET_OK){
+		return false;
+	}
+	return rclc_executor_add_timer(executor, &profile_timer) == RCL_RET_OK;
+}
+
+/***
+ * Start sampling at hz, or with 0 stop and send the histograms
+ * @return false if the rate is out of range
+ */
+bool uros_profile_set_hz(uint32_t hz){
+	if (hz != 0){
+		dumping = false;
+		return profiler_start(hz);
+	}
+	profiler_stop();
+	dump_core = 0;
+	dump_slot = 0;
+	dump_seq = 0;
+	dumping = true;
+	return true;
+}
+
+#else
+
+bool uros_profile_init(rcl_node_t *node, rclc_support_t *support, rclc_executor_t *executor){
+	return true;
+}
+
+bool uros_profile_set_hz(uint32_t hz){
+	return hz == 0;
+}
+
+#endif
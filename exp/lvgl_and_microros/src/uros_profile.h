@@ -0,0 +1,40 @@
+#ifndef _UROS_PROFILE_H_
+#define _UROS_PROFILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rclc/rclc.h>
+#include <rclc/executor.h>
+
+#include "profiler.h"
+
+/*
+ * Sampling profiler (profiler.h) control and dump, for builds with
+ * PROFILER=1. The profile_hz knob ("profile_hz <hz>" on pico_param, see
+ * uros_params.h) starts both cores sampling at that rate; setting it back
+ * to 0 stops them and sends the histograms on
+ * "profile", reliable std_msgs/UInt32MultiArray, one message every
+ * UROS_PROFILE_MS so the dump does not crowd out the other streams. The
+ * layout has one dimension labelled UROS_PROFILE_LAYOUT, and the data is
+ *   seq, last, core, hz, samples, dropped, entries   header
+ *   pc, lr, count                                    per pair
+ * seq counts from 0 in a dump and last is 1 on its final message. Each
+ * core sends at least one message, so its header arrives with no pairs.
+ * tools/profile_report.py symbolises the dump against LVGLProj.elf.
+ */
+
+#define UROS_PROFILE_MS			20
+#define UROS_PROFILE_PAIRS		32		// Per message
+#define UROS_PROFILE_HEADER		7
+#define UROS_PROFILE_LAYOUT		"pico_profile_v1"
+#if PROFILER
+#define UROS_PROFILE_HANDLES	1		// Executor handles taken by uros_profile_init
+#else
+#define UROS_PROFILE_HANDLES	0
+#endif
+
+bool uros_profile_init(rcl_node_t *node, rclc_support_t *support, rclc_executor_t *executor);
+bool uros_profile_set_hz(uint32_t hz);
+
+#endif //_UROS_PROFILE_H_
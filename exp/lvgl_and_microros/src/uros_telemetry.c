@@ -0,0 +1,138 @@
+#include "uros_telemetry.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include <rcl/rcl.h>
+#include <std_msgs/msg/u_int32_multi_array.h>
+
+#include "ipc_channel.h"
+#include "uros_node.h"
+#include "uros_imu.h"
+#include "uros_transport.h"
+#include "uros_msgpool.h"
+#include "uros_alloc.h"
+#include "boot.h"
+#include "uros_params.h"
+#if LVGLPROJ_FREERTOS
+#include "rtos_report.h"
+#endif
+
+// The data sequence, one dimension and its label, sized once at init
+#define TELEMETRY_LABEL		sizeof(UROS_TELEMETRY_LAYOUT)
+#define TELEMETRY_MEMORY	(UROS_TELEMETRY_FIELDS * sizeof(uint32_t) + \
+	sizeof(std_msgs__msg__MultiArrayDimension) + TELEMETRY_LABEL + 16)
+
+static rcl_publisher_t telemetry_publisher;
+static rcl_timer_t telemetry_timer;
+static std_msgs__msg__UInt32MultiArray *telemetry_msg;
+UROS_MSGPOOL_DEFINE(telemetry_msgpool, std_msgs__msg__UInt32MultiArray, 1, TELEMETRY_MEMORY);
+
+// The UI snapshot is only replaced when core1 posts a new one
+static ipc_ui_telemetry_t ui;
+
+static void telemetry_timer_callback(rcl_timer_t *timer, int64_t last_call_time)
+{
+	const ipc_ui_telemetry_t *latest = ipc_mailbox_read(&ipc_telemetry_mailbox);
+	if (latest != NULL){
+		ui = *latest;
+	}
+
+	uros_transport_stats_t transport;
+	uros_imu_stats_t imu;
+	uros_alloc_stats_t alloc;
+	uros_node_stats_t node;
+	uros_params_stats_t params;
+	uros_transport_get_stats(&transport);
+	uros_imu_get_stats(&imu);
+	uros_alloc_get_stats(&alloc);
+	uros_node_get_stats(&node);
+	uros_params_get_stats(&params);
+	uint32_t *data = telemetry_msg->data.data;
+
+#if LVGLPROJ_FREERTOS
+	// Tasks float between the cores, only the combined load is known
+	rtos_report_t report;
+	rtos_report_get(&report);
+	data[UROS_TELEMETRY_CPU0_LOAD_PCT] = report.cpu_load_pct;
+	data[UROS_TELEMETRY_CPU1_LOAD_PCT] = report.cpu_load_pct;
+#else
+	data[UROS_TELEMETRY_CPU0_LOAD_PCT] = 100 - node.idle_pct;
+	data[UROS_TELEMETRY_CPU1_LOAD_PCT] = ui.cpu_load_pct;
+#endif
+	data[UROS_TELEMETRY_UPTIME_S] = (uint32_t)(time_us_64() / 1000000);
+	data[UROS_TELEMETRY_FRAMES] = ui.frames;
+	data[UROS_TELEMETRY_FRAME_US_P50] = ui.frame_us_p50;
+	data[UROS_TELEMETRY_FRAME_US_P90] = ui.frame_us_p90;
+	data[UROS_TELEMETRY_FRAME_US_P99] = ui.frame_us_p99;
+	data[UROS_TELEMETRY_FRAME_US_MAX] = ui.frame_us_max;
+	data[UROS_TELEMETRY_FLUSH_BYTES_PER_S] = ui.flush_bytes_per_s;
+	data[UROS_TELEMETRY_FLUSH_BUSY_PCT] = ui.flush_busy_pct;
+	data[UROS_TELEMETRY_HEAP_LIVE] = ui.heap_live;
+	data[UROS_TELEMETRY_HEAP_PEAK] = ui.heap_peak;
+	data[UROS_TELEMETRY_HEAP_FREE] = ui.heap_free;
+	data[UROS_TELEMETRY_HEAP_LARGEST_FREE] = ui.heap_largest_free;
+	data[UROS_TELEMETRY_HEAP_FRAG_PCT] = ui.heap_frag_pct;
+	data[UROS_TELEMETRY_HEAP_FAILURES] = ui.heap_failures;
+	data[UROS_TELEMETRY_TX_BYTES] = transport.tx_bytes;
+	data[UROS_TELEMETRY_RX_BYTES] = transport.rx_bytes;
+	data[UROS_TELEMETRY_TRANSPORT_ERRORS] = transport.errors;
+	data[UROS_TELEMETRY_IMU_PUBLISHED] = imu.published;
+	data[UROS_TELEMETRY_IMU_DROPPED] = imu.dropped;
+	data[UROS_TELEMETRY_ROS_RUNTIME_ALLOCS] = alloc.runtime_allocs;
+	data[UROS_TELEMETRY_INPUT_EVENTS] = ui.input_events;
+	data[UROS_TELEMETRY_INPUT_LATE_US_MAX] = ui.input_late_us_max;
+	data[UROS_TELEMETRY_BOOT_FIRST_FRAME_US] = boot_event_us(BOOT_FIRST_FRAME);
+	data[UROS_TELEMETRY_BOOT_ROS_READY_US] = boot_event_us(BOOT_ROS_READY);
+	data[UROS_TELEMETRY_INIT_FAILURES] = node.init_failures;
+	data[UROS_TELEMETRY_PARAM_COMMANDS] = params.commands;
+	data[UROS_TELEMETRY_PARAM_REJECTED] = params.rejected;
+
+	rcl_publish(&telemetry_publisher, telemetry_msg, NULL);
+}
+
+/***
+ * Create the publisher and its timer, the executor needs one handle
+ * @return false if an entity could not be created
+ */
+bool uros_telemetry_init(rcl_node_t *node, rclc_support_t *support, rclc_executor_t *executor){
+	micro_ros_utilities_memory_rule_t rules[] = {
+		{"data", UROS_TELEMETRY_FIELDS},
+		{"layout.dim", 1},
+	};
+	micro_ros_utilities_memory_conf_t conf = micro_ros_utilities_memory_conf_default;
+	conf.max_string_capacity = TELEMETRY_LABEL;
+	conf.rules = rules;
+	conf.n_rules = sizeof(rules) / sizeof(rules[0]);
+	if (!uros_msgpool_init(&telemetry_msgpool,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, UInt32MultiArray), &conf)){
+		return false;
+	}
+
+	// Held for good, the layout names the field set
+	telemetry_msg = uros_msgpool_take(&telemetry_msgpool);
+	std_msgs__msg__MultiArrayDimension *dim = telemetry_msg->layout.dim.data;
+	memcpy(dim->label.data, UROS_TELEMETRY_LAYOUT, TELEMETRY_LABEL);
+	dim->label.size = TELEMETRY_LABEL - 1;
+	dim->size = UROS_TELEMETRY_FIELDS;
+	dim->stride = UROS_TELEMETRY_FIELDS;
+	telemetry_msg->layout.dim.size = 1;
+	telemetry_msg->data.size = UROS_TELEMETRY_FIELDS;
+
+	if (rclc_publisher_init_best_effort(
+		&telemetry_publisher,
+		node,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, UInt32MultiArray),
+		"telemetry") != RCL_RET_OK){
+		return false;
+	}
+
+	if (rclc_timer_init_default(
+		&telemetry_timer,
+		support,
+		RCL_MS_TO_NS(UROS_TELEMETRY_MS),
+		telemetry_timer_callback) != RCL_RET_OK){
+		return false;
+	}
+	return rclc_executor_add_timer(executor, &telemetry_timer) == RCL_RET_OK;
+}
@@ -0,0 +1,60 @@
+#ifndef _UROS_TELEMETRY_H_
+#define _UROS_TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rclc/rclc.h>
+#include <rclc/executor.h>
+
+/*
+ * Performance telemetry on "telemetry", best effort, every UROS_TELEMETRY_MS.
+ * The message is a std_msgs/UInt32MultiArray with one dimension labelled
+ * UROS_TELEMETRY_LAYOUT and the fields below in that order; counters are
+ * totals since boot, everything else covers the last interval. The core1
+ * values come from the snapshot the UI posts to ipc_telemetry_mailbox.
+ * tools/telemetry_echo.py prints it by field name.
+ */
+
+#ifndef UROS_TELEMETRY_MS
+#define UROS_TELEMETRY_MS	1000
+#endif
+#define UROS_TELEMETRY_LAYOUT	"pico_telemetry_v5"
+#define UROS_TELEMETRY_HANDLES	1	// Executor handles taken by uros_telemetry_init
+
+typedef enum {
+	UROS_TELEMETRY_UPTIME_S = 0,
+	UROS_TELEMETRY_CPU0_LOAD_PCT,		// micro-ROS core, 100 - executor idle
+	UROS_TELEMETRY_CPU1_LOAD_PCT,		// UI core, scheduler busy share
+	UROS_TELEMETRY_FRAMES,				// LVGL refreshes in the interval
+	UROS_TELEMETRY_FRAME_US_P50,		// Render start to last flush done
+	UROS_TELEMETRY_FRAME_US_P90,
+	UROS_TELEMETRY_FRAME_US_P99,
+	UROS_TELEMETRY_FRAME_US_MAX,
+	UROS_TELEMETRY_FLUSH_BYTES_PER_S,
+	UROS_TELEMETRY_FLUSH_BUSY_PCT,
+	UROS_TELEMETRY_HEAP_LIVE,			// lv_heap bytes
+	UROS_TELEMETRY_HEAP_PEAK,
+	UROS_TELEMETRY_HEAP_FREE,
+	UROS_TELEMETRY_HEAP_LARGEST_FREE,
+	UROS_TELEMETRY_HEAP_FRAG_PCT,
+	UROS_TELEMETRY_HEAP_FAILURES,
+	UROS_TELEMETRY_TX_BYTES,			// Transport totals
+	UROS_TELEMETRY_RX_BYTES,
+	UROS_TELEMETRY_TRANSPORT_ERRORS,
+	UROS_TELEMETRY_IMU_PUBLISHED,
+	UROS_TELEMETRY_IMU_DROPPED,			// Samples lost, see uros_imu_stats_t.dropped
+	UROS_TELEMETRY_ROS_RUNTIME_ALLOCS,	// micro-ROS allocations after set up, see uros_alloc_seal
+	UROS_TELEMETRY_INPUT_EVENTS,		// Injected input applied by the UI, see uros_input.h
+	UROS_TELEMETRY_INPUT_LATE_US_MAX,	// Injected event applied behind its time
+	UROS_TELEMETRY_BOOT_FIRST_FRAME_US,	// Since reset, see boot.h; 0 until reached
+	UROS_TELEMETRY_BOOT_ROS_READY_US,
+	UROS_TELEMETRY_INIT_FAILURES,		// uros_node_stats_t.init_failures bits
+	UROS_TELEMETRY_PARAM_COMMANDS,		// Received on pico_param, see uros_params.h
+	UROS_TELEMETRY_PARAM_REJECTED,
+	UROS_TELEMETRY_FIELDS
+} uros_telemetry_field_t;
+
+bool uros_telemetry_init(rcl_node_t *node, rclc_support_t *support, rclc_executor_t *executor);
+
+#endif //_UROS_TELEMETRY_H_
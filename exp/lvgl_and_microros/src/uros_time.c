@@ -0,0 +1,201 @@
+#include "uros_time.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#include <rcl/rcl.h>
+#include <rmw_microros/rmw_microros.h>
+
+typedef struct {
+	uint64_t local_us;
+	int64_t offset_ns;		// Agent time minus local time
+} time_sample_t;
+
+// Model: offset(t) = offset_ns + (t - anchor_us) * drift_ppb / 1e6
+typedef struct {
+	bool valid;
+	uint64_t anchor_us;
+	int64_t offset_ns;
+	int32_t drift_ppb;
+} time_model_t;
+
+static rcl_timer_t sync_timer;
+static time_sample_t samples[UROS_TIME_SAMPLES];
+static uint32_t sample_count;
+static uint32_t sample_next;
+static uint32_t rejects;
+
+static time_model_t model;
+static spin_lock_t *model_lock;
+static uros_time_stats_t stats;
+
+static int64_t model_offset(const time_model_t *m, uint64_t local_us)
+{
+	int64_t dt_us = (int64_t)(local_us - m->anchor_us);
+	return m->offset_ns + dt_us * m->drift_ppb / 1000000;
+}
+
+/*
+ * Least squares line through the samples, around their centroid so the
+ * products stay small. Soft float is fine at one fit every few seconds.
+ */
+static void fit_model(time_model_t *m)
+{
+	const time_sample_t *first = &samples[(sample_next + UROS_TIME_SAMPLES - sample_count) % UROS_TIME_SAMPLES];
+	double mean_t = 0, mean_o = 0;
+	for (uint32_t i = 0; i < sample_count; i++){
+		const time_sample_t *s = &samples[i];
+		mean_t += (double)(int64_t)(s->local_us - first->local_us);
+		mean_o += (double)(s->offset_ns - first->offset_ns);
+	}
+	mean_t /= sample_count;
+	mean_o /= sample_count;
+
+	double sxy = 0, sxx = 0;
+	for (uint32_t i = 0; i < sample_count; i++){
+		const time_sample_t *s = &samples[i];
+		double dt = (double)(int64_t)(s->local_us - first->local_us) - mean_t;
+		double dofs = (double)(s->offset_ns - first->offset_ns) - mean_o;
+		sxy += dt * dofs;
+		sxx += dt * dt;
+	}
+
+	// ns of offset per us of local time, times 1e6 for parts per billion
+	double drift = sxx > 0 ? sxy / sxx * 1e6 : 0;
+	if (drift > UROS_TIME_MAX_DRIFT_PPB){
+		drift = UROS_TIME_MAX_DRIFT_PPB;
+	} else if (drift < -UROS_TIME_MAX_DRIFT_PPB){
+		drift = -UROS_TIME_MAX_DRIFT_PPB;
+	}
+
+	m->valid = true;
+	m->anchor_us = first->local_us + (uint64_t)(int64_t)mean_t;
+	m->offset_ns = first->offset_ns + (int64_t)mean_o;
+	m->drift_ppb = (int32_t)drift;
+}
+
+static void add_sample(uint64_t local_us, int64_t offset_ns)
+{
+	if (model.valid){
+		int64_t residual = offset_ns - model_offset(&model, local_us);
+		stats.residual_ns = (int32_t)MAX(MIN(residual, INT32_MAX), INT32_MIN);
+		if (residual > UROS_TIME_MAX_RESIDUAL_NS || residual < -UROS_TIME_MAX_RESIDUAL_NS){
+			stats.rejected++;
+			if (++rejects < UROS_TIME_MAX_REJECTS){
+				return;
+			}
+			// The agent clock stepped, start over from this sample
+			stats.resets++;
+			sample_count = 0;
+			sample_next = 0;
+		}
+	}
+	rejects = 0;
+
+	samples[sample_next] = (time_sample_t){ local_us, offset_ns };
+	sample_next = (sample_next + 1) % UROS_TIME_SAMPLES;
+	if (sample_count < UROS_TIME_SAMPLES){
+		sample_count++;
+	}
+
+	time_model_t m;
+	fit_model(&m);
+	uint32_t save = spin_lock_blocking(model_lock);
+	model = m;
+	spin_unlock(model_lock, save);
+
+	stats.syncs++;
+	stats.offset_ns = offset_ns;
+	stats.drift_ppb = m.drift_ppb;
+}
+
+static void sync_once(void)
+{
+	if (rmw_uros_sync_session(UROS_TIME_SYNC_TIMEOUT_MS) != RMW_RET_OK){
+		stats.failures++;
+		return;
+	}
+	// rmw's epoch is its last offset applied to the same time_us_64 clock
+	// (clock_gettime in pico_uart_transport.c); read it between two stamps
+	uint64_t before_us = time_us_64();
+	int64_t epoch_ns = rmw_uros_epoch_nanos();
+	uint64_t after_us = time_us_64();
+	uint64_t local_us = before_us + (after_us - before_us) / 2;
+	add_sample(local_us, epoch_ns - (int64_t)local_us * 1000);
+}
+
+static void sync_timer_callback(rcl_timer_t *timer, int64_t last_call_time)
+{
+	sync_once();
+}
+
+/***
+ * Synchronise once now and every UROS_TIME_SYNC_MS from the executor
+ * @return false if the timer could not be created
+ */
+bool uros_time_init(rclc_support_t *support, rclc_executor_t *executor){
+	if (model_lock == NULL){
+		model_lock = spin_lock_instance(spin_lock_claim_unused(true));	// Counted in IPC_CLAIMED_SPIN_LOCKS
+	}
+	sync_once();
+
+	if (rclc_timer_init_default(
+		&sync_timer,
+		support,
+		RCL_MS_TO_NS(UROS_TIME_SYNC_MS),
+		sync_timer_callback) != RCL_RET_OK){
+		return false;
+	}
+	return rclc_executor_add_timer(executor, &sync_timer) == RCL_RET_OK;
+}
+
+bool uros_time_synchronized(void){
+	return model.valid;
+}
+
+/***
+ * Convert a time_us_64 timestamp to agent time
+ * @return false before the first sync, ros_ns is then left alone
+ */
+bool uros_time_to_ros_ns(uint64_t local_us, int64_t *ros_ns){
+	if (model_lock == NULL){
+		return false;
+	}
+	uint32_t save = spin_lock_blocking(model_lock);
+	time_model_t m = model;
+	spin_unlock(model_lock, save);
+
+	if (!m.valid){
+		return false;
+	}
+	*ros_ns = (int64_t)local_us * 1000 + model_offset(&m, local_us);
+	return true;
+}
+
+/***
+ * Fill a message stamp from a time_us_64 timestamp, with board uptime
+ * before the first sync
+ * @return false if the stamp is board uptime
+ */
+bool uros_time_to_msg(uint64_t local_us, builtin_interfaces__msg__Time *stamp){
+	int64_t ns = (int64_t)local_us * 1000;
+	bool synced = uros_time_to_ros_ns(local_us, &ns);
+	stamp->sec = (int32_t)(ns / 1000000000);
+	stamp->nanosec = (uint32_t)(ns % 1000000000);
+	return synced;
+}
+
+/***
+ * Current agent time, board uptime before the first sync
+ */
+int64_t uros_time_now_ns(void){
+	uint64_t now_us = time_us_64();
+	int64_t ns = (int64_t)now_us * 1000;
+	uros_time_to_ros_ns(now_us, &ns);
+	return ns;
+}
+
+void uros_time_get_stats(uros_time_stats_t *out){
+	*out = stats;
+}
@@ -0,0 +1,52 @@
+#ifndef _UROS_TIME_H_
+#define _UROS_TIME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rclc/rclc.h>
+#include <rclc/executor.h>
+#include <builtin_interfaces/msg/time.h>
+
+/*
+ * Agent (ROS) time for samples stamped with time_us_64. The session is
+ * synchronised every UROS_TIME_SYNC_MS from an executor timer, and a line
+ * fitted through the last UROS_TIME_SAMPLES offsets models both the offset
+ * and the crystal drift, so conversions stay accurate between syncs.
+ * A sync that disagrees with the model by more than UROS_TIME_MAX_RESIDUAL_NS
+ * is dropped; UROS_TIME_MAX_REJECTS in a row mean the agent clock stepped
+ * and the model restarts from the new offset.
+ *
+ * The conversions only read the model under a spinlock, so IMU, touch and
+ * RTC timestamps can be converted from either core.
+ */
+
+#ifndef UROS_TIME_SYNC_MS
+#define UROS_TIME_SYNC_MS			10000
+#endif
+#define UROS_TIME_SYNC_TIMEOUT_MS	100
+#define UROS_TIME_SAMPLES			8
+#define UROS_TIME_MAX_RESIDUAL_NS	2000000
+#define UROS_TIME_MAX_REJECTS		3
+#define UROS_TIME_MAX_DRIFT_PPB		500000	// 500 ppm, well past the crystal
+
+#define UROS_TIME_HANDLES	1	// Executor handles taken by uros_time_init
+
+typedef struct {
+	uint32_t syncs;				// Accepted samples
+	uint32_t failures;			// Sync requests without an answer
+	uint32_t rejected;			// Samples too far from the model
+	uint32_t resets;			// Model restarts after an agent clock step
+	int64_t offset_ns;			// Agent time minus local time at the last sync
+	int32_t drift_ppb;			// Agent clock rate relative to the local one
+	int32_t residual_ns;		// Last sample minus the model's prediction
+} uros_time_stats_t;
+
+bool uros_time_init(rclc_support_t *support, rclc_executor_t *executor);
+bool uros_time_synchronized(void);
+bool uros_time_to_ros_ns(uint64_t local_us, int64_t *ros_ns);
+bool uros_time_to_msg(uint64_t local_us, builtin_interfaces__msg__Time *stamp);
+int64_t uros_time_now_ns(void);
+void uros_time_get_stats(uros_time_stats_t *stats);
+
+#endif //_UROS_TIME_H_
@@ -0,0 +1,97 @@
+#include "uros_trace.h"
+
+#include "pico/stdlib.h"
+
+#if TRACE
+#include <rcl/rcl.h>
+#include <std_msgs/msg/string.h>
+
+#include "uros_msgpool.h"
+
+#define TRACE_MEMORY	(UROS_TRACE_BYTES + 16)
+
+static rcl_publisher_t trace_publisher;
+static rcl_timer_t trace_timer;
+static std_msgs__msg__String *trace_msg;
+UROS_MSGPOOL_DEFINE(trace_msgpool, std_msgs__msg__String, 1, TRACE_MEMORY);
+
+static bool dumping;
+static trace_cursor_t cursor;
+
+static void trace_timer_callback(rcl_timer_t *timer, int64_t last_call_time)
+{
+	if (!dumping){
+		return;
+	}
+	trace_cursor_t at = cursor;
+	size_t len = trace_format(&cursor, trace_msg->data.data, trace_msg->data.capacity);
+	if (len == 0){
+		dumping = false;
+		return;
+	}
+	trace_msg->data.size = len;
+	if (rcl_publish(&trace_publisher, trace_msg, NULL) != RCL_RET_OK){
+		cursor = at;	// Again on the next tick
+	}
+}
+
+/***
+ * Create the publisher and its timer, the executor needs
+ * UROS_TRACE_HANDLES handles
+ * @return false if an entity could not be created
+ */
+bool uros_trace_init(rcl_node_t *node, rclc_support_t *support, rclc_executor_t *executor){
+	micro_ros_utilities_memory_conf_t conf = micro_ros_utilities_memory_conf_default;
+	conf.max_string_capacity = UROS_TRACE_BYTES;
+	if (!uros_msgpool_init(&trace_msgpool,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String), &conf)){
+		return false;
+	}
+	trace_msg = uros_msgpool_take(&trace_msgpool);
+
+	// Reliable: a lost piece would cut lines in two
+	if (rclc_publisher_init_default(
+		&trace_publisher,
+		node,
+		ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String),
+		"trace") != RCL_RET_OK){
+		return false;
+	}
+
+	if (rclc_timer_init_default(
+		&trace_timer,
+		support,
+		RCL_MS_TO_NS(UROS_TRACE_MS),
+		trace_timer_callback) != RCL_RET_OK){
+		return false;
+	}
+	return rclc_executor_add_timer(executor, &trace_timer) == RCL_RET_OK;
+}
+
+/***
+ * Clear the rings and trace, or freeze them and send the dump
+ * @return true
+ */
+bool uros_trace_set_enabled(bool enabled){
+	if (enabled){
+		dumping = false;
+		trace_start();
+		return true;
+	}
+	trace_stop();
+	trace_cursor_init(&cursor);
+	dumping = true;
+	return true;
+}
+
+#else
+
+bool uros_trace_init(rcl_node_t *node, rclc_support_t *support, rclc_executor_t *executor){
+	return true;
+}
+
+bool uros_trace_set_enabled(bool enabled){
+	return !enabled;
+}
+
+#endif
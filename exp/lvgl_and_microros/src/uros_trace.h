@@ -0,0 +1,33 @@
+#ifndef _UROS_TRACE_H_
+#define _UROS_TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rclc/rclc.h>
+#include <rclc/executor.h>
+
+#include "trace.h"
+
+/*
+ * Event trace (trace.h) control and dump, for builds with TRACE=1, which
+ * trace from boot. Setting the trace knob to 0 ("trace 0" on pico_param,
+ * see uros_params.h) freezes the rings and sends them on "trace", reliable std_msgs/String, as the text of
+ * trace_dump in pieces of up to UROS_TRACE_BYTES, one every UROS_TRACE_MS;
+ * the last piece ends with the TRACE_DONE line. Setting it to 1 clears the
+ * rings and traces again. tools/trace_export.py --ros collects the dump
+ * and writes Chrome trace JSON.
+ */
+
+#define UROS_TRACE_MS		20
+#define UROS_TRACE_BYTES	480		// Per message, whole lines
+#if TRACE
+#define UROS_TRACE_HANDLES	1		// Executor handles taken by uros_trace_init
+#else
+#define UROS_TRACE_HANDLES	0
+#endif
+
+bool uros_trace_init(rcl_node_t *node, rclc_support_t *support, rclc_executor_t *executor);
+bool uros_trace_set_enabled(bool enabled);
+
+#endif //_UROS_TRACE_H_
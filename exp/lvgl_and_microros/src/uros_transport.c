@@ -0,0 +1,192 @@
+#include "uros_transport.h"
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include <rmw_microros/rmw_microros.h>
+
+#include "pico_uart_transport.h"
+#include "usb_cdc_transport.h"
+#include "dma_uart_transport.h"
+#include "trace.h"
+
+static write_custom_func transport_write;
+static read_custom_func transport_read;
+static struct uxrCustomTransport *batch_transport;
+static uint8_t batch_buf[UROS_TRANSPORT_BATCH_BYTES];
+static size_t batch_len;
+static bool batch_hold;
+static uros_transport_stats_t stats;
+
+// Receive wakeup, see uros_transport_wait
+static uros_transport_t selected;
+static size_t (*rx_available)(void);
+static void (*rx_wake)(bool enable);
+static bool rx_stdio_callback;
+static volatile bool rx_signalled;
+static volatile uint64_t rx_signal_us;
+
+static size_t counted_write(struct uxrCustomTransport *transport, const uint8_t *buf, size_t len, uint8_t *errcode){
+	TRACE_BEGIN(TRACE_TRANSPORT_WRITE);
+	size_t n = transport_write(transport, buf, len, errcode);
+	TRACE_END(TRACE_TRANSPORT_WRITE, n);
+	stats.tx_bytes += n;
+	if (n != len){
+		stats.errors++;
+	}
+	return n;
+}
+
+static size_t counted_read(struct uxrCustomTransport *transport, uint8_t *buf, size_t len, int timeout, uint8_t *errcode){
+	// A timeout also sets errcode, so only the bytes are counted here
+	TRACE_BEGIN(TRACE_TRANSPORT_READ);
+	size_t n = transport_read(transport, buf, len, timeout, errcode);
+	TRACE_END(TRACE_TRANSPORT_READ, n);
+	stats.rx_bytes += n;
+	return n;
+}
+
+static size_t batch_write(struct uxrCustomTransport *transport, const uint8_t *buf, size_t len, uint8_t *errcode){
+	if (!batch_hold){
+		return counted_write(transport, buf, len, errcode);
+	}
+	batch_transport = transport;
+	if (batch_len + len > sizeof(batch_buf)){
+		uros_transport_flush();
+	}
+	if (len > sizeof(batch_buf)){
+		return counted_write(transport, buf, len, errcode);
+	}
+	memcpy(batch_buf + batch_len, buf, len);
+	batch_len += len;
+	stats.batched_writes++;
+	return len;
+}
+
+void uros_transport_hold(void){
+	batch_hold = true;
+}
+
+void uros_transport_flush(void){
+	if (batch_len == 0 || transport_write == NULL){
+		return;
+	}
+	uint8_t errcode = 0;
+	counted_write(batch_transport, batch_buf, batch_len, &errcode);
+	stats.batches++;
+	batch_len = 0;
+}
+
+void uros_transport_release(void){
+	uros_transport_flush();
+	batch_hold = false;
+}
+
+void uros_transport_get_stats(uros_transport_stats_t *out){
+	*out = stats;
+}
+
+/*
+ * Called from the stdio driver IRQ or the RX pin edge IRQ. Keeps the time
+ * of the first signal until uros_transport_take_rx_time collects it.
+ */
+static void rx_signal(void){
+	if (rx_signal_us == 0){
+		rx_signal_us = time_us_64();
+	}
+	rx_signalled = true;
+	__sev();
+}
+
+static void rx_stdio_signal(void *param){
+	rx_signal();
+}
+
+static size_t rx_stdio_available(void){
+	// No peek through stdio, the callback flag stands in for a count
+	return rx_signalled ? 1 : 0;
+}
+
+static void set_transport(open_custom_func open, close_custom_func close,
+		write_custom_func write, read_custom_func read,
+		size_t (*available)(void), void (*wake)(bool enable)){
+	transport_write = write;
+	transport_read = read;
+	rx_available = available;
+	rx_wake = wake;
+	rmw_uros_set_custom_transport(true, NULL, open, close, batch_write, counted_read);
+}
+
+/***
+ * Sleep until received data is waiting in the transport or the deadline
+ * passes. Call between executor spins, after the session is open.
+ * @return true if data is waiting
+ */
+bool uros_transport_wait(uint64_t deadline_us){
+	if (rx_available == NULL){
+		return false;
+	}
+	if (!rx_stdio_callback && selected != UROS_TRANSPORT_DMA_UART){
+		// The stdio drivers only exist once the transport has been opened
+		stdio_set_chars_available_callback(rx_stdio_signal, NULL);
+		rx_stdio_callback = true;
+	}
+	if (rx_wake != NULL){
+		rx_wake(true);
+	}
+	TRACE_BEGIN(TRACE_TRANSPORT_WAIT);
+
+	// Any interrupt also ends a __wfe, so recheck on every wakeup
+	absolute_time_t deadline = from_us_since_boot(deadline_us);
+	bool ready;
+	while (!(ready = rx_available() > 0)){
+		if (best_effort_wfe_or_timeout(deadline)){
+			ready = rx_available() > 0;
+			break;
+		}
+	}
+
+	TRACE_END(TRACE_TRANSPORT_WAIT, ready);
+	if (rx_wake != NULL){
+		rx_wake(false);
+	}
+	rx_signalled = false;
+	return ready;
+}
+
+/***
+ * Time of the first receive signal since the last call, taken before a spin
+ * @return time_us_64 of the signal, 0 if there was none
+ */
+uint64_t uros_transport_take_rx_time(void){
+	uint32_t save = save_and_disable_interrupts();
+	uint64_t t = rx_signal_us;
+	rx_signal_us = 0;
+	restore_interrupts(save);
+	return t;
+}
+
+/***
+ * Register the transport with rmw, call before uros_node_init
+ * @return false for an unknown transport
+ */
+bool uros_transport_select(uros_transport_t transport){
+	selected = transport;
+	switch (transport){
+	case UROS_TRANSPORT_STDIO:
+		set_transport(pico_serial_transport_open, pico_serial_transport_close, pico_serial_transport_write, pico_serial_transport_read,
+			rx_stdio_available, NULL);
+		return true;
+	case UROS_TRANSPORT_USB_CDC:
+		set_transport(usb_cdc_transport_open, usb_cdc_transport_close, usb_cdc_transport_write, usb_cdc_transport_read,
+			usb_cdc_transport_available, NULL);
+		return true;
+	case UROS_TRANSPORT_DMA_UART:
+		dma_uart_transport_set_rx_callback(rx_signal);
+		set_transport(dma_uart_transport_open, dma_uart_transport_close, dma_uart_transport_write, dma_uart_transport_read,
+			dma_uart_transport_available, dma_uart_transport_wake_on_rx);
+		return true;
+	default:
+		return false;
+	}
+}
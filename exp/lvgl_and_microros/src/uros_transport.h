@@ -0,0 +1,54 @@
+#ifndef _UROS_TRANSPORT_H_
+#define _UROS_TRANSPORT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Selects the micro-ROS custom transport. main passes UROS_TRANSPORT, set
+ * with a compile definition; the choice is a run time value, so it can
+ * also be made at boot, e.g. from a strap pin, before uros_node_init.
+ */
+
+typedef enum {
+	UROS_TRANSPORT_STDIO = 0,	// pico_uart_transport.c, one stdio call per byte
+	UROS_TRANSPORT_USB_CDC,		// usb_cdc_transport.c, whole buffers through TinyUSB
+	UROS_TRANSPORT_DMA_UART,	// dma_uart_transport.c, hardware UART to a bridge
+} uros_transport_t;
+
+#ifndef UROS_TRANSPORT
+#define UROS_TRANSPORT UROS_TRANSPORT_USB_CDC
+#endif
+
+#define UROS_TRANSPORT_BATCH_BYTES 1024
+
+typedef struct {
+	uint32_t batches;			// Flushes of held writes
+	uint32_t batched_writes;	// Writes that went into a batch
+	uint32_t errors;			// Failed or short writes, the frames are lost
+	uint32_t tx_bytes;
+	uint32_t rx_bytes;
+} uros_transport_stats_t;
+
+bool uros_transport_select(uros_transport_t transport);
+
+/*
+ * Between hold and release, writes are collected and sent as one transport
+ * write when the buffer fills, on flush or on release. Only hold around
+ * best effort publishes, nothing may wait for a reply meanwhile.
+ */
+void uros_transport_hold(void);
+void uros_transport_flush(void);
+void uros_transport_release(void);
+void uros_transport_get_stats(uros_transport_stats_t *stats);
+
+/*
+ * Event driven spinning: wait sleeps in __wfe until the transport has
+ * received data or the deadline passes. The USB and stdio drivers wake it
+ * through the stdio chars available callback, the DMA UART through an
+ * edge interrupt on its RX pin.
+ */
+bool uros_transport_wait(uint64_t deadline_us);
+uint64_t uros_transport_take_rx_time(void);
+
+#endif //_UROS_TRANSPORT_H_
@@ -0,0 +1,90 @@
+#include "usb_cdc_transport.h"
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "tusb.h"
+
+#define USB_CDC_WRITE_TIMEOUT_US 100000
+
+/*
+ * tud_task runs from pico_stdio_usb's low priority IRQ on the core that
+ * called stdio_init_all, the same core as the transport. Masking IRQs
+ * while the FIFOs are touched stands in for stdio_usb's private mutex.
+ */
+
+bool usb_cdc_transport_open(struct uxrCustomTransport * transport)
+{
+    // Ensure that stdio_init_all is only called once on the runtime
+    static bool require_init = true;
+    if(require_init)
+    {
+        stdio_init_all();
+        require_init = false;
+    }
+    return true;
+}
+
+bool usb_cdc_transport_close(struct uxrCustomTransport * transport)
+{
+    return true;
+}
+
+size_t usb_cdc_transport_write(struct uxrCustomTransport * transport, const uint8_t *buf, size_t len, uint8_t *errcode)
+{
+    absolute_time_t deadline = make_timeout_time_us(USB_CDC_WRITE_TIMEOUT_US);
+    size_t sent = 0;
+    while (sent < len)
+    {
+        if (!tud_cdc_connected())
+        {
+            *errcode = 1;
+            break;
+        }
+
+        uint32_t save = save_and_disable_interrupts();
+        uint32_t room = tud_cdc_write_available();
+        uint32_t n = tud_cdc_write(buf + sent, MIN(room, len - sent));
+        tud_cdc_write_flush();
+        restore_interrupts(save);
+        sent += n;
+
+        if (sent < len)
+        {
+            // FIFO full: the USB IRQ drains it and ends the wait
+            if (best_effort_wfe_or_timeout(deadline))
+            {
+                *errcode = 1;
+                break;
+            }
+        }
+    }
+    return sent;
+}
+
+size_t usb_cdc_transport_available(void)
+{
+    uint32_t save = save_and_disable_interrupts();
+    uint32_t n = tud_cdc_available();
+    restore_interrupts(save);
+    return n;
+}
+
+size_t usb_cdc_transport_read(struct uxrCustomTransport * transport, uint8_t *buf, size_t len, int timeout, uint8_t *errcode)
+{
+    absolute_time_t deadline = make_timeout_time_ms(timeout);
+    for (;;)
+    {
+        uint32_t save = save_and_disable_interrupts();
+        uint32_t n = tud_cdc_available() ? tud_cdc_read(buf, len) : 0;
+        restore_interrupts(save);
+
+        // Hand over whatever arrived, the XRCE framing copes with partial reads
+        if (n > 0)
+            return n;
+        if (best_effort_wfe_or_timeout(deadline))
+        {
+            *errcode = 1;
+            return 0;
+        }
+    }
+}
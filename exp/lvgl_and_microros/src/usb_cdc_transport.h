@@ -0,0 +1,22 @@
+#ifndef _USB_CDC_TRANSPORT_H_
+#define _USB_CDC_TRANSPORT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <uxr/client/profile/transport/custom/custom_transport.h>
+
+/*
+ * micro-ROS custom transport that moves whole buffers through the TinyUSB
+ * CDC FIFOs instead of one stdio call per byte. The USB device is still
+ * set up and serviced by pico_stdio_usb; stdio output must not be used
+ * while the transport is open, it would interleave with XRCE frames.
+ */
+
+bool usb_cdc_transport_open(struct uxrCustomTransport * transport);
+bool usb_cdc_transport_close(struct uxrCustomTransport * transport);
+size_t usb_cdc_transport_write(struct uxrCustomTransport* transport, const uint8_t * buf, size_t len, uint8_t * err);
+size_t usb_cdc_transport_available(void);
+size_t usb_cdc_transport_read(struct uxrCustomTransport* transport, uint8_t* buf, size_t len, int timeout, uint8_t* err);
+
+#endif //_USB_CDC_TRANSPORT_H_
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+Collect the micro-benchmark results (src/bench.h) of LVGLProj_MicroBench on
+the USB serial port, or of host/micro_bench_host on stdin, print them and
+optionally compare them with a baseline. Exits with status 1 when a median
+got slower than the baseline by more than --tolerance.
+
+  micro_bench.py [--port /dev/ttyACM0] [--runs 3] [--baseline base.json]
+                 [--write-baseline FILE] [--tolerance 0.10] [--json out.json]
+
+With --runs N the device is asked N times ('r') and the lowest median of
+each case is kept, which filters out a run disturbed by USB traffic.
+Baselines are keyed by platform and case name, so host and target results
+can share a file.
+"""
+import argparse
+import json
+import sys
+
+PREFIX = "BENCH "
+DONE = "BENCH done"
+
+
+def read_run(lines):
+    """Results of one run, up to the done line"""
+    results = []
+    for line in lines:
+        line = line.strip()
+        if line == DONE:
+            break
+        if line.startswith(PREFIX):
+            results.append(json.loads(line[len(PREFIX):]))
+    return results
+
+
+def serial_lines(port):
+    import serial
+    ser = serial.Serial(port, 115200, timeout=30)
+
+    def lines():
+        while True:
+            raw = ser.readline()
+            if not raw:
+                raise TimeoutError("no benchmark output on %s" % port)
+            yield raw.decode("ascii", "replace")
+    return ser, lines()
+
+
+def key(r):
+    return "%s/%s" % (r["platform"], r["name"])
+
+
+def main():
+    parser = argparse.ArgumentParser(description="LVGLProj micro-benchmarks")
+    parser.add_argument("--port", help="serial port of LVGLProj_MicroBench, stdin if omitted")
+    parser.add_argument("--runs", type=int, default=1)
+    parser.add_argument("--baseline")
+    parser.add_argument("--write-baseline")
+    parser.add_argument("--tolerance", type=float, default=0.10)
+    parser.add_argument("--json", help="write the results to this file")
+    args = parser.parse_args()
+
+    best = {}
+    if args.port:
+        ser, lines = serial_lines(args.port)
+        for i in range(args.runs):
+            if i > 0:
+                ser.write(b"r")
+            for r in read_run(lines):
+                if key(r) not in best or r["ns_median"] < best[key(r)]["ns_median"]:
+                    best[key(r)] = r
+    else:
+        for r in read_run(sys.stdin):
+            best[key(r)] = r
+    if not best:
+        print("no results", file=sys.stderr)
+        return 2
+
+    baseline = {}
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    status = 0
+    print("%-36s %10s %10s %10s %10s %8s" % ("case", "min ns", "median ns", "max ns", "cycles", "vs base"))
+    for k, r in best.items():
+        delta = ""
+        if k in baseline:
+            change = r["ns_median"] / baseline[k]["ns_median"] - 1 if baseline[k]["ns_median"] else 0
+            delta = "%+.1f%%" % (change * 100)
+            if change > args.tolerance:
+                delta += " !"
+                status = 1
+        print("%-36s %10.1f %10.1f %10.1f %10.1f %8s" % (
+            k, r["ns_min"], r["ns_median"], r["ns_max"], r["cycles_median"], delta))
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(best, f, indent=1, sort_keys=True)
+    if args.write_baseline:
+        merged = dict(baseline)
+        merged.update(best)
+        with open(args.write_baseline, "w") as f:
+            json.dump(merged, f, indent=1, sort_keys=True)
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
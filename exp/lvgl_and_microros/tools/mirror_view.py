@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""
+Show the pico_node screen mirror (src/ui_mirror.c, src/uros_mirror.c). With
+the agent running and a ROS 2 environment sourced:
+
+  mirror_view.py [--topic screen_mirror] [--rotate 90] [--scale 2]
+                 [--save frame.ppm] [--no-enable]
+
+Each message carries one RLE encoded chunk of a flushed dirty rectangle
+(layout in src/ui_mirror.h). The chunks are painted into a framebuffer of
+the panel's size, and the window (tkinter) or the --save file is updated
+after the last chunk of every refresh. At start the viewer sends
+"mirror 1" on pico_param (src/uros_params.h), which turns the mirror on
+and sends a full frame; --no-enable leaves that to someone else.
+"""
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct("<HHHHHHIHHBB")
+FORMAT = "pico_rle565_v1"
+FLAG_LAST = 0x01
+FLAG_SWAP = 0x02
+
+
+def decode_rle(data, pixels):
+    """RGB565 values of one chunk, in the byte order the panel receives"""
+    out = []
+    i = 0
+    while i < len(data) and len(out) < pixels:
+        c = data[i]
+        i += 1
+        if c < 0x80:
+            n = c + 1
+            out.extend(struct.unpack_from("<%dH" % n, data, i))
+            i += 2 * n
+        else:
+            out.extend(struct.unpack_from("<H", data, i) * (c - 0x80 + 2))
+            i += 2
+    return out
+
+
+class Framebuffer:
+    def __init__(self):
+        self.w = self.h = 0
+        self.rgb = bytearray()
+
+    def apply(self, data):
+        """Paint one chunk, return True when it ends a refresh"""
+        (frame, x, y, w, h, pixels, start, sw, sh, flags, _) = HEADER.unpack_from(data)
+        if (sw, sh) != (self.w, self.h):
+            self.w, self.h = sw, sh
+            self.rgb = bytearray(sw * sh * 3)
+        for k, v in enumerate(decode_rle(data[HEADER.size:], pixels)):
+            if flags & FLAG_SWAP:
+                v = ((v & 0xff) << 8) | (v >> 8)
+            px = x + (start + k) % w
+            py = y + (start + k) // w
+            if px >= sw or py >= sh:
+                continue
+            o = (py * sw + px) * 3
+            self.rgb[o] = ((v >> 11) & 0x1f) * 255 // 31
+            self.rgb[o + 1] = ((v >> 5) & 0x3f) * 255 // 63
+            self.rgb[o + 2] = (v & 0x1f) * 255 // 31
+        return bool(flags & FLAG_LAST)
+
+    def ppm(self, rotate=0):
+        w, h, rgb = self.w, self.h, self.rgb
+        for _ in range((rotate // 90) % 4):
+            # Quarter turn clockwise
+            out = bytearray(len(rgb))
+            for yy in range(h):
+                for xx in range(w):
+                    s = (yy * w + xx) * 3
+                    d = (xx * h + (h - 1 - yy)) * 3
+                    out[d:d + 3] = rgb[s:s + 3]
+            w, h, rgb = h, w, out
+        return b"P6 %d %d 255\n" % (w, h) + bytes(rgb)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="pico_node screen mirror")
+    parser.add_argument("--topic", default="screen_mirror")
+    parser.add_argument("--rotate", type=int, default=0, choices=(0, 90, 180, 270))
+    parser.add_argument("--scale", type=int, default=1)
+    parser.add_argument("--save", help="write every refresh to this PPM file, no window")
+    parser.add_argument("--no-enable", action="store_true", help="do not send \"mirror 1\" at start")
+    args = parser.parse_args()
+
+    import rclpy
+    from rclpy.node import Node
+    from rclpy.qos import qos_profile_sensor_data
+    from sensor_msgs.msg import CompressedImage
+    from std_msgs.msg import String
+
+    fb = Framebuffer()
+    window = {}
+    if not args.save:
+        import tkinter
+        root = tkinter.Tk()
+        root.title("pico_node " + args.topic)
+        label = tkinter.Label(root)
+        label.pack()
+        window.update(root=root, label=label)
+
+    def show():
+        ppm = fb.ppm(args.rotate)
+        if args.save:
+            with open(args.save, "wb") as f:
+                f.write(ppm)
+            return
+        import tkinter
+        image = tkinter.PhotoImage(data=ppm, format="PPM").zoom(args.scale)
+        window["label"].configure(image=image)
+        window["label"].image = image
+
+    class MirrorView(Node):
+        def __init__(self):
+            super().__init__("mirror_view")
+            self.bytes = 0
+            self.create_subscription(CompressedImage, args.topic, self.on_msg, qos_profile_sensor_data)
+            self.param = self.create_publisher(String, "pico_param", 10)
+            self.enable_pending = not args.no_enable
+
+        def enable(self):
+            # Once pico_node subscribes, a message before that would be lost
+            if self.enable_pending and self.param.get_subscription_count() > 0:
+                self.param.publish(String(data="mirror 1"))
+                self.enable_pending = False
+
+        def on_msg(self, msg):
+            if msg.format != FORMAT:
+                self.get_logger().warning("unknown format %r" % msg.format)
+                return
+            self.bytes += len(msg.data)
+            if fb.apply(bytes(msg.data)):
+                show()
+
+    rclpy.init()
+    node = MirrorView()
+    try:
+        if args.save:
+            while rclpy.ok():
+                rclpy.spin_once(node, timeout_sec=0.1)
+                node.enable()
+        else:
+            def poll():
+                rclpy.spin_once(node, timeout_sec=0)
+                node.enable()
+                window["root"].after(5, poll)
+            poll()
+            window["root"].mainloop()
+    except KeyboardInterrupt:
+        pass
+    node.destroy_node()
+    rclpy.shutdown()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+"""
+Flat profile of both cores from the PC sampling profiler (src/profiler.h),
+symbolised against the firmware ELF. The histograms come from one of:
+
+  --ros SECONDS   a LVGLProj built with LVGLPROJ_PROFILER: sends
+                  "profile_hz <hz>" on pico_param (src/uros_params.h),
+                  waits, sends "profile_hz 0" and collects the dump on
+                  "profile" (src/uros_profile.h); needs the agent running
+                  and a ROS 2 environment sourced
+  --port PORT     LVGLProj_Soak built with the profiler: sends 'p' and reads
+                  the PROF lines it prints
+  otherwise       PROF lines on stdin, e.g. a saved serial log
+
+  profile_report.py build/src/LVGLProj.elf --ros 10 [--hz 2000] [--top 25]
+                    [--callers 5] [--lines 10] [--json out.json]
+
+Samples are attributed to the function holding the PC; --callers shows,
+for the top functions, which functions their LR returns into, which is
+exact for leaf functions and a hint otherwise. --lines resolves the
+hottest PCs to source lines with addr2line.
+"""
+import argparse
+import bisect
+import json
+import subprocess
+import sys
+import time
+from collections import Counter, defaultdict
+
+PREFIX = "PROF "
+DONE = "PROF done"
+LAYOUT = "pico_profile_v1"
+HEADER = 7
+EXC_RETURN = 0xfffffff0
+
+
+class Symbols:
+    def __init__(self, elf, nm):
+        out = subprocess.run([nm, "-n", "-S", "--defined-only", elf],
+                             check=True, capture_output=True, text=True).stdout
+        self.starts, self.ends, self.names = [], [], []
+        for line in out.splitlines():
+            parts = line.split()
+            # __not_in_flash_func code is copied to RAM with .data, so nm
+            # types it d/D; data objects never hold a sampled PC
+            if len(parts) != 4 or parts[2] not in "tTwWdD":
+                continue
+            start = int(parts[0], 16) & ~1
+            self.starts.append(start)
+            self.ends.append(start + int(parts[1], 16))
+            self.names.append(parts[3])
+
+    def name(self, addr):
+        if addr >= EXC_RETURN:
+            return "<exception entry>"
+        addr &= ~1
+        i = bisect.bisect_right(self.starts, addr) - 1
+        if i >= 0 and addr < self.ends[i]:
+            return self.names[i]
+        return "0x%08x" % addr
+
+
+def parse_lines(lines):
+    """hz, {core: stats} and [(core, pc, lr, count)] from PROF lines"""
+    hz, stats, pairs = 0, {}, []
+    for line in lines:
+        line = line.strip()
+        if line == DONE:
+            break
+        if not line.startswith(PREFIX):
+            continue
+        f = line[len(PREFIX):].split()
+        if f[0] == "hz":
+            hz = int(f[1])
+        elif f[0] == "core":
+            stats[int(f[1])] = {"samples": int(f[3]), "dropped": int(f[5]), "entries": int(f[7])}
+        else:
+            pairs.append((int(f[0]), int(f[1], 16), int(f[2], 16), int(f[3])))
+    return hz, stats, pairs
+
+
+def from_serial(port):
+    import serial
+    ser = serial.Serial(port, 115200, timeout=30)
+    ser.reset_input_buffer()
+    ser.write(b"p")
+
+    def lines():
+        while True:
+            raw = ser.readline()
+            if not raw:
+                raise TimeoutError("no profile on %s" % port)
+            yield raw.decode("ascii", "replace")
+    return parse_lines(lines())
+
+
+def from_ros(seconds, hz):
+    import rclpy
+    from rclpy.node import Node
+    from std_msgs.msg import String, UInt32MultiArray
+
+    class Collector(Node):
+        def __init__(self):
+            super().__init__("profile_report")
+            self.msgs = []
+            self.done = False
+            self.create_subscription(UInt32MultiArray, "profile", self.on_profile, 10)
+            self.param = self.create_publisher(String, "pico_param", 10)
+
+        def set_hz(self, value):
+            # A command sent before pico_node subscribes would be lost
+            deadline = time.time() + 10
+            while self.param.get_subscription_count() == 0:
+                if time.time() > deadline:
+                    raise TimeoutError("pico_node is not subscribed to pico_param")
+                rclpy.spin_once(self, timeout_sec=0.1)
+            self.param.publish(String(data="profile_hz %d" % value))
+
+        def on_profile(self, msg):
+            if not msg.layout.dim or msg.layout.dim[0].label != LAYOUT:
+                return
+            if msg.data[0] == 0:
+                self.msgs = []  # A new dump
+            self.msgs.append(list(msg.data))
+            self.done = bool(msg.data[1])
+
+    rclpy.init()
+    node = Collector()
+    try:
+        node.set_hz(hz)
+        time.sleep(seconds)
+        node.set_hz(0)
+        deadline = time.time() + 30
+        while not node.done and time.time() < deadline:
+            rclpy.spin_once(node, timeout_sec=0.5)
+    finally:
+        node.destroy_node()
+        rclpy.shutdown()
+    if not node.done:
+        raise TimeoutError("incomplete profile dump")
+
+    stats, pairs, seqs = {}, [], [m[0] for m in node.msgs]
+    if seqs != list(range(len(seqs))):
+        print("warning: profile messages missing", file=sys.stderr)
+    for m in node.msgs:
+        core = m[2]
+        hz = m[3]
+        stats[core] = {"samples": m[4], "dropped": m[5], "entries": m[6]}
+        for i in range(HEADER, len(m), 3):
+            pairs.append((core, m[i], m[i + 1], m[i + 2]))
+    return hz, stats, pairs
+
+
+def report(core, stats, pairs, syms, args):
+    total = sum(c for _, _, c in pairs)
+    funcs = Counter()
+    callers = defaultdict(Counter)
+    pcs = Counter()
+    for pc, lr, count in pairs:
+        fn = syms.name(pc)
+        funcs[fn] += count
+        # LR points after the call, step back into the calling instruction
+        callers[fn][syms.name(lr if lr >= EXC_RETURN else (lr & ~1) - 2)] += count
+        pcs[pc & ~1] += count
+
+    print("core %d: %d samples, %d dropped, %d pairs" % (
+        core, stats.get("samples", total), stats.get("dropped", 0), len(pairs)))
+    print("  %7s %6s  %s" % ("samples", "%", "function"))
+    for fn, count in funcs.most_common(args.top):
+        print("  %7d %5.1f%%  %s" % (count, 100.0 * count / total if total else 0, fn))
+        if args.callers:
+            for caller, n in callers[fn].most_common(args.callers):
+                print("  %7s %6s    <- %s (%d)" % ("", "", caller, n))
+    hot = pcs.most_common(args.lines)
+    if hot:
+        out = subprocess.run([args.addr2line, "-e", args.elf, "-f", "-C", "-s"] +
+                             ["0x%x" % pc for pc, _ in hot],
+                             check=True, capture_output=True, text=True).stdout.splitlines()
+        print("  hottest PCs:")
+        for k, (pc, count) in enumerate(hot):
+            print("  %7d  0x%08x  %s %s" % (count, pc, out[2 * k], out[2 * k + 1]))
+    print()
+    return {"samples": total, "dropped": stats.get("dropped", 0),
+            "functions": dict(funcs.most_common())}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="LVGLProj sampling profile")
+    parser.add_argument("elf", help="firmware ELF, e.g. build/src/LVGLProj.elf")
+    source = parser.add_mutually_exclusive_group()
+    source.add_argument("--ros", type=float, metavar="SECONDS", help="profile pico_node for this long")
+    source.add_argument("--port", help="serial port of LVGLProj_Soak")
+    parser.add_argument("--hz", type=int, default=2000)
+    parser.add_argument("--top", type=int, default=25)
+    parser.add_argument("--callers", type=int, default=0)
+    parser.add_argument("--lines", type=int, default=0)
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    parser.add_argument("--addr2line", default="arm-none-eabi-addr2line")
+    parser.add_argument("--json", help="write the flat profiles to this file")
+    args = parser.parse_args()
+
+    if args.ros:
+        hz, stats, pairs = from_ros(args.ros, args.hz)
+    elif args.port:
+        hz, stats, pairs = from_serial(args.port)
+    else:
+        hz, stats, pairs = parse_lines(sys.stdin)
+    if not pairs:
+        print("no samples", file=sys.stderr)
+        return 2
+
+    syms = Symbols(args.elf, args.nm)
+    print("%d Hz per core\n" % hz)
+    result = {}
+    for core in sorted(set(p[0] for p in pairs) | set(stats)):
+        core_pairs = [(pc, lr, c) for k, pc, lr, c in pairs if k == core]
+        result[core] = report(core, stats.get(core, {}), core_pairs, syms, args)
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"hz": hz, "cores": result}, f, indent=1)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
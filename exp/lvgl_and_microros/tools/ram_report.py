@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+"""
+RAM / flash budget report for the LVGLProj firmware.
+
+Parses the GNU ld map file written next to the ELF (<name>.elf.map) and
+attributes every input section to a subsystem by its object file. Prints a
+per-subsystem breakdown, optionally diffs it against a baseline and checks
+it against a budget. Exits with status 1 when a budget is exceeded, so the
+build fails.
+
+Subsystem budgets are the baseline plus the budget's margin_pct (at least
+margin_min bytes), so an intended change of size is accepted by
+rewriting the baseline from a real build, never by editing the budget.
+The budget's own "subsystems" entries are fixed caps that replace the
+derived ones, for subsystems the baseline build leaves out. Without a
+baseline only the totals are checked.
+
+  ram_report.py LVGLProj.elf.map [--baseline ram_baseline.json]
+                [--budget ram_budget.json] [--write-baseline FILE]
+                [--output report.txt]
+"""
+import argparse
+import json
+import re
+import sys
+
+# First match wins, patterns are tested against the object path. Objects of
+# the SDK's interface libraries are compiled into the executable's own
+# <target>.dir, under their source path, so app takes only the objects
+# directly in it (src/*.c) and anything deeper falls to the last sdk entry.
+SUBSYSTEMS = [
+    ("stacks",    None),   # .stack* sections, see classify()
+    ("heap",      None),   # .heap* sections
+    ("lvgl",      re.compile(r"liblvgl\.a|[/\\]lvgl[/\\]|lv_heap\.c")),
+    ("micro_ros", re.compile(r"libmicroros\.a|libmicro_ros\.a|uros_\w+\.c|pico_uart_transport\.c")),
+    ("freertos",  re.compile(r"FreeRTOS[-_]Kernel")),
+    ("sdk",       re.compile(r"pico-sdk|pico_sdk|tinyusb|libc_nano|libc\.a|libm\.a|libgcc|libnosys|crt\w*\.o|newlib")),
+    ("assets",    re.compile(r"ImageData\.c")),
+    ("drivers",   re.compile(r"[/\\](Config|LCD|Touch|QMI8658|PCF85063A)[/\\]|lib(Config|LCD|Touch|QMI8658|PCF85063A)\.a|DEV_Config|LCD_1in69\.c|CST816S|QMI8658\.c|PCF85063A\.c")),
+    ("debug",     re.compile(r"[/\\](profiler|trace)\.c")),   # LVGLPROJ_PROFILER / _TRACE
+    ("app",       re.compile(r"\.dir[/\\][^/\\]+\.c\.obj$")),
+    ("sdk",       re.compile(r"\.dir[/\\]")),
+]
+OTHER = "other"
+
+FLASH_REGIONS = ("FLASH",)
+RAM_REGIONS = ("RAM", "SCRATCH_X", "SCRATCH_Y")
+
+INPUT_ONE_LINE = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+INPUT_NAME_ONLY = re.compile(r"^ (\S+)$")
+INPUT_CONTINUED = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+OUTPUT_SECTION = re.compile(r"^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?)?\s*$")
+OUTPUT_CONTINUED = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?\s*$")
+REGION = re.compile(r"^(\w+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+
+
+def classify(section, obj):
+    if section.startswith(".stack"):
+        return "stacks"
+    if section.startswith(".heap"):
+        return "heap"
+    for name, pattern in SUBSYSTEMS:
+        if pattern is not None and pattern.search(obj):
+            return name
+    return OTHER
+
+
+def parse_map(path):
+    with open(path, errors="replace") as f:
+        lines = f.read().splitlines()
+
+    regions = {}
+    i = 0
+    while i < len(lines) and not lines[i].startswith("Memory Configuration"):
+        i += 1
+    while i < len(lines) and not lines[i].startswith("Linker script and memory map"):
+        m = REGION.match(lines[i])
+        if m and m.group(1) != "Name":
+            regions[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+        i += 1
+
+    def region_of(addr):
+        for name, (origin, length) in regions.items():
+            if origin <= addr < origin + length:
+                return name
+        return None
+
+    usage = {}
+
+    def add(subsystem, kind, size):
+        entry = usage.setdefault(subsystem, {"ram": 0, "flash": 0})
+        entry[kind] += size
+
+    loaded = False   # Current output section has a flash load address
+    pending = None
+    for line in lines[i:]:
+        m = OUTPUT_SECTION.match(line)
+        if m:
+            pending = None
+            if m.group(2) is not None:
+                loaded = m.group(4) is not None
+            else:
+                loaded = False
+            continue
+        m = OUTPUT_CONTINUED.match(line)
+        if m and pending is None:
+            loaded = m.group(3) is not None
+            continue
+
+        m = INPUT_ONE_LINE.match(line)
+        if m:
+            section, addr, size, obj = m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4)
+        elif pending is not None:
+            m = INPUT_CONTINUED.match(line)
+            section, pending = pending, None
+            if not m:
+                continue
+            addr, size, obj = int(m.group(1), 16), int(m.group(2), 16), m.group(3)
+        else:
+            m = INPUT_NAME_ONLY.match(line)
+            if m:
+                pending = m.group(1)
+            continue
+
+        if size == 0 or section == "*fill*":
+            continue
+        region = region_of(addr)
+        if region is None:
+            continue
+        subsystem = classify(section, obj)
+        if region in RAM_REGIONS:
+            add(subsystem, "ram", size)
+            if loaded:
+                add(subsystem, "flash", size)
+        elif region in FLASH_REGIONS:
+            add(subsystem, "flash", size)
+
+    ram_size = sum(regions[r][1] for r in RAM_REGIONS if r in regions)
+    flash_size = sum(regions[r][1] for r in FLASH_REGIONS if r in regions)
+    return usage, ram_size, flash_size
+
+
+def totals(usage):
+    return (sum(u["ram"] for u in usage.values()),
+            sum(u["flash"] for u in usage.values()))
+
+
+def fmt_diff(now, base):
+    if base is None:
+        return ""
+    d = now - base
+    return "%+d" % d if d else "="
+
+
+def report(usage, ram_size, flash_size, baseline):
+    ram, flash = totals(usage)
+    base = baseline.get("subsystems", {}) if baseline else {}
+    out = []
+    out.append("%-10s %10s %8s %10s %8s" % ("subsystem", "ram", "diff", "flash", "diff"))
+    for name in sorted(usage, key=lambda n: -usage[n]["ram"]):
+        u = usage[name]
+        b = base.get(name, {}) if baseline else None
+        out.append("%-10s %10d %8s %10d %8s" % (
+            name, u["ram"], fmt_diff(u["ram"], b.get("ram", 0) if b is not None else None),
+            u["flash"], fmt_diff(u["flash"], b.get("flash", 0) if b is not None else None)))
+    out.append("%-10s %10d %8s %10d %8s" % (
+        "total", ram, fmt_diff(ram, baseline.get("ram_total") if baseline else None),
+        flash, fmt_diff(flash, baseline.get("flash_total") if baseline else None)))
+    out.append("SRAM %d of %d bytes static, %d left for the newlib heap" % (ram, ram_size, ram_size - ram))
+    out.append("Flash %d of %d bytes" % (flash, flash_size))
+    return "\n".join(out)
+
+
+def subsystem_limits(budget, baseline):
+    """{name: {kind: limit}}, from the baseline and margin, then the fixed caps"""
+    limits = {}
+    if baseline:
+        pct = budget.get("margin_pct", 0)
+        least = budget.get("margin_min", 0)
+        for name, base in baseline.get("subsystems", {}).items():
+            limits[name] = {kind: base[kind] + max(base[kind] * pct // 100, least)
+                            for kind in ("ram", "flash") if kind in base}
+    for name, caps in budget.get("subsystems", {}).items():
+        limits[name] = dict(caps)
+    return limits
+
+
+def check_budget(usage, ram_size, budget, baseline):
+    ram, flash = totals(usage)
+    errors = []
+    if "ram_total" in budget and ram > budget["ram_total"]:
+        errors.append("static RAM %d exceeds budget %d" % (ram, budget["ram_total"]))
+    if "ram_free_min" in budget and ram_size - ram < budget["ram_free_min"]:
+        errors.append("free RAM %d below minimum %d" % (ram_size - ram, budget["ram_free_min"]))
+    if "flash_total" in budget and flash > budget["flash_total"]:
+        errors.append("flash %d exceeds budget %d" % (flash, budget["flash_total"]))
+    for name, limits in subsystem_limits(budget, baseline).items():
+        u = usage.get(name, {"ram": 0, "flash": 0})
+        for kind in ("ram", "flash"):
+            if kind in limits and u[kind] > limits[kind]:
+                errors.append("%s %s %d exceeds budget %d" % (name, kind, u[kind], limits[kind]))
+    return errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("map")
+    parser.add_argument("--baseline")
+    parser.add_argument("--budget")
+    parser.add_argument("--write-baseline")
+    parser.add_argument("--output")
+    args = parser.parse_args()
+
+    usage, ram_size, flash_size = parse_map(args.map)
+
+    baseline = None
+    if args.baseline:
+        try:
+            with open(args.baseline) as f:
+                baseline = json.load(f)
+        except FileNotFoundError:
+            print("ram_report: no baseline at %s, subsystem budgets not checked; "
+                  "write it with --write-baseline from a firmware build" % args.baseline)
+
+    text = report(usage, ram_size, flash_size, baseline)
+    print(text)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+
+    if args.write_baseline:
+        ram, flash = totals(usage)
+        with open(args.write_baseline, "w") as f:
+            json.dump({"ram_total": ram, "flash_total": flash, "subsystems": usage},
+                      f, indent=2, sort_keys=True)
+            f.write("\n")
+
+    if args.budget:
+        with open(args.budget) as f:
+            errors = check_budget(usage, ram_size, json.load(f), baseline)
+        for e in errors:
+            print("ram_report: error: %s" % e, file=sys.stderr)
+        if errors:
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
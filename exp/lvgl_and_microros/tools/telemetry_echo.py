@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""
+Print the pico_node performance telemetry (src/uros_telemetry.c) by field
+name. With the agent running and a ROS 2 environment sourced:
+
+  telemetry_echo.py [--topic telemetry] [--csv] [--check-allocs N]
+
+--check-allocs N runs until imu_published has grown by N and fails if
+ros_runtime_allocs is not 0: the publish path after uros_alloc_seal,
+rcl_publish included, must not allocate (src/uros_msgpool.h).
+
+The field names are read from the enum in src/uros_telemetry.h, so the
+script follows the firmware as fields are added. Messages whose layout
+label differs from the header's are reported and skipped.
+"""
+import argparse
+import os
+import re
+import sys
+
+import rclpy
+from rclpy.node import Node
+from rclpy.qos import qos_profile_sensor_data
+from std_msgs.msg import UInt32MultiArray
+
+HEADER = os.path.join(os.path.dirname(__file__), "..", "src", "uros_telemetry.h")
+
+
+def load_layout(path):
+    with open(path) as f:
+        text = f.read()
+    label = re.search(r'#define\s+UROS_TELEMETRY_LAYOUT\s+"([^"]+)"', text).group(1)
+    body = re.search(r"typedef enum \{(.*?)\} uros_telemetry_field_t;", text, re.S).group(1)
+    fields = re.findall(r"UROS_TELEMETRY_(\w+)", body)
+    return label, [f.lower() for f in fields if f != "FIELDS"]
+
+
+class TelemetryEcho(Node):
+    def __init__(self, topic, label, fields, csv, check_allocs):
+        super().__init__("telemetry_echo")
+        self.label = label
+        self.fields = fields
+        self.csv = csv
+        self.check_allocs = check_allocs
+        self.first_published = None
+        self.result = None
+        if csv:
+            print(",".join(fields))
+        self.create_subscription(UInt32MultiArray, topic, self.on_msg, qos_profile_sensor_data)
+
+    def on_msg(self, msg):
+        dims = msg.layout.dim
+        if not dims or dims[0].label != self.label:
+            self.get_logger().warning("unknown layout %r" % (dims[0].label if dims else None))
+            return
+        values = list(msg.data)[:len(self.fields)]
+        if self.csv:
+            print(",".join(str(v) for v in values))
+        else:
+            print("  ".join("%s=%d" % kv for kv in zip(self.fields, values)))
+        sys.stdout.flush()
+        if self.check_allocs:
+            self.check(dict(zip(self.fields, values)))
+
+    def check(self, v):
+        if v["ros_runtime_allocs"] != 0:
+            self.result = "ros_runtime_allocs %d after %d imu messages" % (
+                v["ros_runtime_allocs"], v["imu_published"])
+        elif self.first_published is None:
+            self.first_published = v["imu_published"]
+        elif v["imu_published"] - self.first_published >= self.check_allocs:
+            self.result = ""
+
+
+def main():
+    parser = argparse.ArgumentParser(description="pico_node telemetry")
+    parser.add_argument("--topic", default="telemetry")
+    parser.add_argument("--header", default=HEADER)
+    parser.add_argument("--csv", action="store_true")
+    parser.add_argument("--check-allocs", type=int, default=0, metavar="N",
+                        help="fail if micro-ROS allocates during N imu publishes")
+    args = parser.parse_args()
+
+    label, fields = load_layout(args.header)
+    rclpy.init()
+    node = TelemetryEcho(args.topic, label, fields, args.csv, args.check_allocs)
+    try:
+        while node.result is None:
+            rclpy.spin_once(node)
+    except KeyboardInterrupt:
+        pass
+    node.destroy_node()
+    rclpy.shutdown()
+    if node.result:
+        print("telemetry_echo: error: %s" % node.result, file=sys.stderr)
+        return 1
+    if node.result == "":
+        print("telemetry_echo: no runtime allocations over %d imu messages" % args.check_allocs)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""
+Convert the event trace of both cores (src/trace.h) to Chrome trace JSON,
+for ui.perfetto.dev or chrome://tracing. The dump comes from one of:
+
+  --ros           a LVGLProj built with LVGLPROJ_TRACE: sends "trace 0" on
+                  pico_param (src/uros_params.h), which freezes the rings,
+                  collects the dump on "trace" (src/uros_trace.h) and sends
+                  "trace 1"; needs the agent running and a ROS 2
+                  environment sourced
+  --port PORT     LVGLProj_Soak built with the trace: sends 't' and reads
+                  the TRACE lines it prints
+  otherwise       TRACE lines on stdin, e.g. a saved serial log
+
+  trace_export.py --ros [-o trace.json] [--no-trim] [--keep-dump dump.txt]
+
+Each core is a thread. Spans and instants are placed on the core that
+recorded them, the flush DMA is an async span from its start to the
+completion interrupt, and every doorbell rung on one core is joined by a
+flow arrow to the doorbell interrupt it raised on the other. The rings
+fill at different rates, so by default the timeline starts where both
+cores have events. A table of span counts and times is printed as well.
+"""
+import argparse
+import json
+import sys
+from collections import defaultdict
+
+PREFIX = "TRACE "
+DONE = "TRACE done"
+PID = 1
+
+
+def parse_lines(lines):
+    """Event names and {core: [(t_us, id, phase, arg)]} from TRACE lines"""
+    names, cores = {}, defaultdict(list)
+    for line in lines:
+        line = line.strip()
+        if line == DONE:
+            break
+        if not line.startswith(PREFIX):
+            continue
+        f = line[len(PREFIX):].split()
+        if f[0] == "event":
+            names[int(f[1])] = f[2]
+        elif f[0] == "core":
+            cores[int(f[1])]
+        elif f[0] != "events":
+            cores[int(f[0])].append((int(f[1], 16), int(f[2]), f[3], int(f[4])))
+    return names, cores
+
+
+def from_serial(port):
+    import serial
+    ser = serial.Serial(port, 115200, timeout=30)
+    ser.reset_input_buffer()
+    ser.write(b"t")
+
+    def lines():
+        while True:
+            raw = ser.readline()
+            if not raw:
+                raise TimeoutError("no trace on %s" % port)
+            yield raw.decode("ascii", "replace")
+    return list(lines_until_done(lines()))
+
+
+def lines_until_done(lines):
+    for line in lines:
+        yield line
+        if line.strip() == DONE:
+            return
+
+
+def from_ros():
+    import time
+    import rclpy
+    from rclpy.node import Node
+    from std_msgs.msg import String
+
+    class Collector(Node):
+        def __init__(self):
+            super().__init__("trace_export")
+            self.text = ""
+            self.done = False
+            self.create_subscription(String, "trace", self.on_trace, 100)
+            self.param = self.create_publisher(String, "pico_param", 10)
+
+        def set_trace(self, value):
+            # A command sent before pico_node subscribes would be lost
+            deadline = time.time() + 10
+            while self.param.get_subscription_count() == 0:
+                if time.time() > deadline:
+                    raise TimeoutError("pico_node is not subscribed to pico_param")
+                rclpy.spin_once(self, timeout_sec=0.1)
+            self.param.publish(String(data="trace %d" % value))
+
+        def on_trace(self, msg):
+            if msg.data.startswith(PREFIX + "events"):
+                self.text = ""  # A new dump
+            self.text += msg.data
+            self.done = (DONE + "\n") in msg.data
+
+    rclpy.init()
+    node = Collector()
+    try:
+        node.set_trace(0)
+        deadline = time.time() + 60
+        while not node.done and time.time() < deadline:
+            rclpy.spin_once(node, timeout_sec=0.5)
+        node.set_trace(1)
+    finally:
+        node.destroy_node()
+        rclpy.shutdown()
+    if not node.done:
+        raise TimeoutError("incomplete trace dump")
+    return node.text.splitlines()
+
+
+def to_chrome(names, cores, trim):
+    """Chrome trace events and per event span statistics"""
+    # Timer low words, relative to one reference so a wrap needs no care
+    ref = next(recs[-1][0] for recs in cores.values() if recs)
+
+    def rel(t):
+        return ((t - ref + 0x80000000) & 0xffffffff) - 0x80000000
+
+    start = max((rel(recs[0][0]) for recs in cores.values() if recs)) if trim else \
+        min((rel(recs[0][0]) for recs in cores.values() if recs))
+    events, stats = [], defaultdict(lambda: [0, 0, 0])
+    rings, irqs = [], []
+
+    for core, recs in sorted(cores.items()):
+        events.append({"name": "thread_name", "ph": "M", "pid": PID, "tid": core,
+                       "args": {"name": "core%d" % core}})
+        stack, open_async = [], {}
+        last = start
+        for t, ev, ph, arg in recs:
+            ts = rel(t)
+            if ts < start:
+                continue
+            last = ts
+            name = names.get(ev, "event_%d" % ev)
+            e = {"name": name, "ph": ph, "ts": ts - start, "pid": PID, "tid": core}
+            if ph == "B":
+                stack.append((ev, ts))
+            elif ph == "E":
+                # The ring may have lost the begin, or have no end yet
+                if not stack or stack[-1][0] != ev:
+                    continue
+                _, begin = stack.pop()
+                s = stats[(core, name)]
+                s[0] += 1
+                s[1] += ts - begin
+                s[2] = max(s[2], ts - begin)
+                e["args"] = {"arg": arg}
+            elif ph == "i":
+                e["s"] = "t"
+                e["args"] = {"arg": arg}
+                if name == "doorbell_ring":
+                    rings.append((ts, core, arg))
+                elif name == "doorbell_irq":
+                    irqs.append((ts, core, arg))
+            elif ph in "be":
+                e["cat"] = "async"
+                e["id"] = ev
+                e["args"] = {"arg": arg}
+                if ph == "b":
+                    open_async[ev] = ts
+                elif ev not in open_async:
+                    continue
+                else:
+                    s = stats[(core, name)]
+                    d = ts - open_async.pop(ev)
+                    s[0] += 1
+                    s[1] += d
+                    s[2] = max(s[2], d)
+            events.append(e)
+        for ev, _ in reversed(stack):
+            events.append({"name": names.get(ev, "event_%d" % ev), "ph": "E",
+                           "ts": last - start, "pid": PID, "tid": core})
+
+    # Doorbells: the first interrupt on the other core that has the bit set
+    irqs.sort()
+    flow = 0
+    for ts, core, channel in sorted(rings):
+        for its, icore, pending in irqs:
+            if its >= ts and icore != core and pending & (1 << channel):
+                flow += 1
+                common = {"name": "doorbell", "cat": "ipc", "id": flow, "pid": PID}
+                events.append(dict(common, ph="s", ts=ts - start, tid=core))
+                events.append(dict(common, ph="f", bp="e", ts=its - start, tid=icore))
+                break
+    return events, stats
+
+
+def main():
+    parser = argparse.ArgumentParser(description="LVGLProj trace to Chrome trace JSON")
+    source = parser.add_mutually_exclusive_group()
+    source.add_argument("--ros", action="store_true", help="freeze and collect the trace of pico_node")
+    source.add_argument("--port", help="serial port of LVGLProj_Soak")
+    parser.add_argument("-o", "--output", default="trace.json")
+    parser.add_argument("--no-trim", action="store_true", help="keep events from before both cores have some")
+    parser.add_argument("--keep-dump", help="also save the TRACE lines to this file")
+    args = parser.parse_args()
+
+    if args.ros:
+        lines = from_ros()
+    elif args.port:
+        lines = from_serial(args.port)
+    else:
+        lines = list(lines_until_done(sys.stdin))
+    if args.keep_dump:
+        with open(args.keep_dump, "w") as f:
+            f.writelines(l if l.endswith("\n") else l + "\n" for l in lines)
+
+    names, cores = parse_lines(lines)
+    if not any(cores.values()):
+        print("no events", file=sys.stderr)
+        return 2
+    events, stats = to_chrome(names, cores, not args.no_trim)
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, f)
+
+    print("%-6s %-18s %8s %12s %10s %10s" % ("core", "span", "count", "total us", "mean us", "max us"))
+    for (core, name), (n, total, longest) in sorted(stats.items()):
+        print("%-6d %-18s %8d %12d %10.1f %10d" % (core, name, n, total, total / n, longest))
+    print("%d events written to %s" % (len(events), args.output))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""
+Host side of the micro-ROS transport benchmark (src/transport_bench.c).
+
+Flash LVGLProj_TransportBench, then run
+
+  transport_bench.py /dev/ttyACM0
+
+to compare the per-byte stdio transport (S) with the TinyUSB CDC one (C).
+Requires pyserial.
+"""
+import argparse
+import os
+import statistics
+import time
+
+import serial
+
+BENCH_BYTES = 65536
+ECHO_BYTES = 32
+ECHO_COUNT = 1000
+
+
+def read_result(port):
+    line = port.readline().decode(errors="replace").split()
+    if len(line) != 5 or line[0] != "RESULT":
+        raise RuntimeError("unexpected reply %r" % line)
+    return int(line[3]), int(line[4])
+
+
+def bench_write(port, transport):
+    port.write(b"W" + transport)
+    start = time.perf_counter()
+    data = port.read(BENCH_BYTES)
+    host_s = time.perf_counter() - start
+    nbytes, dev_us = read_result(port)
+    return len(data), host_s, nbytes, dev_us
+
+
+def bench_read(port, transport):
+    port.write(b"R" + transport)
+    payload = os.urandom(BENCH_BYTES)
+    start = time.perf_counter()
+    port.write(payload)
+    port.flush()
+    nbytes, dev_us = read_result(port)
+    host_s = time.perf_counter() - start
+    return BENCH_BYTES, host_s, nbytes, dev_us
+
+
+def bench_echo(port, transport):
+    port.write(b"E" + transport)
+    rtt = []
+    for _ in range(ECHO_COUNT):
+        packet = os.urandom(ECHO_BYTES)
+        start = time.perf_counter()
+        port.write(packet)
+        if port.read(ECHO_BYTES) != packet:
+            raise RuntimeError("echo mismatch")
+        rtt.append((time.perf_counter() - start) * 1e6)
+    read_result(port)
+    return rtt
+
+
+def main():
+    parser = argparse.ArgumentParser(description="micro-ROS transport benchmark")
+    parser.add_argument("port")
+    parser.add_argument("--transports", default="SC")
+    args = parser.parse_args()
+
+    with serial.Serial(args.port, timeout=5) as port:
+        port.reset_input_buffer()
+        print("%-3s %12s %12s %10s %10s %10s" % (
+            "tx", "dev->host", "host->dev", "rtt p50", "rtt p99", "rtt max"))
+        for t in args.transports.encode():
+            t = bytes([t])
+            n, host_s, _, _ = bench_write(port, t)
+            tx_kbs = n / host_s / 1024
+            n, host_s, dev_n, dev_us = bench_read(port, t)
+            rx_kbs = dev_n / (dev_us / 1e6) / 1024 if dev_us else 0
+            rtt = sorted(bench_echo(port, t))
+            print("%-3s %9.1f KB/s %9.1f KB/s %8.0f us %8.0f us %8.0f us" % (
+                t.decode(), tx_kbs, rx_kbs, statistics.median(rtt),
+                rtt[int(len(rtt) * 0.99) - 1], rtt[-1]))
+
+
+if __name__ == "__main__":
+    main()
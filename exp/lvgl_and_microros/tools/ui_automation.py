@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""
+Drive scripted UI runs on pico_node through injected input (src/uros_input.h)
+and report the frame timings from its telemetry. With the agent running and
+a ROS 2 environment sourced:
+
+  ui_automation.py [tiles|slider|keys] [--repeat 5] [--json]
+
+Every gesture is sent as one ui_input message with its own timing, so the
+device replays it the same way whatever the link latency. A run starts by
+swiping back to tile1, waits for the screen to settle, plays the scenario
+--repeat times and then sums the telemetry intervals that fall in it:
+frames, the worst per-interval p50/p99, the longest frame and how late the
+injected events were applied. --json prints one line per run for trend
+tracking.
+
+Coordinates are given on the rotated screen as seen (SCREEN_W x SCREEN_H)
+and sent in panel coordinates, like the touch controller reports them.
+"""
+import argparse
+import json
+import os
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(__file__))
+from telemetry_echo import HEADER, load_layout  # noqa: E402
+
+SCREEN_W = 280
+SCREEN_H = 240
+PANEL_H = 280           # DISP_VER_RES, the display is rotated by 90 degrees
+
+PRESS, RELEASE, KEY, GESTURE = 0, 1, 2, 3    # ipc_input_type_t
+GESTURE_UP, GESTURE_DOWN = 1, 2               # CST816S_Gesture_*, any swipe
+KEY_RIGHT, KEY_LEFT, KEY_NEXT, KEY_PREV = 19, 20, 9, 11   # LV_KEY_*
+
+STEP_MS = 10            # Touch controller report interval
+SETTLE_S = 1.0
+TELEMETRY_S = 1.0       # UROS_TELEMETRY_MS
+
+
+def to_panel(x, y):
+    return int(y), int(PANEL_H - 1 - x)
+
+
+def drag(x0, y0, x1, y1, duration_ms, gesture=None, start_ms=0):
+    """Press at (x0, y0), move to (x1, y1) in duration_ms and release"""
+    events = []
+    if gesture is not None:
+        events.append((GESTURE, gesture, 0, start_ms))
+    steps = max(1, duration_ms // STEP_MS)
+    for i in range(steps + 1):
+        x = x0 + (x1 - x0) * i / steps
+        y = y0 + (y1 - y0) * i / steps
+        events.append((PRESS,) + to_panel(x, y) + (start_ms + i * STEP_MS,))
+    events.append((RELEASE, 0, 0, start_ms + steps * STEP_MS + STEP_MS))
+    return events
+
+
+def keys(codes, interval_ms=100):
+    return [(KEY, code, 0, i * interval_ms) for i, code in enumerate(codes)]
+
+
+def swipe_up():
+    """Next tile: the tiles are stacked vertically"""
+    return drag(SCREEN_W / 2, SCREEN_H - 40, SCREEN_W / 2, 40, 200, GESTURE_UP)
+
+
+def swipe_down():
+    return drag(SCREEN_W / 2, 40, SCREEN_W / 2, SCREEN_H - 40, 200, GESTURE_DOWN)
+
+
+# Slider on the BEEP tab of tile4, right of the switch
+SLIDER_X = SCREEN_W / 2 + 45
+SLIDER_TOP = 50 + 95 - 40
+SLIDER_BOTTOM = 50 + 95 + 40
+
+
+def scenario(name):
+    """(setup gestures, gestures of one repetition)"""
+    if name == "tiles":
+        return [], [swipe_up()] * 3 + [swipe_down()] * 3
+    if name == "slider":
+        return [swipe_up()] * 3, [
+            drag(SLIDER_X, SLIDER_BOTTOM, SLIDER_X, SLIDER_TOP, 500),
+            drag(SLIDER_X, SLIDER_TOP, SLIDER_X, SLIDER_BOTTOM, 500),
+        ]
+    if name == "keys":
+        # Focus the slider and step it both ways
+        return [swipe_up()] * 3, [keys([KEY_NEXT, KEY_PREV] + [KEY_RIGHT] * 10 + [KEY_LEFT] * 10)]
+    raise ValueError(name)
+
+
+def duration_s(events):
+    return (events[-1][3] if events else 0) / 1000.0
+
+
+def summarize(samples, fields):
+    rows = [dict(zip(fields, values)) for _, values in samples]
+    if not rows:
+        return {}
+    return {
+        "intervals": len(rows),
+        "frames": sum(r["frames"] for r in rows),
+        "frame_us_p50": max(r["frame_us_p50"] for r in rows),
+        "frame_us_p99": max(r["frame_us_p99"] for r in rows),
+        "frame_us_max": max(r["frame_us_max"] for r in rows),
+        "cpu1_load_pct": max(r["cpu1_load_pct"] for r in rows),
+        "input_events": rows[-1]["input_events"] - rows[0]["input_events"],
+        "input_late_us_max": max(r["input_late_us_max"] for r in rows),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="pico_node UI automation")
+    parser.add_argument("scenario", nargs="?", default="tiles", choices=("tiles", "slider", "keys"))
+    parser.add_argument("--repeat", type=int, default=5)
+    parser.add_argument("--topic", default="ui_input")
+    parser.add_argument("--telemetry", default="telemetry")
+    parser.add_argument("--header", default=HEADER)
+    parser.add_argument("--json", action="store_true")
+    args = parser.parse_args()
+
+    import rclpy
+    from rclpy.node import Node
+    from rclpy.qos import qos_profile_sensor_data
+    from std_msgs.msg import Int32MultiArray, UInt32MultiArray
+
+    label, fields = load_layout(args.header)
+    samples = []
+
+    class Automation(Node):
+        def __init__(self):
+            super().__init__("ui_automation")
+            self.pub = self.create_publisher(Int32MultiArray, args.topic, 10)
+            self.create_subscription(UInt32MultiArray, args.telemetry, self.on_telemetry,
+                                     qos_profile_sensor_data)
+
+        def on_telemetry(self, msg):
+            dims = msg.layout.dim
+            if dims and dims[0].label == label:
+                samples.append((time.monotonic(), list(msg.data)))
+
+        def send(self, events):
+            msg = Int32MultiArray()
+            msg.data = [v for e in events for v in e]
+            self.pub.publish(msg)
+
+        def wait(self, seconds):
+            end = time.monotonic() + seconds
+            while time.monotonic() < end:
+                rclpy.spin_once(self, timeout_sec=0.01)
+
+        def play(self, gestures):
+            for events in gestures:
+                self.send(events)
+                self.wait(duration_s(events) + 0.3)
+
+    rclpy.init()
+    node = Automation()
+    try:
+        node.wait(0.5)   # Discovery
+        setup, repetition = scenario(args.scenario)
+        node.play([swipe_down()] * 3 + setup)
+        node.wait(SETTLE_S)
+
+        start = time.monotonic()
+        for _ in range(args.repeat):
+            node.play(repetition)
+        end = time.monotonic()
+        node.wait(TELEMETRY_S + 0.5)
+
+        # Intervals that end inside the run, plus the one covering its end
+        run = [s for s in samples if start + TELEMETRY_S <= s[0] <= end + TELEMETRY_S]
+        result = dict(scenario=args.scenario, repeat=args.repeat,
+                      seconds=round(end - start, 3), **summarize(run, fields))
+        if args.json:
+            print(json.dumps(result))
+        else:
+            print("  ".join("%s=%s" % kv for kv in result.items()))
+        if not run:
+            print("no telemetry received on %r" % args.telemetry, file=sys.stderr)
+    except KeyboardInterrupt:
+        pass
+    node.destroy_node()
+    rclpy.shutdown()
+
+
+if __name__ == "__main__":
+    main()